@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""
+Block frames at the forwarder (op 0xA2, see flexray_frame_id_matcher.h):
+the PIO frame ID matcher looks up each frame's ID in a per-direction bitmap
+while the header streams in, and the forwarder holds TXD recessive for the
+rest of a blocked frame. The ECU on the other side sees a truncated frame in
+place of the blocked one.
+
+Directions: to-ecu blocks frames from the vehicle, to-vehicle blocks frames
+from the ECU.
+
+Usage:
+  python3 flexray_block.py block --dir to-ecu --ids 0x47,0x50-0x58
+  python3 flexray_block.py unblock --dir to-ecu --ids 0x47
+  python3 flexray_block.py clear
+  python3 flexray_block.py show
+"""
+import argparse
+import struct
+import sys
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+EP_VENDOR_OUT = 0x03
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_BLOCK = 0x76
+OP_SET_BLOCK = 0xA2
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+
+DIRECTIONS = {"to-ecu": 0, "to-vehicle": 1}  # INJECT_DIRECTION_*
+BLOCK_STATS = struct.Struct("<B3xIIIIHH")   # see matcher_block_stats_t
+BITMAP_BYTES = 256
+CHUNK = 56  # bitmap bytes per op, one op per 64-byte packet
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def parse_ids(text):
+    ids = set()
+    for part in text.split(","):
+        if "-" in part:
+            lo, hi = (int(v, 0) for v in part.split("-", 1))
+            ids.update(range(lo, hi + 1))
+        elif part:
+            ids.add(int(part, 0))
+    if any(i < 1 or i > 2047 for i in ids):
+        raise ValueError("frame IDs are 1..2047")
+    return ids
+
+
+def read_state(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_BLOCK, 0, 0,
+                                  BLOCK_STATS.size + 2 * BITMAP_BYTES))
+    stats = BLOCK_STATS.unpack_from(raw, 0)
+    maps = [bytearray(raw[BLOCK_STATS.size + d * BITMAP_BYTES:BLOCK_STATS.size + (d + 1) * BITMAP_BYTES])
+            for d in range(2)]
+    return stats, maps
+
+
+def write_bitmap(dev, direction, bitmap):
+    for first in range(0, BITMAP_BYTES, CHUNK):
+        chunk = bytes(bitmap[first:first + CHUNK])
+        dev.write(EP_VENDOR_OUT, struct.pack("<BBBB", OP_SET_BLOCK, direction, first, len(chunk)) + chunk,
+                  timeout=1000)
+
+
+def show(dev):
+    (attached, blocked_ecu, blocked_veh, missed_ecu, missed_veh, last_ecu, last_veh), maps = read_state(dev)
+    if not attached:
+        print("forwarder not attached: blocking is not live")
+    counters = {0: (blocked_ecu, missed_ecu, last_ecu), 1: (blocked_veh, missed_veh, last_veh)}
+    for name, d in DIRECTIONS.items():
+        ids = [i for i in range(BITMAP_BYTES * 8) if (maps[d][i >> 3] >> (i & 7)) & 1]
+        blocked, missed, last = counters[d]
+        listed = ",".join(f"0x{i:X}" for i in ids) or "-"
+        print(f"{name}: blocked {blocked} missed {missed} last 0x{last:X} ids {listed}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Frame blocking at the forwarder")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    for name in ("block", "unblock"):
+        p = sub.add_parser(name)
+        p.add_argument("--dir", choices=DIRECTIONS, required=True)
+        p.add_argument("--ids", required=True, help="comma-separated IDs or ranges, e.g. 0x47,0x50-0x58")
+    sub.add_parser("clear", help="unblock everything")
+    sub.add_parser("show", help="bitmaps and counters")
+    args = parser.parse_args()
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+    if args.cmd == "show":
+        show(dev)
+        return 0
+    if args.cmd == "clear":
+        for d in DIRECTIONS.values():
+            write_bitmap(dev, d, bytearray(BITMAP_BYTES))
+        return 0
+    try:
+        ids = parse_ids(args.ids)
+    except ValueError as e:
+        print(f"{e}", file=sys.stderr)
+        return 2
+    d = DIRECTIONS[args.dir]
+    _, maps = read_state(dev)
+    for i in ids:
+        if args.cmd == "block":
+            maps[d][i >> 3] |= 1 << (i & 7)
+        else:
+            maps[d][i >> 3] &= ~(1 << (i & 7)) & 0xFF
+    write_bitmap(dev, d, maps[d])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,277 @@
+#!/usr/bin/env python3
+"""
+Compile DBC signals into device bit-field descriptors (op 0x9D, see
+flexray_signals.h) and set them by name (op 0x9E). The device packs the
+values into the rule's template and refreshes E2E and CRC at injection time,
+so the host sends only (signal_id, raw value) pairs, and only for signals
+that changed.
+
+Signal ids are the message's signals in DBC order, skipping the multiplexor
+and anything before the payload, so the same DBC always gives the same ids.
+The FlexRay DBCs in dbc/ carry the cycle count in a byte ahead of the
+payload; --dbc-byte-offset (default 1) removes it.
+
+Usage:
+  python3 flexray_dbc_signals.py compile                      # dbc/lateral.dbc, message ACC -> rule 0
+  python3 flexray_dbc_signals.py load --hold-ms 200           # signals expire 200 ms after the last update
+  python3 flexray_dbc_signals.py set steering_angle_req=12.5 TJA_ready=1
+  python3 flexray_dbc_signals.py set --keepalive 0.05 steering_angle_req=0
+  python3 flexray_dbc_signals.py release steering_angle_req   # or --all
+  python3 flexray_dbc_signals.py show
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+import time
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    usb = None
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+EP_VENDOR_OUT = 0x03
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_SIGNALS = 0x73
+OP_LOAD_SIGNALS = 0x9D
+OP_SET_SIGNALS = 0x9E
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+
+SIGNAL_DESC = struct.Struct("<BBBBB")       # see signal_desc_t (rule + gateway_field_t)
+SIGNALS_HEADER = struct.Struct("<BBHIII")   # see signals_header_t
+SIGNAL_STATE = struct.Struct("<BBBBI")      # see signal_state_t
+
+SIGNALS_MAX = 32
+SIGNAL_RELEASE = 0x80
+FIELD_LE = 0x01
+FIELD_SIGNED = 0x02
+DESCS_PER_OP = 11   # each op must fit one 64-byte packet
+PAIRS_PER_OP = 12
+
+DEFAULT_DBC = os.path.join(os.path.dirname(os.path.abspath(__file__)), "dbc", "lateral.dbc")
+
+BO_RE = re.compile(r"^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)")
+SG_RE = re.compile(r"^\s*SG_\s+(\w+)\s*(M|m\d+)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*\(([^,]+),([^)]+)\)\s*\[([^|]*)\|([^\]]*)\]")
+
+
+class Signal:
+    def __init__(self, name, start, size, little_endian, signed, factor, offset, minimum, maximum):
+        self.name = name
+        self.start = start
+        self.size = size
+        self.little_endian = little_endian
+        self.signed = signed
+        self.factor = factor
+        self.offset = offset
+        self.minimum = minimum
+        self.maximum = maximum
+        self.id = None
+        self.field = None   # (byte_offset, start_bit, bits, flags)
+
+    def to_raw(self, physical):
+        raw = int(round((physical - self.offset) / self.factor))
+        lo, hi = (-(1 << (self.size - 1)), (1 << (self.size - 1)) - 1) if self.signed else (0, (1 << self.size) - 1)
+        if not lo <= raw <= hi:
+            raise ValueError(f"{self.name}={physical} is raw {raw}, outside {lo}..{hi}")
+        return raw & 0xFFFFFFFF
+
+
+def parse_dbc(path, message):
+    signals, in_msg, found = [], False, False
+    with open(path) as fh:
+        for line in fh:
+            m = BO_RE.match(line)
+            if m:
+                in_msg = m.group(2) == message or (message[:1].isdigit() and int(m.group(1)) == int(message, 0))
+                found = found or in_msg
+                continue
+            if not in_msg:
+                continue
+            m = SG_RE.match(line)
+            if not m:
+                continue
+            name, mux, start, size, order, sign, factor, offset, lo, hi = m.groups()
+            if mux == "M":
+                continue  # multiplexor: the cycle count, not in the payload
+            signals.append(Signal(name, int(start), int(size), order == "1", sign == "-",
+                                  float(factor), float(offset), float(lo or 0), float(hi or 0)))
+    if not found:
+        raise ValueError(f"message {message} not in {path}")
+    return signals
+
+
+def field_of(sig, byte_offset):
+    """DBC bit numbering -> (payload byte, start_bit in window, bits, flags), see gateway_field_t"""
+    if sig.little_endian:
+        first = sig.start // 8
+        start_bit = sig.start % 8
+        nbytes = (start_bit + sig.size + 7) // 8
+        flags = FIELD_LE
+    else:
+        # Motorola: start is the MSB; count bits big-endian from byte 0 bit 7
+        msb = (sig.start // 8) * 8 + (7 - sig.start % 8)
+        lsb = msb + sig.size - 1
+        first, last = msb // 8, lsb // 8
+        nbytes = last - first + 1
+        start_bit = 7 - lsb % 8
+        flags = 0
+    if nbytes > 4:
+        raise ValueError(f"{sig.name} spans {nbytes} bytes, the device takes 4")
+    if sig.signed:
+        flags |= FIELD_SIGNED
+    return (first - byte_offset, start_bit, sig.size, flags)
+
+
+def compile_signals(path, message, byte_offset):
+    out = []
+    for sig in parse_dbc(path, message):
+        if sig.start // 8 < byte_offset:
+            continue  # lives in the bytes ahead of the payload
+        sig.field = field_of(sig, byte_offset)
+        sig.id = len(out)
+        out.append(sig)
+    if len(out) > SIGNALS_MAX:
+        raise ValueError(f"{len(out)} signals, the device holds {SIGNALS_MAX}")
+    return out
+
+
+def find_device():
+    if usb is None:
+        print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+        return None
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def load_ops(signals, rule, hold_ms):
+    descs = [SIGNAL_DESC.pack(rule, *s.field) for s in signals]
+    descs += [bytes(SIGNAL_DESC.size)] * (SIGNALS_MAX - len(descs))  # clear the rest
+    return [struct.pack("<BBBH", OP_LOAD_SIGNALS, first, len(descs[first:first + DESCS_PER_OP]), hold_ms) +
+            b"".join(descs[first:first + DESCS_PER_OP])
+            for first in range(0, SIGNALS_MAX, DESCS_PER_OP)]
+
+
+def set_ops(pairs):
+    """pairs: [(signal_id, raw)]; each op is applied atomically on the device"""
+    if not pairs:
+        return [struct.pack("<BB", OP_SET_SIGNALS, 0)]
+    ops = []
+    for i in range(0, len(pairs), PAIRS_PER_OP):
+        chunk = pairs[i:i + PAIRS_PER_OP]
+        ops.append(struct.pack("<BB", OP_SET_SIGNALS, len(chunk)) +
+                   b"".join(struct.pack("<BI", sid, raw) for sid, raw in chunk))
+    return ops
+
+
+def read_state(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_SIGNALS, 0, 0,
+                                  SIGNALS_HEADER.size + SIGNALS_MAX * SIGNAL_STATE.size))
+    hdr = dict(zip(('count', 'entry_size', 'hold_ms', 'pairs', 'rejected', 'injections'),
+                   SIGNALS_HEADER.unpack_from(raw, 0)))
+    rows = []
+    for i in range(hdr['count']):
+        off = SIGNALS_HEADER.size + i * hdr['entry_size']
+        rows.append(dict(zip(('signal_id', 'rule', 'active', 'reserved', 'raw_value'),
+                             SIGNAL_STATE.unpack_from(raw, off))))
+    return hdr, rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description="DBC-compiled signal overrides")
+    parser.add_argument("--dbc", default=DEFAULT_DBC)
+    parser.add_argument("--message", default="ACC", help="message name or id")
+    parser.add_argument("--rule", type=int, default=0, help="injection rule whose target is this message")
+    parser.add_argument("--dbc-byte-offset", type=int, default=1, help="DBC bytes ahead of payload byte 0")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    sub.add_parser("compile", help="print the descriptor table")
+    p = sub.add_parser("load", help="upload the descriptors")
+    p.add_argument("--hold-ms", type=int, default=0, help="expire signals this long after the last update (0 = never)")
+    p = sub.add_parser("set", help="set signals, name=value (physical) or name=#raw")
+    p.add_argument("assignments", nargs="*")
+    p.add_argument("--keepalive", type=float, default=0.0, help="then send keepalives every N seconds until Ctrl-C")
+    p = sub.add_parser("release", help="stop overriding signals")
+    p.add_argument("names", nargs="*")
+    p.add_argument("--all", action="store_true")
+    sub.add_parser("show", help="device signal state")
+    args = parser.parse_args()
+
+    try:
+        signals = compile_signals(args.dbc, args.message, args.dbc_byte_offset)
+        by_name = {s.name: s for s in signals}
+        ops = []
+        if args.cmd == "compile":
+            for s in signals:
+                byte, bit, bits, flags = s.field
+                order = "le" if flags & FIELD_LE else "be"
+                sign = "s" if flags & FIELD_SIGNED else "u"
+                print(f"{s.id:2d} {s.name:36s} byte {byte:3d} bit {bit:2d} {sign}{bits:<2d} {order}  "
+                      f"x{s.factor:g} {s.offset:+g}")
+            return 0
+        if args.cmd == "load":
+            ops = load_ops(signals, args.rule, args.hold_ms)
+        elif args.cmd == "set":
+            pairs = []
+            for a in args.assignments:
+                name, _, value = a.partition("=")
+                sig = by_name[name]
+                raw = int(value[1:], 0) & 0xFFFFFFFF if value.startswith("#") else sig.to_raw(float(value))
+                pairs.append((sig.id, raw))
+            ops = set_ops(pairs)
+        elif args.cmd == "release":
+            names = list(by_name) if args.all else args.names
+            ops = set_ops([(by_name[n].id | SIGNAL_RELEASE, 0) for n in names])
+    except KeyError as e:
+        print(f"unknown signal {e}", file=sys.stderr)
+        return 2
+    except ValueError as e:
+        print(f"{e}", file=sys.stderr)
+        return 2
+
+    dev = find_device()
+    if dev is None:
+        return 1
+    if args.cmd == "show":
+        hdr, rows = read_state(dev)
+        names = {s.id: s for s in signals}
+        print(f"{hdr['count']} signals, hold {hdr['hold_ms']} ms, {hdr['pairs']} values received "
+              f"({hdr['rejected']} rejected), {hdr['injections']} injections")
+        for r in rows:
+            s = names.get(r['signal_id'])
+            if s is None:
+                continue
+            raw = r['raw_value']
+            if s.signed and raw & (1 << (s.size - 1)):
+                raw -= 1 << s.size
+            state = "active" if r['active'] else "idle  "
+            print(f"  {r['signal_id']:2d} {s.name:36s} {state} raw {raw} = {raw * s.factor + s.offset:g}")
+        return 0
+
+    for op in ops:
+        dev.write(EP_VENDOR_OUT, op, timeout=1000)
+    print(f"sent {len(ops)} op(s)")
+    if args.cmd == "set" and args.keepalive > 0:
+        try:
+            while True:
+                time.sleep(args.keepalive)
+                dev.write(EP_VENDOR_OUT, set_ops([])[0], timeout=1000)
+        except KeyboardInterrupt:
+            pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
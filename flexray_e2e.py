@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+Select the E2E profile an injection rule protects its frames with (op 0xA0,
+see flexray_e2e.h) and read the configuration back. The device advances the
+counter and recomputes the CRC of every injected frame; for Profile 1 the
+DataID part of the CRC is folded into per-counter seeds when the profile is
+set, so the injection path only runs over the payload.
+
+Profiles: rule (the trigger_rule_t e2e_* fields, default), none (frame CRC
+only), p01, p02, p05, p07.
+
+Usage:
+  python3 flexray_e2e.py set --rule 0 --profile p01 --mode both --data-id 0x1234 --offset 2 --length 8
+  python3 flexray_e2e.py set --rule 0 --profile p02 --data-id-list 0x10,0x11,...  # 16 values
+  python3 flexray_e2e.py set --rule 0 --profile p05 --data-id 0x0456 --offset 0 --length 16
+  python3 flexray_e2e.py set --rule 0 --profile rule
+  python3 flexray_e2e.py show
+"""
+import argparse
+import struct
+import sys
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+EP_VENDOR_OUT = 0x03
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_E2E = 0x74
+OP_SET_E2E = 0xA0
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+
+E2E_CONFIG = struct.Struct("<BBBBBBHI16s")  # see e2e_config_t
+
+PROFILES = {"rule": 0x00, "p01": 0x01, "p02": 0x02, "p05": 0x05, "p07": 0x07, "none": 0xFF}
+P01_MODES = {"both": 0, "alt": 1, "low": 2, "nibble": 3}
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def pack_config(args):
+    ids = [int(v, 0) for v in args.data_id_list.split(",")] if args.data_id_list else []
+    if ids and len(ids) != 16:
+        raise ValueError("--data-id-list takes 16 values, one per counter")
+    return E2E_CONFIG.pack(PROFILES[args.profile], P01_MODES[args.mode], args.offset, args.length,
+                           args.counter_bit, args.nibble_bit, 0, args.data_id & 0xFFFFFFFF, bytes(ids or 16))
+
+
+def show(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_E2E, 0, 0, 256))
+    names = {v: k for k, v in PROFILES.items()}
+    modes = {v: k for k, v in P01_MODES.items()}
+    for rule in range(len(raw) // E2E_CONFIG.size):
+        profile, mode, offset, length, counter_bit, nibble_bit, rejected, data_id, id_list = \
+            E2E_CONFIG.unpack_from(raw, rule * E2E_CONFIG.size)
+        name = names.get(profile, f"0x{profile:02X}")
+        line = f"rule {rule}: {name}"
+        if profile not in (PROFILES["rule"], PROFILES["none"]):
+            line += f" offset {offset} length {length or 'rest'}"
+        if profile == PROFILES["p01"]:
+            line += f" mode {modes.get(mode, mode)} data_id 0x{data_id:04X} counter_bit {counter_bit}"
+            if mode == P01_MODES["nibble"]:
+                line += f" nibble_bit {nibble_bit}"
+        elif profile == PROFILES["p02"]:
+            line += " data_id_list " + ",".join(f"0x{b:02X}" for b in id_list)
+        elif profile in (PROFILES["p05"], PROFILES["p07"]):
+            line += f" data_id 0x{data_id:X}"
+        if rejected:
+            line += f" ({rejected} injection(s) with an E2E area that did not fit)"
+        print(line)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Per-rule E2E profiles")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("set", help="select a rule's E2E profile")
+    p.add_argument("--rule", type=int, default=0)
+    p.add_argument("--profile", choices=PROFILES, required=True)
+    p.add_argument("--mode", choices=P01_MODES, default="both", help="P01 DataID mode")
+    p.add_argument("--data-id", type=lambda s: int(s, 0), default=0)
+    p.add_argument("--data-id-list", default="", help="P02: 16 comma-separated DataIDs")
+    p.add_argument("--offset", type=int, default=0, help="payload byte of the E2E header")
+    p.add_argument("--length", type=int, default=0, help="E2E area bytes, 0 = rest of the payload")
+    p.add_argument("--counter-bit", type=int, default=8, help="P01 counter bit offset")
+    p.add_argument("--nibble-bit", type=int, default=12, help="P01 NIBBLE DataID bit offset")
+    sub.add_parser("show", help="read the per-rule configuration")
+    args = parser.parse_args()
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+    if args.cmd == "show":
+        show(dev)
+        return 0
+    try:
+        op = struct.pack("<BB", OP_SET_E2E, args.rule) + pack_config(args)
+    except ValueError as e:
+        print(f"{e}", file=sys.stderr)
+        return 2
+    dev.write(EP_VENDOR_OUT, op, timeout=1000)
+    print("sent; a rejected configuration is reported as telemetry error 7 (arg1 0x100 = busy, resend)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Put an injection rule in early trigger mode (op 0xA3, see
+flexray_forwarder_with_injector.h) and read the per-rule counters. In early
+mode the frame ID matcher flags the trigger ID while the trigger frame's
+header streams in, the target is composed then, and the trigger frame end
+only starts the DMA.
+
+Usage:
+  python3 flexray_early_trigger.py set --rule 0 --enable
+  python3 flexray_early_trigger.py set --rule 0 --disable
+  python3 flexray_early_trigger.py show
+"""
+import argparse
+import struct
+import sys
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+EP_VENDOR_OUT = 0x03
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_EARLY_TRIGGER = 0x77
+OP_SET_EARLY = 0xA3
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+
+EARLY_STATS = struct.Struct("<B3xIIIII")  # see injector_early_stats_t
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def show(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_EARLY_TRIGGER, 0, 0, 256))
+    for rule in range(len(raw) // EARLY_STATS.size):
+        enabled, seen, prepared, fired, mispredicted, rejected = EARLY_STATS.unpack_from(raw, rule * EARLY_STATS.size)
+        print(f"rule {rule}: {'early' if enabled else 'frame end'} seen {seen} prepared {prepared} "
+              f"fired {fired} mispredicted {mispredicted} rejected {rejected}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Early trigger mode per injection rule")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("set", help="enable or disable a rule's early mode")
+    p.add_argument("--rule", type=int, default=0)
+    mode = p.add_mutually_exclusive_group(required=True)
+    mode.add_argument("--enable", action="store_true")
+    mode.add_argument("--disable", action="store_true")
+    sub.add_parser("show", help="read the per-rule counters")
+    args = parser.parse_args()
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+    if args.cmd == "show":
+        show(dev)
+        return 0
+    dev.write(EP_VENDOR_OUT, struct.pack("<BBB", OP_SET_EARLY, args.rule, 1 if args.enable else 0), timeout=1000)
+    print("sent; an unknown rule is reported as telemetry error 10")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""
+Configure the device-side stream filter and FIFO priority classes
+(bulk OUT ops 0x92/0x93/0x94 and 0x97/0x98, see panda_usb.c).
+
+Usage:
+  python3 flexray_filter.py --reset                       # stream everything again
+  python3 flexray_filter.py --only 0x40,0x41,0x5a         # allowlist, both directions
+  python3 flexray_filter.py --only 0x40 --dir ecu         # allowlist, ECU side only
+  python3 flexray_filter.py --rule 0x40:ecu,veh:0x03:0x01:16
+        # id:dirs:cycle_mask:cycle_base:decimation -> id 0x40, cycles 1,5,9..., and of
+        # those only cycles 1,17,33,49 (cycle_count % 16 == cycle_base % 16)
+  python3 flexray_filter.py --reset --drop-null           # stream everything except null frames
+  python3 flexray_filter.py --priority 0x47:control --priority 0x30:bulk
+        # under USB back-pressure bulk IDs are shed first, then normal (the default);
+        # injector IDs default to control, which only helps once --reserve gives it slots
+  python3 flexray_filter.py --reserve 64:32               # FIFO slots kept for normal:control
+"""
+import argparse
+import struct
+import sys
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+EP_VENDOR_OUT = 0x03
+
+OP_FILTER_RESET = 0x92
+OP_FILTER_RULE = 0x93
+OP_FILTER_BITMAP = 0x94
+OP_QOS_CLASS = 0x97
+OP_QOS_RESERVE = 0x98
+
+QOS_CLASSES = {"bulk": 0, "normal": 1, "control": 2}
+
+DIR_ECU = 0x01
+DIR_VEHICLE = 0x02
+FLAG_DROP_NULL = 0x01
+MAX_FRAME_ID = 2048
+
+
+def parse_dirs(text):
+    mask = 0
+    for part in text.lower().split(","):
+        part = part.strip()
+        if part in ("ecu", "e"):
+            mask |= DIR_ECU
+        elif part in ("veh", "vehicle", "v"):
+            mask |= DIR_VEHICLE
+        elif part in ("all", "both"):
+            mask |= DIR_ECU | DIR_VEHICLE
+        elif part in ("none", ""):
+            pass
+        else:
+            raise argparse.ArgumentTypeError(f"unknown direction '{part}'")
+    return mask
+
+
+def build_reset(default_dirs, flags):
+    return struct.pack("<BBB", OP_FILTER_RESET, default_dirs, flags)
+
+
+def build_rule(frame_id, dirs, cycle_mask, cycle_base, decimation):
+    return struct.pack("<BHBBBB", OP_FILTER_RULE, frame_id, dirs, cycle_mask, cycle_base, decimation)
+
+
+def build_bitmap(ids, dirs, chunk_bytes=32):
+    # The device parses each OUT packet on its own, so keep every op inside one
+    # 64-byte packet: 32 bitmap bytes (256 IDs) per op.
+    bitmap = bytearray(MAX_FRAME_ID // 8)
+    for fid in ids:
+        bitmap[fid >> 3] |= 1 << (fid & 7)
+    ops = []
+    for start in range(0, len(bitmap), chunk_bytes):
+        chunk = bytes(bitmap[start:start + chunk_bytes])
+        ops.append(struct.pack("<BBHH", OP_FILTER_BITMAP, dirs, start * 8, len(chunk)) + chunk)
+    return ops
+
+
+def build_priority(spec):
+    fid_text, cls_text = spec.split(":")
+    cls = QOS_CLASSES[cls_text.lower()] if cls_text.lower() in QOS_CLASSES else int(cls_text, 0)
+    return struct.pack("<BHB", OP_QOS_CLASS, int(fid_text, 0), cls)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="pico-flexray stream filter setup")
+    parser.add_argument("--reset", action="store_true", help="stream all IDs in both directions")
+    parser.add_argument("--drop-null", action="store_true", help="drop null frames (applies with the reset)")
+    parser.add_argument("--only", type=str, default=None, help="comma separated allowlist of frame IDs")
+    parser.add_argument("--dir", type=parse_dirs, default=DIR_ECU | DIR_VEHICLE, help="directions for --only: ecu,veh")
+    parser.add_argument("--rule", action="append", default=[],
+                        help="id:dirs:cycle_mask:cycle_base:decimation (repeatable)")
+    parser.add_argument("--priority", action="append", default=[],
+                        help="id:class with class bulk/normal/control (repeatable)")
+    parser.add_argument("--reset-priority", action="store_true", help="restore default priority classes")
+    parser.add_argument("--reserve", type=str, default=None, help="normal:control FIFO slots reserved")
+    args = parser.parse_args()
+
+    ops = []
+    if args.reset or args.drop_null or args.only is not None:
+        default_dirs = 0 if args.only is not None else (DIR_ECU | DIR_VEHICLE)
+        ops.append(build_reset(default_dirs, FLAG_DROP_NULL if args.drop_null else 0))
+    if args.only is not None:
+        ids = [int(x, 0) for x in args.only.split(",") if x.strip()]
+        if any(fid < 0 or fid >= MAX_FRAME_ID for fid in ids):
+            print("frame IDs must be in 0..2047", file=sys.stderr)
+            return 2
+        ops.extend(build_bitmap(ids, args.dir))
+    for spec in args.rule:
+        fields = spec.split(":")
+        if len(fields) != 5:
+            print(f"bad --rule '{spec}'", file=sys.stderr)
+            return 2
+        ops.append(build_rule(int(fields[0], 0), parse_dirs(fields[1]),
+                              int(fields[2], 0), int(fields[3], 0), int(fields[4], 0)))
+    if args.reset_priority:
+        ops.append(struct.pack("<BHB", OP_QOS_CLASS, 0xFFFF, 0))
+    for spec in args.priority:
+        try:
+            ops.append(build_priority(spec))
+        except (ValueError, KeyError):
+            print(f"bad --priority '{spec}'", file=sys.stderr)
+            return 2
+    if args.reserve is not None:
+        normal, control = (int(x, 0) for x in args.reserve.split(":"))
+        ops.append(struct.pack("<BHH", OP_QOS_RESERVE, normal, control))
+    if not ops:
+        parser.print_help()
+        return 0
+
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+
+    for op in ops:
+        dev.write(EP_VENDOR_OUT, op, timeout=1000)
+    print(f"Sent {len(ops)} op(s)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
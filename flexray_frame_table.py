@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""
+Poll the device's latest-frame table (FLEXRAY_READ_FRAME_TABLE) and print
+the payloads that changed, without touching the bulk stream. It can run
+alongside flexray_stream_recorder.py or Cabana.
+
+Usage:
+  python3 flexray_frame_table.py                    # dump the table once
+  python3 flexray_frame_table.py --watch 0.2        # print changes every 200 ms
+  python3 flexray_frame_table.py --id 0x48 --watch 0.05
+  python3 flexray_frame_table.py --reset 0x3f       # clear; key on the full cycle count
+"""
+import argparse
+import struct
+import sys
+import time
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_FRAME_TABLE = 0x64
+FLEXRAY_RESET_FRAME_TABLE = 0x65
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+BM_REQUEST_TYPE_OUT_VENDOR_DEVICE = 0x40
+
+TABLE_HEADER = struct.Struct("<IHBB")     # table_seq, count, flags, reserved
+TABLE_ENTRY = struct.Struct("<IIHBBBB")   # seq, last_seen_us, frame_id, source, cycle, indicators, payload_len
+FLAG_MORE = 0x01
+FLAG_RESET = 0x02
+READ_SIZE = 2048
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def parse_reply(raw):
+    if len(raw) < TABLE_HEADER.size:
+        return 0, 0, []
+    table_seq, count, flags, _ = TABLE_HEADER.unpack_from(raw, 0)
+    entries = []
+    off = TABLE_HEADER.size
+    for _ in range(count):
+        seq, seen_us, frame_id, source, cycle, indicators, n = TABLE_ENTRY.unpack_from(raw, off)
+        off += TABLE_ENTRY.size
+        entries.append({
+            'seq': seq, 'last_seen_us': seen_us, 'frame_id': frame_id, 'source': source,
+            'cycle_count': cycle, 'indicators': indicators, 'payload': bytes(raw[off:off + n]),
+        })
+        off += n
+    return table_seq, flags, entries
+
+
+def read_changes(dev, since_seq):
+    """All entries changed after since_seq; pages until the device has no more."""
+    changes = []
+    reset = False
+    while True:
+        raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_FRAME_TABLE,
+                                      since_seq & 0xFFFF, (since_seq >> 16) & 0xFFFF, READ_SIZE))
+        table_seq, flags, entries = parse_reply(raw)
+        reset |= bool(flags & FLAG_RESET)
+        changes.extend(entries)
+        if entries:
+            since_seq = entries[-1]['seq']
+        if not (flags & FLAG_MORE) or not entries:
+            return table_seq, reset, changes
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="pico-flexray latest-frame table reader")
+    parser.add_argument("--watch", type=float, default=None, help="poll interval in seconds")
+    parser.add_argument("--id", type=lambda x: int(x, 0), action="append", default=None,
+                        help="only print this frame ID (repeatable)")
+    parser.add_argument("--reset", type=lambda x: int(x, 0), default=None, metavar="CYCLE_MUX_MASK",
+                        help="clear the table and set the cycle bits that are part of the key")
+    args = parser.parse_args()
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+
+    if args.reset is not None:
+        dev.ctrl_transfer(BM_REQUEST_TYPE_OUT_VENDOR_DEVICE, FLEXRAY_RESET_FRAME_TABLE, args.reset & 0x3F, 0, b"")
+        print(f"Frame table cleared, cycle mux mask 0x{args.reset & 0x3F:02x}")
+        if args.watch is None:
+            return 0
+
+    since = 0
+    try:
+        while True:
+            table_seq, reset, changes = read_changes(dev, since)
+            if reset:
+                print("[table was reset on the device]")
+            for e in changes:
+                if args.id and e['frame_id'] not in args.id:
+                    continue
+                src = "ecu" if e['source'] == 0 else "veh"
+                print(f"seq={e['seq']:<8} id=0x{e['frame_id']:03x} {src} cyc={e['cycle_count']:2d} "
+                      f"ind=0x{e['indicators']:02x} seen={e['last_seen_us'] / 1e6:.6f} {e['payload'].hex()}")
+            since = table_seq
+            if args.watch is None:
+                break
+            time.sleep(args.watch)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""
+Load a signal routing table into the device's gateway (op 0x9C, see
+flexray_gateway.h) and show its counters. Each route copies a signal from an
+observed frame into the target frame of an injection rule, scaled, offset and
+clamped, and the device refreshes E2E and CRC before injecting it. No host is
+needed once the table is loaded.
+
+Routes file (JSON list, at most 8 entries; index = position in the list):
+  [{"source_id": "0x47", "source": "ecu", "rule": 0,
+    "src": {"byte": 2, "start_bit": 0, "bits": 16, "signed": true},
+    "dst": {"byte": 6, "start_bit": 0, "bits": 16, "signed": true},
+    "scale": 1.0, "offset": 0, "min": -8000, "max": 8000}]
+Optional per route: "cycle_mask"/"cycle_base" (source cycles, default every
+cycle), "le" in a field for little-endian byte order.
+
+Usage:
+  python3 flexray_gateway.py load routes.json
+  python3 flexray_gateway.py clear
+  python3 flexray_gateway.py stats [--watch 1]
+"""
+import argparse
+import json
+import struct
+import sys
+import time
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+EP_VENDOR_OUT = 0x03
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_GATEWAY = 0x72
+OP_SET_ROUTE = 0x9C
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+
+GATEWAY_ROUTE = struct.Struct("<HBBBBH4s4siiii")  # see gateway_route_t
+GATEWAY_FIELD = struct.Struct("<BBBB")             # see gateway_field_t
+GATEWAY_STATS = struct.Struct("<BBBBIIIii")        # see gateway_stats_t
+
+MAX_ROUTES = 8
+FIELD_LE = 0x01
+FIELD_SIGNED = 0x02
+SOURCES = {"ecu": 0x01, "vehicle": 0x02, "both": 0x03}  # FILTER_DIR_*
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def _int(v):
+    return int(v, 0) if isinstance(v, str) else int(v)
+
+
+def pack_field(f):
+    flags = (FIELD_LE if f.get("le") else 0) | (FIELD_SIGNED if f.get("signed") else 0)
+    return GATEWAY_FIELD.pack(_int(f["byte"]), _int(f.get("start_bit", 0)), _int(f["bits"]), flags)
+
+
+def pack_route(r):
+    return GATEWAY_ROUTE.pack(
+        _int(r["source_id"]), SOURCES[r.get("source", "both")],
+        _int(r.get("cycle_mask", 0)), _int(r.get("cycle_base", 0)), _int(r["rule"]), 0,
+        pack_field(r["src"]), pack_field(r["dst"]),
+        int(round(float(r.get("scale", 1.0)) * 65536)), _int(r.get("offset", 0)),
+        _int(r.get("min", -0x80000000)), _int(r.get("max", 0x7FFFFFFF)))
+
+
+def disabled_route():
+    return bytes(GATEWAY_ROUTE.size)
+
+
+def send_routes(dev, packed):
+    """packed: list of MAX_ROUTES route blobs, index = position"""
+    # One op per transfer: the device parses each 64-byte packet on its own
+    for i, blob in enumerate(packed):
+        dev.write(EP_VENDOR_OUT, struct.pack("<BB", OP_SET_ROUTE, i) + blob, timeout=1000)
+
+
+def read_stats(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_GATEWAY, 0, 0,
+                                  MAX_ROUTES * GATEWAY_STATS.size))
+    return [dict(zip(('route', 'enabled', 'rule', 'reserved', 'updates', 'applied', 'clamped', 'last_in', 'last_out'),
+                     GATEWAY_STATS.unpack_from(raw, off)))
+            for off in range(0, len(raw) - GATEWAY_STATS.size + 1, GATEWAY_STATS.size)]
+
+
+def print_stats(rows):
+    for r in rows:
+        if not r['enabled']:
+            continue
+        print(f"route {r['route']} -> rule {r['rule']}: {r['updates']} updates, {r['applied']} injected, "
+              f"{r['clamped']} clamped, last {r['last_in']} -> {r['last_out']}")
+    if not any(r['enabled'] for r in rows):
+        print("no routes")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="On-device signal gateway")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("load", help="replace the routing table")
+    p.add_argument("routes", help="JSON routes file")
+    sub.add_parser("clear", help="disable every route")
+    p = sub.add_parser("stats", help="per-route counters")
+    p.add_argument("--watch", type=float, default=0.0, help="repeat every N seconds")
+    args = parser.parse_args()
+
+    packed = []
+    if args.cmd == "load":
+        with open(args.routes) as fh:
+            routes = json.load(fh)
+        if len(routes) > MAX_ROUTES:
+            print(f"{len(routes)} routes, the device holds {MAX_ROUTES}", file=sys.stderr)
+            return 2
+        try:
+            packed = [pack_route(r) for r in routes]
+        except (KeyError, ValueError, struct.error) as e:
+            print(f"bad route: {e}", file=sys.stderr)
+            return 2
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+    if args.cmd in ("load", "clear"):
+        send_routes(dev, packed + [disabled_route()] * (MAX_ROUTES - len(packed)))
+        print(f"{len(packed)} route(s) loaded (rejections show up as error code 5 in the stream recorder, arg1 0x100 = busy, resend)")
+        return 0
+
+    while True:
+        print_stats(read_stats(dev))
+        if args.watch <= 0:
+            return 0
+        time.sleep(args.watch)
+        print()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+Dump the device's per-ID traffic statistics (FLEXRAY_READ_ID_STATS): frame
+counts per direction, CRC failures, missed occurrences, interval range,
+cycle multiplexing pattern and the inter-arrival jitter histogram.
+
+Usage:
+  python3 flexray_id_stats.py                  # one table
+  python3 flexray_id_stats.py --watch 1        # refresh every second, flag IDs that went silent
+  python3 flexray_id_stats.py --reset          # clear on the device
+"""
+import argparse
+import struct
+import sys
+import time
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+
+# Panda request plus vendor extensions (see panda_usb.h)
+PANDA_GET_MICROSECOND_TIMER = 0xA8
+FLEXRAY_READ_ID_STATS = 0x66
+FLEXRAY_RESET_ID_STATS = 0x67
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+BM_REQUEST_TYPE_OUT_VENDOR_DEVICE = 0x40
+
+STATS_HEADER = struct.Struct("<HHHBB")  # total, first, count, entry_size, reserved
+JITTER_BINS = 8
+STATS_ENTRY = struct.Struct(f"<HBBIIIIIIIQ{JITTER_BINS}H")
+JITTER_LABELS = ["<2", "<4", "<8", "<16", "<32", "<64", "<128", ">=128"]
+READ_SIZE = 2048
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def read_all(dev):
+    entries = []
+    first = 0
+    while True:
+        raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_ID_STATS, first, 0, READ_SIZE))
+        if len(raw) < STATS_HEADER.size:
+            return entries
+        total, _, count, entry_size, _ = STATS_HEADER.unpack_from(raw, 0)
+        off = STATS_HEADER.size
+        for _ in range(count):
+            f = STATS_ENTRY.unpack_from(raw, off)
+            entries.append({
+                'frame_id': f[0], 'source': f[1], 'payload_words': f[2], 'frames': f[3],
+                'crc_fail': f[4], 'gaps': f[5], 'last_seen_us': f[6], 'last_interval_us': f[7],
+                'min_interval_us': f[8], 'max_interval_us': f[9], 'cycle_mask': f[10],
+                'jitter': list(f[11:11 + JITTER_BINS]),
+            })
+            off += entry_size
+        first += count
+        if count == 0 or first >= total:
+            return entries
+
+
+def cycle_pattern(mask):
+    """'base/repetition' for masks that repeat every 1, 2, 4 ... 64 cycles, else the raw mask."""
+    if mask == 0:
+        return "-"
+    for rep in (1, 2, 4, 8, 16, 32, 64):
+        bases = [c for c in range(rep) if (mask >> c) & 1]
+        expected = 0
+        for base in bases:
+            for c in range(base, 64, rep):
+                expected |= 1 << c
+        if expected == mask:
+            return "/".join(str(b) for b in bases) + f"%{rep}" if rep > 1 else "all"
+    return f"0x{mask:016x}"
+
+
+def device_time_us(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, PANDA_GET_MICROSECOND_TIMER, 0, 0, 4))
+    return struct.unpack("<I", raw)[0] if len(raw) == 4 else None
+
+
+def print_table(entries, now_us):
+    print(f"{'id':>5} {'src':>3} {'len':>3} {'frames':>9} {'crc':>6} {'gaps':>6} {'min_us':>8} {'max_us':>8} "
+          f"{'age_ms':>8} {'cycles':>12}  jitter " + " ".join(JITTER_LABELS))
+    for e in sorted(entries, key=lambda e: (e['frame_id'], e['source'])):
+        age = "" if now_us is None else f"{((now_us - e['last_seen_us']) & 0xFFFFFFFF) / 1000:.1f}"
+        period_known = e['min_interval_us'] > 0
+        print(f"0x{e['frame_id']:03x} {'veh' if e['source'] else 'ecu':>3} {e['payload_words'] * 2:>3} "
+              f"{e['frames']:>9} {e['crc_fail']:>6} {e['gaps']:>6} "
+              f"{e['min_interval_us'] if period_known else '-':>8} {e['max_interval_us'] if period_known else '-':>8} "
+              f"{age:>8} {cycle_pattern(e['cycle_mask']):>12}  " + " ".join(str(n) for n in e['jitter']))
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="pico-flexray per-ID traffic statistics")
+    parser.add_argument("--watch", type=float, default=None, help="refresh interval in seconds")
+    parser.add_argument("--reset", action="store_true", help="clear the statistics on the device")
+    args = parser.parse_args()
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+
+    if args.reset:
+        dev.ctrl_transfer(BM_REQUEST_TYPE_OUT_VENDOR_DEVICE, FLEXRAY_RESET_ID_STATS, 0, 0, b"")
+        print("ID statistics cleared")
+        return 0
+
+    prev_frames = {}
+    try:
+        while True:
+            now_us = device_time_us(dev)
+            entries = read_all(dev)
+            print_table(entries, now_us)
+            if prev_frames:
+                silent = [e for e in entries if prev_frames.get((e['frame_id'], e['source'])) == e['frames']]
+                for e in silent:
+                    print(f"!! 0x{e['frame_id']:03x} {'veh' if e['source'] else 'ecu'} went silent")
+            prev_frames = {(e['frame_id'], e['source']): e['frames'] for e in entries}
+            if args.watch is None:
+                break
+            time.sleep(args.watch)
+            print()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""
+Drain the device's deferred binary log over USB and print it.
+
+Message formats are taken from the FLEXRAY_LOG_MESSAGES table in
+src/flexray_log.h, so the reader always matches the firmware source tree.
+While this script runs the device stops pumping the log to its UART; it is
+switched back on exit.
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+import time
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_LOG = 0x62
+FLEXRAY_SET_LOG_SINK = 0x63
+LOG_SINK_UART = 0
+LOG_SINK_USB = 1
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+BM_REQUEST_TYPE_OUT_VENDOR_DEVICE = 0x40
+
+LOG_HEADER = struct.Struct("<IHBB")
+LOG_RECORD = struct.Struct("<HBBI6I")
+
+_DEFAULT_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "src", "flexray_log.h")
+_ENTRY_RE = re.compile(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+
+
+def load_formats(header_path: str):
+    """Return [(name, python_format)] in ID order."""
+    formats = []
+    with open(header_path, "r", encoding="utf-8") as f:
+        in_table = False
+        for line in f:
+            if "#define FLEXRAY_LOG_MESSAGES" in line:
+                in_table = True
+                continue
+            if not in_table:
+                continue
+            m = _ENTRY_RE.search(line)
+            if m:
+                fmt = m.group(2).encode().decode("unicode_escape").rstrip("\n")
+                formats.append((m.group(1), fmt))
+            if not line.rstrip().endswith("\\"):
+                break
+    return formats
+
+
+def decode_record(formats, rec_id, nargs, args):
+    if rec_id >= len(formats):
+        return f"<unknown log id {rec_id}> {list(args[:nargs])}"
+    name, fmt = formats[rec_id]
+    try:
+        # C length modifiers (%lu, %02lx) are accepted and ignored by Python
+        return fmt % tuple(args[:fmt.count("%") - 2 * fmt.count("%%")])
+    except (TypeError, ValueError):
+        return f"{name} {list(args[:nargs])}"
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def read_log(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_LOG, 0, 0, 4096))
+    if len(raw) < LOG_HEADER.size:
+        return 0, []
+    dropped, count, rec_size, _ = LOG_HEADER.unpack_from(raw, 0)
+    records = []
+    off = LOG_HEADER.size
+    for _ in range(count):
+        rec_id, nargs, core, ts, *args = LOG_RECORD.unpack_from(raw, off)
+        records.append((rec_id, nargs, core, ts, args))
+        off += rec_size
+    return dropped, records
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="pico-flexray deferred log reader")
+    parser.add_argument("--header", default=_DEFAULT_HEADER, help="path to flexray_log.h")
+    parser.add_argument("--interval", type=float, default=0.1, help="poll interval in seconds")
+    args = parser.parse_args()
+
+    formats = load_formats(args.header)
+    if not formats:
+        print(f"No FLEXRAY_LOG_MESSAGES table found in {args.header}", file=sys.stderr)
+        return 1
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+
+    dev.ctrl_transfer(BM_REQUEST_TYPE_OUT_VENDOR_DEVICE, FLEXRAY_SET_LOG_SINK, LOG_SINK_USB, 0, b"")
+    last_dropped = None
+    try:
+        while True:
+            dropped, records = read_log(dev)
+            if last_dropped is not None and dropped != last_dropped:
+                print(f"[log] {dropped - last_dropped} records dropped on device")
+            last_dropped = dropped
+            for rec_id, nargs, core, ts, rec_args in records:
+                print(f"{ts / 1e6:12.6f} c{core} {decode_record(formats, rec_id, nargs, rec_args)}")
+            if not records:
+                time.sleep(args.interval)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        try:
+            dev.ctrl_transfer(BM_REQUEST_TYPE_OUT_VENDOR_DEVICE, FLEXRAY_SET_LOG_SINK, LOG_SINK_UART, 0, b"")
+        except Exception:
+            pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+"""
+Compile content predicates for injection triggers and load them into the
+device (op 0x9B, see flexray_predicate.h). A rule with a predicate only fires
+when the payload of its trigger frame matches, e.g. only while a counter has a
+given value or when a signal crosses a threshold.
+
+Expressions are comparisons joined by 'and' / 'or' ('and' binds tighter, no
+parentheses). Fields are payload-relative, within the first 32 bytes:
+  u8[k] s8[k]                byte k
+  u16[k] s16[k]              bytes k, k+1 big-endian (FlexRay signal order)
+  u16le[k] s16le[k]          little-endian
+A field may be followed by '& mask' and '>> shift' in any order. Comparisons
+are == != < <= > >= against a constant, plus rises(field, v) / falls(field, v)
+for a threshold crossing since the last evaluation of that rule.
+
+Usage:
+  python3 flexray_predicate.py compile "u8[3] & 0x0f == 2"
+  python3 flexray_predicate.py load 0 "rises(s16[4], 100) or u8[0] == 0xff"
+  python3 flexray_predicate.py clear 0
+  python3 flexray_predicate.py stats [--reset]
+"""
+import argparse
+import re
+import struct
+import sys
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    usb = None
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+EP_VENDOR_OUT = 0x03
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_PREDICATE_STATS = 0x70
+FLEXRAY_RESET_PREDICATE_STATS = 0x71
+OP_LOAD_PREDICATE = 0x9B
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+BM_REQUEST_TYPE_OUT_VENDOR_DEVICE = 0x40
+
+PREDICATE_STATS = struct.Struct("<BBHIIII")  # see predicate_stats_t
+INSN = struct.Struct("<BBH")                 # see predicate_insn_t
+
+MAX_INSNS = 15
+WINDOW_BYTES = 32
+
+# predicate_op_t
+OP_LDB, OP_LDW, OP_LDWL, OP_AND, OP_SHR, OP_SEXT = 0x01, 0x02, 0x03, 0x04, 0x05, 0x06
+COMPARE_OPS = {"==": 0x10, "!=": 0x11, "<": 0x12, "<=": 0x13, ">": 0x14, ">=": 0x15}
+OP_RISE, OP_FALL, OP_OR = 0x18, 0x19, 0x1F
+IMM_SIGNED = 0x01
+
+FIELDS = {
+    # name: (load op, bits, signed)
+    "u8": (OP_LDB, 8, False), "s8": (OP_LDB, 8, True),
+    "u16": (OP_LDW, 16, False), "s16": (OP_LDW, 16, True),
+    "u16le": (OP_LDWL, 16, False), "s16le": (OP_LDWL, 16, True),
+}
+
+TOKEN = re.compile(r"\s*(?:(0x[0-9a-fA-F]+|-?\d+)|(==|!=|<=|>=|>>|<|>|&|\[|\]|\(|\)|,)|([A-Za-z_]\w*))")
+
+
+class PredicateError(ValueError):
+    pass
+
+
+def tokenize(text):
+    tokens = []
+    pos = 0
+    text = text.strip()
+    while pos < len(text):
+        m = TOKEN.match(text, pos)
+        if not m or m.end() == pos:
+            raise PredicateError(f"unexpected input at '{text[pos:]}'")
+        num, sym, word = m.groups()
+        tokens.append(int(num, 0) if num is not None else (sym or word.lower()))
+        pos = m.end()
+    return tokens
+
+
+class Parser:
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.pos = 0
+
+    def peek(self):
+        return self.tokens[self.pos] if self.pos < len(self.tokens) else None
+
+    def take(self, expected=None):
+        tok = self.peek()
+        if tok is None or (expected is not None and tok != expected):
+            raise PredicateError(f"expected {expected or 'more input'}, got {tok!r}")
+        self.pos += 1
+        return tok
+
+    def number(self):
+        tok = self.take()
+        if not isinstance(tok, int):
+            raise PredicateError(f"expected a number, got {tok!r}")
+        return tok
+
+    def value(self):
+        """field [& mask | >> shift]* -> list of instructions, signed flag"""
+        name = self.take()
+        if name not in FIELDS:
+            raise PredicateError(f"unknown field {name!r}")
+        load, bits, signed = FIELDS[name]
+        self.take("[")
+        offset = self.number()
+        self.take("]")
+        if offset < 0 or offset + bits // 8 > WINDOW_BYTES:
+            raise PredicateError(f"{name}[{offset}] is outside the first {WINDOW_BYTES} payload bytes")
+        code = [(load, offset, 0)]
+        width = bits
+        while self.peek() in ("&", ">>"):
+            op = self.take()
+            n = self.number()
+            if op == "&":
+                if not 0 <= n <= 0xFFFF:
+                    raise PredicateError(f"mask {n:#x} does not fit 16 bits")
+                code.append((OP_AND, 0, n))
+                width = min(width, n.bit_length())
+            else:
+                if not 0 <= n < bits:
+                    raise PredicateError(f"shift {n} out of range")
+                code.append((OP_SHR, n, 0))
+                width -= n
+        if signed and width < 32:
+            if width < 1:
+                raise PredicateError(f"nothing left of {name}[{offset}] to sign-extend")
+            code.append((OP_SEXT, width, 0))
+        return code, signed
+
+    def comparison(self):
+        """-> (is_crossing, instructions)"""
+        if self.peek() in ("rises", "falls"):
+            op = OP_RISE if self.take() == "rises" else OP_FALL
+            self.take("(")
+            code, signed = self.value()
+            self.take(",")
+            imm = self.number()
+            self.take(")")
+            return True, code + [compare(op, imm, signed)]
+        code, signed = self.value()
+        op = self.take()
+        if op not in COMPARE_OPS:
+            raise PredicateError(f"expected a comparison, got {op!r}")
+        return False, code + [compare(COMPARE_OPS[op], self.number(), signed)]
+
+    def clause(self):
+        # Crossings first: their history only updates when they run
+        parts = [self.comparison()]
+        while self.peek() == "and":
+            self.take()
+            parts.append(self.comparison())
+        parts.sort(key=lambda p: not p[0])
+        return [insn for _, code in parts for insn in code]
+
+    def program(self):
+        code = self.clause()
+        while self.peek() == "or":
+            self.take()
+            code.append((OP_OR, 0, 0))
+            code += self.clause()
+        if self.peek() is not None:
+            raise PredicateError(f"unexpected {self.peek()!r}")
+        return code
+
+
+def compare(op, imm, signed):
+    if signed:
+        if not -0x8000 <= imm <= 0x7FFF:
+            raise PredicateError(f"{imm} does not fit a signed 16-bit constant")
+        return (op, IMM_SIGNED, imm & 0xFFFF)
+    if not 0 <= imm <= 0xFFFF:
+        raise PredicateError(f"{imm} does not fit an unsigned 16-bit constant")
+    return (op, 0, imm)
+
+
+def compile_predicate(text):
+    code = Parser(tokenize(text)).program()
+    if len(code) > MAX_INSNS:
+        raise PredicateError(f"{len(code)} instructions, the device takes {MAX_INSNS}")
+    return b"".join(INSN.pack(*insn) for insn in code)
+
+
+def find_device():
+    if usb is None:
+        print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+        return None
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def load(dev, rule, program):
+    dev.write(EP_VENDOR_OUT, struct.pack("<BBB", OP_LOAD_PREDICATE, rule, len(program) // INSN.size) + program,
+              timeout=1000)
+
+
+def read_stats(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_PREDICATE_STATS, 0, 0, 256))
+    rows = []
+    for off in range(0, len(raw) - PREDICATE_STATS.size + 1, PREDICATE_STATS.size):
+        rows.append(dict(zip(('rule', 'insns', 'reserved', 'evals', 'passes', 'steps_max', 'steps_total'),
+                             PREDICATE_STATS.unpack_from(raw, off))))
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Content predicates for injection triggers")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("compile", help="print the bytecode of an expression")
+    p.add_argument("expr")
+    p = sub.add_parser("load", help="compile and load into a trigger rule")
+    p.add_argument("rule", type=int)
+    p.add_argument("expr")
+    p = sub.add_parser("clear", help="remove a rule's predicate")
+    p.add_argument("rule", type=int)
+    p = sub.add_parser("stats", help="evaluation counters per rule")
+    p.add_argument("--reset", action="store_true")
+    args = parser.parse_args()
+
+    program = b""
+    if args.cmd in ("compile", "load"):
+        try:
+            program = compile_predicate(args.expr)
+        except PredicateError as e:
+            print(f"bad predicate: {e}", file=sys.stderr)
+            return 2
+    if args.cmd == "compile":
+        for off in range(0, len(program), INSN.size):
+            op, a, imm = INSN.unpack_from(program, off)
+            print(f"{off // INSN.size:2d}: op 0x{op:02x} a {a:3d} imm 0x{imm:04x}")
+        return 0
+
+    dev = find_device()
+    if dev is None:
+        return 1
+    if args.cmd in ("load", "clear"):
+        load(dev, args.rule, program)
+        print(f"rule {args.rule}: {len(program) // INSN.size} instruction(s) loaded "
+              f"(rejections show up as error code 4 in the stream recorder, arg1 0xff = busy, retry)")
+        return 0
+
+    for r in read_stats(dev):
+        if not r['insns']:
+            print(f"rule {r['rule']}: no predicate")
+            continue
+        rate = 100.0 * r['passes'] / r['evals'] if r['evals'] else 0.0
+        avg = r['steps_total'] / r['evals'] if r['evals'] else 0.0
+        print(f"rule {r['rule']}: {r['insns']} insns, {r['evals']} evals, {r['passes']} passed ({rate:.1f}%), "
+              f"steps avg {avg:.1f} max {r['steps_max']}")
+    if args.reset:
+        dev.ctrl_transfer(BM_REQUEST_TYPE_OUT_VENDOR_DEVICE, FLEXRAY_RESET_PREDICATE_STATS, 0, 0, None)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
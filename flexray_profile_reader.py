@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+Read the hot-path cycle profile from the device (build with -DFLEXRAY_PROFILE=ON).
+
+Usage:
+  python3 flexray_profile_reader.py            # print once
+  python3 flexray_profile_reader.py --watch 2  # refresh every 2 seconds
+  python3 flexray_profile_reader.py --reset    # clear the counters first
+"""
+import argparse
+import struct
+import sys
+import time
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_GET_PROFILE_STATS = 0x60
+FLEXRAY_RESET_PROFILE_STATS = 0x61
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+BM_REQUEST_TYPE_OUT_VENDOR_DEVICE = 0x40
+
+# Order must match profile_probe_t in flexray_profile.h
+PROBE_NAMES = [
+    "streamer_irq0_handler",
+    "try_inject_frame",
+    "parse_loop",
+    "is_valid_frame",
+    "try_send_from_fifo",
+    "stream_codec_encode",
+    "predicate_eval",
+]
+
+BLOCK_HEADER = struct.Struct("<BBBBI")
+PROBE_FIXED = struct.Struct("<QIIII")
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def read_profile(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_GET_PROFILE_STATS, 0, 0, 4096))
+    version, probe_count, buckets, _, clk_hz = BLOCK_HEADER.unpack_from(raw, 0)
+    off = BLOCK_HEADER.size
+    probes = []
+    for i in range(probe_count):
+        total, count, cmin, cmax, _ = PROBE_FIXED.unpack_from(raw, off)
+        off += PROBE_FIXED.size
+        hist = list(struct.unpack_from(f"<{buckets}I", raw, off))
+        off += 4 * buckets
+        name = PROBE_NAMES[i] if i < len(PROBE_NAMES) else f"probe{i}"
+        probes.append({
+            "name": name,
+            "count": count,
+            "min": cmin if count else 0,
+            "max": cmax,
+            "avg": (total / count) if count else 0.0,
+            "hist": hist,
+        })
+    return version, clk_hz, probes
+
+
+def print_profile(clk_hz, probes):
+    cyc_per_us = clk_hz / 1e6 if clk_hz else 1.0
+    print(f"sys_clk={clk_hz / 1e6:.1f} MHz")
+    print(f"{'probe':<24}{'count':>10}{'min':>10}{'avg':>10}{'max':>10}   (cycles / us)")
+    for p in probes:
+        print(f"{p['name']:<24}{p['count']:>10}{p['min']:>10}{p['avg']:>10.0f}{p['max']:>10}"
+              f"   {p['min'] / cyc_per_us:.2f}/{p['avg'] / cyc_per_us:.2f}/{p['max'] / cyc_per_us:.2f} us")
+    for p in probes:
+        if not p["count"]:
+            continue
+        print(f"\n{p['name']} log2 histogram:")
+        peak = max(p["hist"]) or 1
+        for b, n in enumerate(p["hist"]):
+            if n == 0:
+                continue
+            lo = 1 << b
+            bar = "#" * max(1, int(40 * n / peak))
+            print(f"  >= {lo:>9} cyc ({lo / cyc_per_us:>9.2f} us) {n:>10} {bar}")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="pico-flexray hot-path profile reader")
+    parser.add_argument("--reset", action="store_true", help="clear counters before reading")
+    parser.add_argument("--watch", type=float, default=0.0, help="refresh interval in seconds")
+    args = parser.parse_args()
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+
+    try:
+        if args.reset:
+            dev.ctrl_transfer(BM_REQUEST_TYPE_OUT_VENDOR_DEVICE, FLEXRAY_RESET_PROFILE_STATS, 0, 0, b"")
+        while True:
+            _, clk_hz, probes = read_profile(dev)
+            print_profile(clk_hz, probes)
+            if args.watch <= 0:
+                break
+            time.sleep(args.watch)
+            print("=" * 80)
+    except usb.core.USBError as e:
+        print(f"Profile request failed ({e}); was the firmware built with -DFLEXRAY_PROFILE=ON?", file=sys.stderr)
+        return 1
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,284 @@
+#!/usr/bin/env python3
+"""
+Stream recorded traffic into the replay output (REPLAY_TX_PIN) at wire
+timing, for bench tests without a vehicle. See replay_frame.h: the device
+plays a 32 KB ring of wire-encoded words, the host keeps it between the
+low and high watermarks, and idle gaps go as runs (op 0xA5) so only frame
+bits cross USB.
+
+Inputs:
+  words FILE   little-endian u32 wire words, MSB sent first (the
+               build_replay_payload.py encoding)
+  csv FILE     flexray_stream_recorder.py CSV; frames are encoded here and
+               placed at their timestamps, never closer than --min-gap-bits
+
+The recorder timestamps each USB batch, not each frame, so frames of one
+batch are replayed back to back. Full-speed USB carries about 75% bus load
+of frame bits; beyond that the device pads with idle and counts underruns.
+
+Usage:
+  python3 flexray_replay_stream.py words capture.bin
+  python3 flexray_replay_stream.py csv flexray_log_20250101_120000.csv --source 1
+  python3 flexray_replay_stream.py stop
+  python3 flexray_replay_stream.py show
+"""
+import argparse
+import csv
+import struct
+import sys
+import time
+from datetime import datetime
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+from build_replay_payload import build_header, calculate_frame_crc24
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+EP_VENDOR_OUT = 0x03
+PACKET = 64  # each op goes in its own packet
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_REPLAY = 0x78
+OP_REPLAY_WORDS = 0xA4
+OP_REPLAY_IDLE = 0xA5
+OP_REPLAY_STREAM = 0xA6
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+
+REPLAY_STATS = struct.Struct("<B3xIIIIIIIIII")  # see replay_stream_stats_t
+WORDS_PER_OP = 15
+IDLE_WORD = 0xFFFFFFFF
+BITS_PER_US = 10
+GUARD_WORDS = 1024  # REPLAY_GUARD_WORDS
+BATCH_PACKETS = 32  # 2 KB per write: well under the ring's 26 ms at full-speed USB
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def read_stats(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_REPLAY, 0, 0, REPLAY_STATS.size))
+    names = ("streaming", "ring_words", "low_watermark", "high_watermark", "fill_words", "received_words",
+             "overflow_words", "underrun_words", "underruns", "low_events", "stalls")
+    return dict(zip(names, REPLAY_STATS.unpack(raw)))
+
+
+class WireWriter:
+    """Packs wire bits MSB first; whole idle words come out as runs."""
+
+    def __init__(self):
+        self.acc = 0
+        self.nbits = 0
+        self.records = []  # ("words", [..]) or ("idle", n)
+
+    def _word(self, word, count=1):
+        last = self.records[-1] if self.records else None
+        if word == IDLE_WORD:
+            if last and last[0] == "idle":
+                self.records[-1] = ("idle", last[1] + count)
+            else:
+                self.records.append(("idle", count))
+        elif last and last[0] == "words":
+            last[1].append(word)
+        else:
+            self.records.append(("words", [word]))
+
+    def bits(self, value, n):
+        self.acc = (self.acc << n) | (value & ((1 << n) - 1))
+        self.nbits += n
+        while self.nbits >= 32:
+            self.nbits -= 32
+            self._word((self.acc >> self.nbits) & IDLE_WORD)
+        self.acc &= (1 << self.nbits) - 1
+
+    def idle(self, n):
+        head = min(n, (32 - self.nbits) % 32)
+        self.bits((1 << head) - 1, head)
+        n -= head
+        if n >= 32:
+            self._word(IDLE_WORD, n // 32)
+        self.bits((1 << (n % 32)) - 1, n % 32)
+
+    def frame(self, indicators, frame_id, cycle_count, payload):
+        header = build_header(indicators, frame_id, cycle_count, len(payload))
+        crc24 = calculate_frame_crc24(header + payload)
+        self.bits(0, 8)  # TSS
+        self.bits(1, 1)  # FSS
+        for byte in header + payload + crc24.to_bytes(3, "big"):
+            self.bits(0b10, 2)  # BSS
+            self.bits(byte, 8)
+        self.bits(0b01, 2)  # FES
+
+    def take(self):
+        out, self.records = self.records, []
+        return out
+
+
+def csv_records(path, source, min_gap_bits):
+    w = WireWriter()
+    t0 = None
+    sent_bits = 0
+    with open(path, newline="", encoding="utf-8") as f:
+        for row in csv.DictReader(f):
+            if source is not None and int(row["source"]) != source:
+                continue
+            ts = datetime.fromisoformat(row["timestamp"]).timestamp()
+            t0 = ts if t0 is None else t0
+            at = int((ts - t0) * 1e6 * BITS_PER_US)
+            gap = max(at - sent_bits, min_gap_bits)
+            payload = bytes.fromhex(row["payload"])
+            w.idle(gap)
+            w.frame(int(row["indicators"], 2), int(row["frame_id"]), int(row["cycle_count"]), payload)
+            sent_bits += gap + 11 + 10 * (8 + len(payload))  # TSS, FSS, FES and BSS + byte
+            yield from w.take()
+    w.idle(32)
+    yield from w.take()
+
+
+def words_records(path):
+    with open(path, "rb") as f:
+        while True:
+            chunk = f.read(4 * 1024)
+            if not chunk:
+                return
+            for (word,) in struct.iter_unpack("<I", chunk[: len(chunk) // 4 * 4]):
+                if word == IDLE_WORD:
+                    yield ("idle", 1)
+                else:
+                    yield ("words", [word])
+
+
+def ops(records):
+    """One padded 64-byte packet per op, with the word count each carries."""
+    words = []
+    for kind, value in records:
+        if kind == "idle":
+            while words:
+                yield pack_words(words[:WORDS_PER_OP])
+                words = words[WORDS_PER_OP:]
+            yield struct.pack("<BI", OP_REPLAY_IDLE, value).ljust(PACKET, b"\x00"), value
+        else:
+            words += value
+            while len(words) >= WORDS_PER_OP:
+                yield pack_words(words[:WORDS_PER_OP])
+                words = words[WORDS_PER_OP:]
+    if words:
+        yield pack_words(words)
+
+
+def pack_words(words):
+    op = struct.pack("<BB", OP_REPLAY_WORDS, len(words)) + struct.pack(f"<{len(words)}I", *words)
+    return op.ljust(PACKET, b"\x00"), len(words)
+
+
+def merged_idle(records):
+    """Coalesce adjacent idle runs so a long gap costs one packet."""
+    pending = 0
+    for kind, value in records:
+        if kind == "idle":
+            pending += value
+            continue
+        if pending:
+            yield ("idle", pending)
+            pending = 0
+        yield (kind, value)
+    if pending:
+        yield ("idle", pending)
+
+
+def stream(dev, records):
+    dev.write(EP_VENDOR_OUT, bytes([OP_REPLAY_STREAM, 1]).ljust(PACKET, b"\x00"), timeout=1000)
+    st = read_stats(dev)
+    high = st["high_watermark"]
+    batch = []
+    credit = 0
+    last_print = time.monotonic()
+    for packet, n in ops(merged_idle(records)):
+        # Idle runs longer than the ring wait for room in several steps
+        while n > 0:
+            while credit <= 0:
+                if batch:
+                    dev.write(EP_VENDOR_OUT, b"".join(batch), timeout=1000)
+                    batch = []
+                st = read_stats(dev)
+                credit = high - st["fill_words"]
+                if credit <= 0:
+                    time.sleep(0.002)
+                if time.monotonic() - last_print >= 1.0:
+                    last_print = time.monotonic()
+                    print(f"fill {st['fill_words']} underrun_words {st['underrun_words']} "
+                          f"underruns {st['underruns']} overflow_words {st['overflow_words']}")
+            if packet[0] == OP_REPLAY_IDLE:
+                take = min(n, credit)
+                batch.append(struct.pack("<BI", OP_REPLAY_IDLE, take).ljust(PACKET, b"\x00"))
+            else:
+                take = n
+                batch.append(packet)
+            credit -= take
+            n -= take
+            if len(batch) >= BATCH_PACKETS:
+                dev.write(EP_VENDOR_OUT, b"".join(batch), timeout=1000)
+                batch = []
+    if batch:
+        dev.write(EP_VENDOR_OUT, b"".join(batch), timeout=1000)
+
+
+def show(st):
+    for k, v in st.items():
+        print(f"{k:>15}: {v}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Host-streamed FlexRay replay")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("words", help="stream a file of wire words")
+    p.add_argument("file")
+    p = sub.add_parser("csv", help="encode and stream a recorder CSV")
+    p.add_argument("file")
+    p.add_argument("--source", type=int, default=None, help="replay only this source column value")
+    p.add_argument("--min-gap-bits", type=int, default=11, help="idle between frames at least")
+    sub.add_parser("stop", help="leave stream mode (back to the built-in loop)")
+    sub.add_parser("show", help="read the stream counters")
+    args = parser.parse_args()
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+    if args.cmd == "show":
+        show(read_stats(dev))
+        return 0
+    if args.cmd == "stop":
+        dev.write(EP_VENDOR_OUT, bytes([OP_REPLAY_STREAM, 0]).ljust(PACKET, b"\x00"), timeout=1000)
+        return 0
+    records = words_records(args.file) if args.cmd == "words" else \
+        csv_records(args.file, args.source, args.min_gap_bits)
+    try:
+        stream(dev, records)
+    except KeyboardInterrupt:
+        pass
+    # Let the queued words play out before reporting
+    while read_stats(dev)["fill_words"] > GUARD_WORDS:
+        time.sleep(0.01)
+    show(read_stats(dev))
+    print("stream mode stays on (idle); 'stop' restores the built-in loop")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
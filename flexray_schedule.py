@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+Read the schedule learned on the device (FLEXRAY_READ_SCHEDULE) and export it
+as a JSON bus model: per slot the frame ID, cycle base/repetition, payload
+length, sending side and time offset within the cycle. Use it to pick
+injection triggers, set up filters and generate replay schedules.
+
+Offsets are relative to the end of the anchor frame (the lowest frame ID that
+is sent in every cycle), so they are comparable across slots in one capture.
+
+Usage:
+  python3 flexray_schedule.py                       # print the learned table
+  python3 flexray_schedule.py --out bus_model.json  # write the model
+  python3 flexray_schedule.py --reset               # start learning again
+"""
+import argparse
+import json
+import struct
+import sys
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_SCHEDULE = 0x68
+FLEXRAY_RESET_SCHEDULE = 0x69
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+BM_REQUEST_TYPE_OUT_VENDOR_DEVICE = 0x40
+
+SCHEDULE_HEADER = struct.Struct("<HHHBBHBBII")  # see schedule_header_t
+SCHEDULE_ENTRY = struct.Struct("<HBBBBBBiiIQ")  # see schedule_entry_t
+SOURCE_ECU = 0x01
+SOURCE_VEHICLE = 0x02
+LEN_VARIES = 0xFF
+FLAG_STATIC = 0x01
+FLAG_OFFSET = 0x02
+NO_ANCHOR = 0xFFFF
+READ_SIZE = 2048
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def read_schedule(dev):
+    header = None
+    entries = []
+    first = 0
+    while True:
+        raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_SCHEDULE, first, 0, READ_SIZE))
+        if len(raw) < SCHEDULE_HEADER.size:
+            break
+        total, _, count, entry_size, _, anchor_id, anchor_source, _, period_us, cycles = SCHEDULE_HEADER.unpack_from(raw, 0)
+        header = {'anchor_id': anchor_id, 'anchor_source': anchor_source,
+                  'cycle_period_us': period_us, 'cycles_seen': cycles}
+        off = SCHEDULE_HEADER.size
+        for _ in range(count):
+            entries.append(SCHEDULE_ENTRY.unpack_from(raw, off))
+            off += entry_size
+        first += count
+        if count == 0 or first >= total:
+            break
+    return header, entries
+
+
+def sender_name(sources):
+    return {SOURCE_ECU: "ecu", SOURCE_VEHICLE: "vehicle"}.get(sources, "both")
+
+
+def build_model(header, entries):
+    slots = []
+    for (frame_id, sources, words, base, rep, flags, off_min, off_max, samples, mask) in sorted(entries):
+        slot = {
+            'slot': frame_id,
+            'frame_id': frame_id,
+            'segment': 'static' if flags & FLAG_STATIC else 'dynamic',
+            'sender': sender_name(sources),
+            'payload_bytes': None if words == LEN_VARIES else words * 2,
+            'cycle_base': base if rep else None,
+            'cycle_repetition': rep if rep else None,
+            'cycle_mask': f"0x{mask:016x}",
+            'offset_us': {'min': off_min, 'max': off_max} if flags & FLAG_OFFSET else None,
+            'samples': samples,
+        }
+        slots.append(slot)
+    anchor = None
+    if header and header['anchor_id'] != NO_ANCHOR:
+        anchor = {'frame_id': header['anchor_id'], 'sender': 'vehicle' if header['anchor_source'] else 'ecu'}
+    return {
+        'cycle_period_us': header['cycle_period_us'] if header else None,
+        'cycles_observed': header['cycles_seen'] if header else 0,
+        'anchor': anchor,
+        'offset_reference': 'end of anchor frame, same cycle',
+        'slots': slots,
+    }
+
+
+def print_model(model):
+    anchor = model['anchor']
+    print(f"cycle period {model['cycle_period_us']} us over {model['cycles_observed']} cycles, "
+          f"anchor {('0x%03x ' % anchor['frame_id'] + anchor['sender']) if anchor else '(learning)'}")
+    print(f"{'slot':>5} {'seg':>7} {'sender':>7} {'len':>4} {'cycles':>8} {'offset_us':>14} {'n':>7}")
+    for s in model['slots']:
+        cycles = f"{s['cycle_base']}%{s['cycle_repetition']}" if s['cycle_repetition'] else "irreg"
+        off = f"{s['offset_us']['min']}..{s['offset_us']['max']}" if s['offset_us'] else "-"
+        length = "var" if s['payload_bytes'] is None else s['payload_bytes']
+        print(f"0x{s['slot']:03x} {s['segment']:>7} {s['sender']:>7} {length:>4} {cycles:>8} {off:>14} {s['samples']:>7}")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="pico-flexray schedule learner export")
+    parser.add_argument("--out", type=str, default=None, help="write the bus model as JSON")
+    parser.add_argument("--reset", action="store_true", help="clear the learned schedule")
+    args = parser.parse_args()
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+
+    if args.reset:
+        dev.ctrl_transfer(BM_REQUEST_TYPE_OUT_VENDOR_DEVICE, FLEXRAY_RESET_SCHEDULE, 0, 0, b"")
+        print("Schedule learner reset")
+        return 0
+
+    header, entries = read_schedule(dev)
+    model = build_model(header, entries)
+    print_model(model)
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump(model, f, indent=2)
+        print(f"Wrote {len(model['slots'])} slots to {args.out}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
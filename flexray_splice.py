@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""
+Put an injection rule in splice mode (op 0xA1, see flexray_splice.h): the
+target frame is forwarded live and only a window of payload bytes is driven
+from the template, with the frame CRC corrected on the fly. Reads back the
+per-rule state and counters.
+
+Usage:
+  python3 flexray_splice.py enable --rule 0                     # host slice + E2E area
+  python3 flexray_splice.py enable --rule 0 --offset 2 --len 14
+  python3 flexray_splice.py disable --rule 0
+  python3 flexray_splice.py stats
+"""
+import argparse
+import struct
+import sys
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+EP_VENDOR_OUT = 0x03
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_SPLICE = 0x75
+OP_SET_SPLICE = 0xA1
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+
+SPLICE_STATE = struct.Struct("<BBBBIIIII")  # see splice_state_t
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def stats(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_SPLICE, 0, 0, 256))
+    for rule in range(len(raw) // SPLICE_STATE.size):
+        enabled, offset, length, payload_len, splices, corrected, late, aborted, unready = \
+            SPLICE_STATE.unpack_from(raw, rule * SPLICE_STATE.size)
+        state = "on" if enabled else "off"
+        layout = f"payload {payload_len}" if payload_len else "no layout yet"
+        print(f"rule {rule}: {state} window {offset}+{length} ({layout}) splices {splices} "
+              f"corrected {corrected} late {late} aborted {aborted} unready {unready}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Streaming splice of injected frames")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("enable", help="splice a rule's window into the live frame")
+    p.add_argument("--rule", type=int, default=0)
+    p.add_argument("--offset", type=int, default=0, help="first payload byte of the window")
+    p.add_argument("--len", type=int, default=0, help="window bytes (max 16), 0 = host slice and E2E area")
+    p = sub.add_parser("disable", help="back to whole-frame injection")
+    p.add_argument("--rule", type=int, default=0)
+    sub.add_parser("stats", help="read the per-rule state and counters")
+    args = parser.parse_args()
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+    if args.cmd == "stats":
+        stats(dev)
+        return 0
+    if args.cmd == "enable":
+        op = struct.pack("<BBBBB", OP_SET_SPLICE, args.rule, 1, args.offset, args.len)
+    else:
+        op = struct.pack("<BBBBB", OP_SET_SPLICE, args.rule, 0, 0, 0)
+    dev.write(EP_VENDOR_OUT, op, timeout=1000)
+    print("sent; a rejected window is reported as telemetry error 8 (arg1 0x100 = busy, resend)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
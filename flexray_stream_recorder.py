@@ -3,6 +3,7 @@ import usb.util
 import time
 import sys
 import csv
+import struct
 from datetime import datetime
 
 # Panda USB VID/PID
@@ -18,6 +19,36 @@ RAW_BENCH_MODE = False  # When True, skip CSV and per-frame hex, only count FPS
 STATS_INTERVAL_SEC = 1.0   # How often to print a brief stats line
 MIN_BODY_LEN = 11  # src(1) + header(5) + crc24(3) + minimal payload(0)
 
+# Change-only streaming (op 0x95, see src/flexray_stream_codec.h). The device
+# then sends a frame only when its payload changes, an UNCHANGED tick for each
+# repeat, and a full keyframe every KEYFRAME_INTERVAL occurrences per slot.
+# DELTA_MODE additionally sends small payload changes as XOR DELTA records.
+CHANGES_ONLY_MODE = False
+DELTA_MODE = False
+# Container v2 (flags bit1 of op 0x95, see src/flexray_telemetry.h): records
+# arrive in batches with a sequence number, drop counters and in-band events.
+CONTAINER_V2_MODE = False
+# Flush policy (op 0x96): immediate flushing (default) suits control loops;
+# COALESCE_MODE batches up to FLUSH_THRESHOLD_BYTES or FLUSH_MAX_DELAY_US for logging.
+COALESCE_MODE = False
+# Cycle snapshots (op 0x99): static slots 1..SNAPSHOT_LAST_STATIC_ID arrive as
+# one record per cycle and direction. 0 disables.
+SNAPSHOT_LAST_STATIC_ID = 0
+FLUSH_THRESHOLD_BYTES = 4096
+FLUSH_MAX_DELAY_US = 5000
+KEYFRAME_INTERVAL = 64
+CYCLE_MUX_MASK = 0x03
+EP_VENDOR_OUT = 0x03
+
+RECORD_KIND_FULL = 0
+RECORD_KIND_UNCHANGED = 1
+RECORD_KIND_DELTA = 2
+RECORD_KIND_CYCLE_SNAPSHOT = 3
+SNAPSHOT_FIXED_BODY_LEN = 6  # src|kind(1) + cycle(1) + first_id(2) + slot_count(2)
+SNAPSHOT_SLOT_LEN = 7  # n_words(1) + indicators(1) + header_crc(2) + frame_crc(3)
+UNCHANGED_BODY_LEN = 8  # src|kind(1) + id(2) + cycle(1) + ref_cycle(1) + crc24(3)
+DELTA_FIXED_BODY_LEN = 8  # as UNCHANGED, followed by [mask][xor bytes]
+
 '''
 typedef struct
 {
@@ -33,23 +64,222 @@ typedef struct
     uint8_t payload[MAX_FRAME_PAYLOAD_BYTES];
 } flexray_frame_t;
 '''
-# Variable-length records: [u16 len_le][u8 src][5B header][payload][3B crc]
+# Variable-length records: [u16 len_le][u8 src|kind<<6][body]
+#   kind 0: [5B header][payload][3B crc]
+#   kind 1: [u16 id][u8 cycle][u8 ref_cycle][3B crc] (payload as last full (src, id, ref_cycle))
+#   kind 2: [u16 id][u8 cycle][u8 ref_cycle][3B crc][mask][xor bytes] (payload = reference ^ delta)
+#   kind 3: [u8 cycle][u16 first_id][u16 slot_count][bitmap][per slot: u8 words, u8 indicators, payload]
+
+def apply_delta_record(body, history):
+    """Rebuild the frame of one DELTA record body, or None if its reference is unknown."""
+    src = body[0] & 0x3F
+    frame_id = body[1] | ((body[2] & 0x07) << 8)
+    ref = history.get((src, frame_id, body[4] & 0x3F))
+    if ref is None:
+        return None
+    n = len(ref['payload'])
+    mask_len = (n + 7) // 8
+    mask = body[DELTA_FIXED_BODY_LEN:DELTA_FIXED_BODY_LEN + mask_len]
+    data = DELTA_FIXED_BODY_LEN + mask_len
+    payload = bytearray(ref['payload'])
+    for b in range(n):
+        if mask[b >> 3] & (1 << (b & 7)):
+            if data >= len(body):
+                return None
+            payload[b] ^= body[data]
+            data += 1
+    if data != len(body):
+        return None
+    frame = dict(ref)
+    frame['cycle_count'] = body[3] & 0x3F
+    frame['frame_crc'] = (body[5] << 16) | (body[6] << 8) | body[7]
+    frame['payload'] = bytes(payload)
+    frame['unchanged'] = False
+    history[(src, frame_id, frame['cycle_count'])] = frame
+    return frame
 
-def parse_varlen_records(buffer, frames_out):
+BATCH_MAGIC = 0xF5
+BATCH_HEADER = struct.Struct('<BBHIIIII')  # magic, version, batch_len, seq, timestamp_us, fifo/notify/event dropped
+TLV_FRAME = 0x01
+TLV_INJECTION = 0x02
+TLV_ERROR = 0x03
+TLV_STATS = 0x04
+TLV_OVERRIDE_ACK = 0x05
+TLV_TIMEBASE = 0x06
+TLV_STRUCTS = {
+    TLV_INJECTION: ('injection', struct.Struct('<IHBBHH'), ('timestamp_us', 'target_id', 'cycle_count', 'direction', 'trigger_id', 'frame_len')),
+    TLV_ERROR: ('error', struct.Struct('<IHHII'), ('timestamp_us', 'code', 'reserved', 'arg0', 'arg1')),
+    TLV_OVERRIDE_ACK: ('override_ack', struct.Struct('<IIHBBB3x'), ('seq', 'timestamp_us', 'target_id', 'rule', 'result', 'cycle_count')),
+    TLV_STATS: ('stats', struct.Struct('<IIIIII'), ('timestamp_us', 'frames_total', 'frames_valid', 'parse_fail', 'filtered', 'fifo_count')),
+    TLV_TIMEBASE: ('timebase', struct.Struct('<IIIII'), ('timestamp_us', 'cycle_index', 'macrotick', 'macrotick_ps', 'cycle_macroticks')),
+}
+
+def parse_container_v2(buffer, frames_out, history, state):
+    """
+    Parse whole container v2 batches. Resync (scanning for the magic byte)
+    only happens at batch boundaries; inside a batch each TLV is taken in O(1).
+    state carries last_seq, lost_batches, resyncs, the last batch header and
+    decoded events across calls. Returns the number of bytes consumed.
+    """
+    i = 0
+    buflen = len(buffer)
+    while i + BATCH_HEADER.size <= buflen:
+        magic, version, batch_len, seq, ts, fifo_drop, notify_drop, event_drop = BATCH_HEADER.unpack_from(buffer, i)
+        if magic != BATCH_MAGIC or version != 2 or batch_len < BATCH_HEADER.size:
+            state['resyncs'] = state.get('resyncs', 0) + 1
+            nxt = buffer.find(bytes([BATCH_MAGIC]), i + 1)
+            i = nxt if nxt >= 0 else buflen
+            continue
+        if i + batch_len > buflen:
+            break
+        last_seq = state.get('last_seq')
+        if last_seq is not None and seq != ((last_seq + 1) & 0xFFFFFFFF):
+            state['lost_batches'] = state.get('lost_batches', 0) + ((seq - last_seq - 1) & 0xFFFFFFFF)
+        state['last_seq'] = seq
+        state['header'] = {'seq': seq, 'timestamp_us': ts, 'fifo_dropped': fifo_drop,
+                           'notify_dropped': notify_drop, 'event_dropped': event_drop}
+        j = i + BATCH_HEADER.size
+        end = i + batch_len
+        while j + 3 <= end:
+            tlv_type = buffer[j]
+            tlv_len = buffer[j+1] | (buffer[j+2] << 8)
+            if j + 3 + tlv_len > end:
+                break
+            if tlv_type == TLV_FRAME:
+                # A frame TLV minus its type byte is a legacy [u16 len][body] record
+                batch_frames = []
+                parse_varlen_records(buffer[j+1:j+3+tlv_len], batch_frames, history)
+                for frame in batch_frames:
+                    frame['device_timestamp_us'] = ts
+                    if state.get('timebase', {}).get('macrotick_ps'):
+                        frame['global_macrotick'] = to_global_macrotick(state['timebase'], ts)
+                frames_out.extend(batch_frames)
+            elif tlv_type in TLV_STRUCTS:
+                name, st, fields = TLV_STRUCTS[tlv_type]
+                if tlv_len >= st.size:
+                    event = dict(zip(fields, st.unpack_from(buffer, j + 3)))
+                    event['type'] = name
+                    if name == 'timebase':
+                        state['timebase'] = event
+                    state.setdefault('events', []).append(event)
+            j += 3 + tlv_len
+        i = end
+    return i
+
+def to_global_macrotick(timebase, timestamp_us):
+    """Device time_us_32() -> macroticks since the device's timebase cycle 0, via a TIMEBASE TLV."""
+    delta_us = ((timestamp_us - timebase['timestamp_us'] + 0x80000000) & 0xFFFFFFFF) - 0x80000000
+    base = timebase['cycle_index'] * timebase['cycle_macroticks'] + timebase['macrotick']
+    return base + (delta_us * 1000000) // timebase['macrotick_ps']
+
+def parse_cycle_snapshot(body):
+    """
+    Decode one CYCLE_SNAPSHOT body into
+    {'source', 'cycle_count', 'slots': {id: (indicators, header_crc, frame_crc, payload)}}.
+    Returns None if the body is malformed.
+    """
+    src = body[0] & 0x3F
+    cycle_count = body[1] & 0x3F
+    first_id = body[2] | (body[3] << 8)
+    slot_count = body[4] | (body[5] << 8)
+    bitmap_len = (slot_count + 7) // 8
+    pos = SNAPSHOT_FIXED_BODY_LEN + bitmap_len
+    if pos > len(body):
+        return None
+    bitmap = int.from_bytes(body[SNAPSHOT_FIXED_BODY_LEN:pos], 'little')
+    slots = {}
+    while bitmap:
+        bit = (bitmap & -bitmap).bit_length() - 1
+        bitmap &= bitmap - 1
+        if pos + SNAPSHOT_SLOT_LEN > len(body):
+            return None
+        n = body[pos] * 2
+        indicators = body[pos + 1]
+        header_crc = body[pos + 2] | (body[pos + 3] << 8)
+        frame_crc = (body[pos + 4] << 16) | (body[pos + 5] << 8) | body[pos + 6]
+        pos += SNAPSHOT_SLOT_LEN
+        if pos + n > len(body):
+            return None
+        slots[first_id + bit] = (indicators, header_crc, frame_crc, bytes(body[pos:pos + n]))
+        pos += n
+    if pos != len(body):
+        return None
+    return {'source': src, 'cycle_count': cycle_count, 'slots': slots}
+
+def parse_varlen_records(buffer, frames_out, history=None, snapshots_out=None):
     """
     Incrementally parse variable-length FlexRay records from an arbitrary byte buffer.
+    Full and delta frames are stored in history (keyed by (source, frame_id,
+    cycle_count)) so UNCHANGED/DELTA records can be expanded back into frames;
+    records whose reference has not been seen yet (host joined mid-stream) are
+    dropped until the next keyframe. Cycle snapshots go to snapshots_out when
+    given, otherwise they are expanded into per-slot frames.
     Returns the number of bytes consumed.
     """
+    if history is None:
+        history = {}
     i = 0
     buflen = len(buffer)
     while i + 2 <= buflen:
         body_len = buffer[i] | (buffer[i+1] << 8)
+        if body_len == UNCHANGED_BODY_LEN and i + 2 < buflen and (buffer[i+2] >> 6) == RECORD_KIND_UNCHANGED:
+            if i + 2 + body_len > buflen:
+                break
+            src = buffer[i+2] & 0x3F
+            frame_id = buffer[i+3] | ((buffer[i+4] & 0x07) << 8)
+            cycle_count = buffer[i+5] & 0x3F
+            ref = history.get((src, frame_id, buffer[i+6] & 0x3F))
+            if ref is not None:
+                frame = dict(ref)
+                frame['cycle_count'] = cycle_count
+                frame['frame_crc'] = (buffer[i+7] << 16) | (buffer[i+8] << 8) | buffer[i+9]
+                frame['unchanged'] = True
+                frames_out.append(frame)
+            i += 2 + body_len
+            continue
+        if body_len >= DELTA_FIXED_BODY_LEN and i + 2 < buflen and (buffer[i+2] >> 6) == RECORD_KIND_DELTA:
+            if i + 2 + body_len > buflen:
+                break
+            frame = apply_delta_record(buffer[i+2:i+2+body_len], history)
+            if frame is not None:
+                frames_out.append(frame)
+            i += 2 + body_len
+            continue
+        if body_len >= SNAPSHOT_FIXED_BODY_LEN and i + 2 < buflen and (buffer[i+2] >> 6) == RECORD_KIND_CYCLE_SNAPSHOT:
+            if i + 2 + body_len > buflen:
+                break
+            snap = parse_cycle_snapshot(buffer[i+2:i+2+body_len])
+            if snap is None:
+                i += 1
+                continue
+            if snapshots_out is not None:
+                snapshots_out.append(snap)
+            else:
+                for frame_id, (indicators, header_crc, frame_crc, payload) in snap['slots'].items():
+                    frames_out.append({
+                        'source': snap['source'],
+                        'indicators': indicators,
+                        'frame_id': frame_id,
+                        'payload_length_words': len(payload) // 2,
+                        'header_crc': header_crc,
+                        'cycle_count': snap['cycle_count'],
+                        'payload': payload,
+                        'frame_crc': frame_crc,
+                        'header_crc_valid': True,
+                        'frame_crc_valid': True,
+                        'unchanged': False,
+                    })
+            i += 2 + body_len
+            continue
         if body_len < MIN_BODY_LEN:
             i += 1
             continue
         if i + 2 + body_len > buflen:
             break
         src = buffer[i+2]
+        if (src >> 6) != RECORD_KIND_FULL:
+            i += 1
+            continue
         header = buffer[i+3:i+8]
         indicators = header[0] >> 3
         frame_id = ((header[0] & 0x07) << 8) | header[1]
@@ -64,7 +294,7 @@ def parse_varlen_records(buffer, frames_out):
         payload = bytes(buffer[i+8:i+8+payload_bytes])
         crc_bytes = buffer[i+8+payload_bytes:i+8+payload_bytes+3]
         frame_crc = (crc_bytes[0] << 16) | (crc_bytes[1] << 8) | crc_bytes[2]
-        frames_out.append({
+        frame = {
             'source': src,
             'indicators': indicators,
             'frame_id': frame_id,
@@ -75,7 +305,10 @@ def parse_varlen_records(buffer, frames_out):
             'frame_crc': frame_crc,
             'header_crc_valid': True,
             'frame_crc_valid': True,
-        })
+            'unchanged': False,
+        }
+        history[(src, frame_id, cycle_count)] = frame
+        frames_out.append(frame)
         i += 2 + body_len
     return i
 
@@ -102,6 +335,32 @@ def find_usb_device():
     
     return dev
 
+def set_stream_mode(dev, changes_only, delta=False):
+    # op 0x95: [0x95][u8 mode][u8 flags][u16 keyframe_interval][u8 cycle_mux_mask]
+    mode = (2 if delta else 1) if changes_only else 0
+    flags = 0x01 | (0x02 if CONTAINER_V2_MODE else 0)
+    op = struct.pack('<BBBHB', 0x95, mode, flags, KEYFRAME_INTERVAL, CYCLE_MUX_MASK)
+    try:
+        dev.write(EP_VENDOR_OUT, op, timeout=1000)  # type: ignore
+    except usb.core.USBError as e:
+        print(f"Warning: Failed to set stream mode: {e}")
+
+def set_flush_policy(dev, coalesce):
+    # op 0x96: [0x96][u8 mode][u16 threshold_bytes][u32 max_delay_us]
+    op = struct.pack('<BBHI', 0x96, 1 if coalesce else 0, FLUSH_THRESHOLD_BYTES, FLUSH_MAX_DELAY_US)
+    try:
+        dev.write(EP_VENDOR_OUT, op, timeout=1000)  # type: ignore
+    except usb.core.USBError as e:
+        print(f"Warning: Failed to set flush policy: {e}")
+
+def set_cycle_snapshot(dev, last_static_id):
+    # op 0x99: [0x99][u8 enable][u16 last_static_id]
+    op = struct.pack('<BBH', 0x99, 1 if last_static_id else 0, last_static_id)
+    try:
+        dev.write(EP_VENDOR_OUT, op, timeout=1000)  # type: ignore
+    except usb.core.USBError as e:
+        print(f"Warning: Failed to set cycle snapshot mode: {e}")
+
 def read_and_parse_data_continuously(dev, csv_writer):
     """Continuously read data from endpoint and parse FlexRay frames"""
     print(f"\nStarting to read data from endpoint 0x{TARGET_ENDPOINT:02x} and parse FlexRay frames...")
@@ -109,6 +368,8 @@ def read_and_parse_data_continuously(dev, csv_writer):
     print("=" * 80)
 
     data_buffer = b''
+    history = {}
+    container_state = {}
     csv_buffer = []
     total_frames = 0
     start_time = time.time()
@@ -130,7 +391,13 @@ def read_and_parse_data_continuously(dev, csv_writer):
 
                     # Process data in buffer using variable-length records
                     frames = []
-                    consumed = parse_varlen_records(data_buffer, frames)
+                    if CONTAINER_V2_MODE:
+                        consumed = parse_container_v2(data_buffer, frames, history, container_state)
+                        for event in container_state.pop('events', []):
+                            if event['type'] not in ('stats', 'timebase'):
+                                print(f"Device event: {event}")
+                    else:
+                        consumed = parse_varlen_records(data_buffer, frames, history)
                     if consumed > 0:
                         data_buffer = data_buffer[consumed:]
                     for frame in frames:
@@ -170,7 +437,12 @@ def read_and_parse_data_continuously(dev, csv_writer):
                     if RAW_BENCH_MODE:
                         print(f"FPS(avg): {fps:.1f}")
                     else:
-                        print(f"Frames processed: {total_frames} | FPS(avg): {fps:.1f} | Unique IDs: {len(sorted_frame_ids)}")
+                        line = f"Frames processed: {total_frames} | FPS(avg): {fps:.1f} | Unique IDs: {len(sorted_frame_ids)}"
+                        hdr = container_state.get('header')
+                        if hdr:
+                            line += (f" | lost batches: {container_state.get('lost_batches', 0)}"
+                                     f" | dropped fifo/notify/event: {hdr['fifo_dropped']}/{hdr['notify_dropped']}/{hdr['event_dropped']}")
+                        print(line)
                     last_display_time = current_time
                 
             except usb.core.USBTimeoutError:
@@ -185,6 +457,12 @@ def read_and_parse_data_continuously(dev, csv_writer):
                     dev = find_usb_device()
                 if dev:
                     print("Device reconnected.")
+                    data_buffer = b''
+                    history.clear()
+                    container_state.clear()
+                    set_stream_mode(dev, CHANGES_ONLY_MODE, DELTA_MODE)
+                    set_flush_policy(dev, COALESCE_MODE)
+                    set_cycle_snapshot(dev, SNAPSHOT_LAST_STATIC_ID)
                 else:
                     print("Failed to reconnect device. Exiting.")
                     break
@@ -208,6 +486,19 @@ def read_and_parse_data_continuously(dev, csv_writer):
 
 
 def main():
+    global CHANGES_ONLY_MODE, DELTA_MODE, CONTAINER_V2_MODE, COALESCE_MODE, SNAPSHOT_LAST_STATIC_ID
+    if '--snapshot' in sys.argv[1:]:
+        idx = sys.argv.index('--snapshot')
+        SNAPSHOT_LAST_STATIC_ID = int(sys.argv[idx + 1], 0) if idx + 1 < len(sys.argv) else 0x7F
+    if '--coalesce' in sys.argv[1:]:
+        COALESCE_MODE = True
+    if '--container' in sys.argv[1:]:
+        CONTAINER_V2_MODE = True
+    if '--changes-only' in sys.argv[1:]:
+        CHANGES_ONLY_MODE = True
+    if '--delta' in sys.argv[1:]:
+        CHANGES_ONLY_MODE = True
+        DELTA_MODE = True
     print("FlexRay USB data stream recorder")
     print("=" * 40)
     
@@ -233,6 +524,11 @@ def main():
     if dev is None:
         csv_file.close()
         sys.exit(1)
+
+    # Also restarts the device-side payload history, so keyframes come first
+    set_stream_mode(dev, CHANGES_ONLY_MODE, DELTA_MODE)
+    set_flush_policy(dev, COALESCE_MODE)
+    set_cycle_snapshot(dev, SNAPSHOT_LAST_STATIC_ID)
     
     # Start continuously reading and parsing data
     try:
@@ -240,6 +536,13 @@ def main():
     except Exception as e:
         print(f"\nUnhandled error: {e}")
     finally:
+        if CHANGES_ONLY_MODE or CONTAINER_V2_MODE:
+            CONTAINER_V2_MODE = False
+            set_stream_mode(dev, False)
+        if COALESCE_MODE:
+            set_flush_policy(dev, False)
+        if SNAPSHOT_LAST_STATIC_ID:
+            set_cycle_snapshot(dev, 0)
         if csv_file and not csv_file.closed:
             csv_file.close()
             print(f"\nLog file {csv_filename} closed.")
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""
+Show the device's reconstruction of the FlexRay cycle (FLEXRAY_READ_TIMEBASE):
+lock state, measured macrotick and drift against the Pico crystal, the fitted
+static slot grid and where in the cycle the bus is right now.
+
+The position maps the device's time_us_32() to global time (cycle index and
+macrotick). Container v2 streams carry the same mapping as TIMEBASE TLVs,
+which flexray_stream_recorder.py uses to put frames on global time.
+
+Usage:
+  python3 flexray_timebase.py                   # one reading
+  python3 flexray_timebase.py --watch 0.5
+  python3 flexray_timebase.py --macrotick 2000  # nominal macrotick 2 us, relearn
+"""
+import argparse
+import struct
+import sys
+import time
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_TIMEBASE = 0x6E
+FLEXRAY_SET_TIMEBASE = 0x6F
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+BM_REQUEST_TYPE_OUT_VENDOR_DEVICE = 0x40
+
+TIMEBASE_STATUS = struct.Struct("<BBHIiiIIII")          # see timebase_status_t
+TIMEBASE_MODEL = struct.Struct("<BBHIIIHHIiIIIIHH")     # see timebase_model_t
+MODEL_LOCKED = 0x01
+MODEL_SLOTS = 0x02
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def read_timebase(dev):
+    size = TIMEBASE_STATUS.size + TIMEBASE_MODEL.size
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_TIMEBASE, 0, 0, size))
+    if len(raw) < size:
+        return None
+    status = dict(zip(('locked', 'anchor_source', 'anchor_id', 'period_ns', 'drift_ppb', 'phase_err_ns',
+                       'jitter_avg_ns', 'jitter_max_ns', 'locks', 'cycles'),
+                      TIMEBASE_STATUS.unpack_from(raw, 0)))
+    model = dict(zip(('flags', 'reserved', 'static_slots', 'nominal_macrotick_ns', 'macrotick_ps',
+                      'cycle_macroticks', 'slot_macroticks', 'fit_points', 'slot_ns', 'cycle_start_ns',
+                      'fit_residual_ns', 'now_us', 'now_cycle_index', 'now_macrotick', 'now_slot',
+                      'now_slot_macrotick'),
+                     TIMEBASE_MODEL.unpack_from(raw, TIMEBASE_STATUS.size)))
+    return status, model
+
+
+def print_timebase(status, model):
+    if not model['flags'] & MODEL_LOCKED:
+        print(f"acquiring (anchor 0x{status['anchor_id']:03x}, {status['locks']} locks so far)")
+        return
+    print(f"locked on anchor 0x{status['anchor_id']:03x}: cycle {status['period_ns'] / 1000:.3f} us "
+          f"= {model['cycle_macroticks']} MT, macrotick {model['macrotick_ps'] / 1000:.4f} ns "
+          f"(nominal {model['nominal_macrotick_ns']} ns), drift {status['drift_ppb'] / 1000:+.2f} ppm, "
+          f"jitter avg {status['jitter_avg_ns']} ns max {status['jitter_max_ns']} ns")
+    if model['flags'] & MODEL_SLOTS:
+        print(f"static slot {model['slot_macroticks']} MT ({model['slot_ns']} ns), slots 1..{model['static_slots']}, "
+              f"cycle start {model['cycle_start_ns']} ns from anchor end, "
+              f"fit {model['fit_points']} slots, residual {model['fit_residual_ns']} ns")
+    else:
+        print("static slot grid not fitted yet (positions are relative to the anchor end)")
+    slot = f"slot {model['now_slot']} +{model['now_slot_macrotick']} MT" if model['now_slot'] else "outside static segment"
+    print(f"now (device {model['now_us']} us): cycle {model['now_cycle_index'] & 0x3F} "
+          f"(#{model['now_cycle_index']}), macrotick {model['now_macrotick']}, {slot}")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="pico-flexray cycle timebase")
+    parser.add_argument("--watch", type=float, default=0.0, help="repeat every N seconds")
+    parser.add_argument("--macrotick", type=int, default=None, help="nominal macrotick in ns (restarts acquisition)")
+    args = parser.parse_args()
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+
+    if args.macrotick is not None:
+        dev.ctrl_transfer(BM_REQUEST_TYPE_OUT_VENDOR_DEVICE, FLEXRAY_SET_TIMEBASE, args.macrotick & 0xFFFF, 0, b"")
+
+    while True:
+        result = read_timebase(dev)
+        if result is None:
+            print("No timebase data", file=sys.stderr)
+            return 1
+        print_timebase(*result)
+        if args.watch <= 0:
+            return 0
+        time.sleep(args.watch)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""
+Configure time-triggered injection and show how well the device's cycle
+timebase is locked (FLEXRAY_READ_TIMED_INJECTION / FLEXRAY_SET_TIMED_INJECTION).
+
+A timed rule ignores its trigger frame. The device predicts the target slot
+start from the locked cycle model and the learned schedule, and arms the
+injector with a hardware alarm lead_us before it. Keep the lead shorter than
+the gap to the previous frame on the forwarder input.
+
+Usage:
+  python3 flexray_timed_injection.py                    # lock quality and per-rule counters
+  python3 flexray_timed_injection.py --rule 0 --lead 30 # rule 0 timed, 30 us lead
+  python3 flexray_timed_injection.py --rule 0 --lead 0  # rule 0 back to its trigger frame
+  python3 flexray_timed_injection.py --watch 1
+"""
+import argparse
+import struct
+import sys
+import time
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_TIMED_INJECTION = 0x6C
+FLEXRAY_SET_TIMED_INJECTION = 0x6D
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+BM_REQUEST_TYPE_OUT_VENDOR_DEVICE = 0x40
+
+TIMEBASE_STATUS = struct.Struct("<BBHIiiIIII")    # see timebase_status_t
+TIMED_HEADER = struct.Struct("<BBH")              # see timed_injection_header_t
+TIMED_ENTRY = struct.Struct("<BBHiIIIIIII")       # see timed_injection_entry_t
+READ_SIZE = 512
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def read_timed(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_TIMED_INJECTION, 0, 0, READ_SIZE))
+    if len(raw) < TIMEBASE_STATUS.size + TIMED_HEADER.size:
+        return None, []
+    (locked, anchor_source, anchor_id, period_ns, drift_ppb, phase_err_ns,
+     jitter_avg_ns, jitter_max_ns, locks, cycles) = TIMEBASE_STATUS.unpack_from(raw, 0)
+    timebase = {'locked': bool(locked), 'anchor_id': anchor_id, 'anchor_source': anchor_source,
+                'period_ns': period_ns, 'drift_ppb': drift_ppb, 'phase_err_ns': phase_err_ns,
+                'jitter_avg_ns': jitter_avg_ns, 'jitter_max_ns': jitter_max_ns,
+                'locks': locks, 'cycles': cycles}
+    count, entry_size, _ = TIMED_HEADER.unpack_from(raw, TIMEBASE_STATUS.size)
+    entries = []
+    off = TIMEBASE_STATUS.size + TIMED_HEADER.size
+    for _ in range(count):
+        entries.append(TIMED_ENTRY.unpack_from(raw, off))
+        off += entry_size
+    return timebase, entries
+
+
+def print_timed(tb, entries):
+    state = "locked" if tb['locked'] else "acquiring"
+    print(f"timebase {state} on anchor 0x{tb['anchor_id']:03x}: period {tb['period_ns'] / 1000:.3f} us, "
+          f"drift {tb['drift_ppb'] / 1000:+.2f} ppm, phase err {tb['phase_err_ns']} ns, "
+          f"jitter avg {tb['jitter_avg_ns']} ns max {tb['jitter_max_ns']} ns, "
+          f"{tb['locks']} locks, {tb['cycles']} cycles")
+    print(f"{'rule':>4} {'lead':>5} {'offset':>7} {'planned':>8} {'skipped':>8} {'injected':>9} "
+          f"{'idle':>7} {'late':>6} {'alarm_late_us':>14}")
+    for (rule, _, lead, offset, planned, unplanned, injected, idle, late, late_avg, late_max) in entries:
+        mode = f"{lead}" if lead else "frame"
+        print(f"{rule:>4} {mode:>5} {offset:>7} {planned:>8} {unplanned:>8} {injected:>9} "
+              f"{idle:>7} {late:>6} {f'{late_avg}/{late_max}':>14}")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="pico-flexray time-triggered injection")
+    parser.add_argument("--rule", type=int, default=None, help="rule index to configure")
+    parser.add_argument("--lead", type=int, default=None, help="arm this many us before the slot (0 = frame trigger)")
+    parser.add_argument("--watch", type=float, default=0.0, help="repeat every N seconds")
+    args = parser.parse_args()
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+
+    if args.rule is not None:
+        if args.lead is None:
+            print("--rule needs --lead", file=sys.stderr)
+            return 1
+        dev.ctrl_transfer(BM_REQUEST_TYPE_OUT_VENDOR_DEVICE, FLEXRAY_SET_TIMED_INJECTION,
+                          args.rule, args.lead & 0xFFFF, b"")
+
+    while True:
+        tb, entries = read_timed(dev)
+        if tb is None:
+            print("No timed injection data", file=sys.stderr)
+            return 1
+        print_timed(tb, entries)
+        if args.watch <= 0:
+            return 0
+        time.sleep(args.watch)
+        print()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
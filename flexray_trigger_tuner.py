@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+Show per-rule injection timing from the trigger tuner (FLEXRAY_READ_TRIGGER_TUNING)
+and switch it between measure-only and automatic trigger selection.
+
+For each rule the device reports the observed slack between the end of the
+active trigger frame and the start of the target frame, the trigger-to-DMA
+latency of past injections, and the latest frame in the learned schedule that
+still leaves latency + margin before the target slot.
+
+Usage:
+  python3 flexray_trigger_tuner.py                 # print the tuning table
+  python3 flexray_trigger_tuner.py --auto          # let the device move triggers
+  python3 flexray_trigger_tuner.py --measure       # back to compiled-in triggers
+  python3 flexray_trigger_tuner.py --auto --margin 20
+"""
+import argparse
+import struct
+import sys
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+
+# Vendor extensions (see panda_usb.h)
+FLEXRAY_READ_TRIGGER_TUNING = 0x6A
+FLEXRAY_SET_TRIGGER_TUNING = 0x6B
+
+BM_REQUEST_TYPE_IN_VENDOR_DEVICE = 0xC0
+BM_REQUEST_TYPE_OUT_VENDOR_DEVICE = 0x40
+
+TUNING_HEADER = struct.Struct("<BBBB")              # see trigger_tuning_header_t
+TUNING_ENTRY = struct.Struct("<BBHHHHHiiiIIIII")    # see trigger_tuning_entry_t
+MODE_MEASURE = 0
+MODE_AUTO = 1
+NO_TRIGGER = 0xFFFF
+STATUS_NAMES = {0: "learning", 1: "ok", 2: "no-candidate", 3: "path-busy"}
+READ_SIZE = 512
+
+
+def find_device():
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        return None
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+    return dev
+
+
+def read_tuning(dev):
+    raw = bytes(dev.ctrl_transfer(BM_REQUEST_TYPE_IN_VENDOR_DEVICE, FLEXRAY_READ_TRIGGER_TUNING, 0, 0, READ_SIZE))
+    if len(raw) < TUNING_HEADER.size:
+        return None, []
+    count, entry_size, mode, margin = TUNING_HEADER.unpack_from(raw, 0)
+    entries = []
+    off = TUNING_HEADER.size
+    for _ in range(count):
+        entries.append(TUNING_ENTRY.unpack_from(raw, off))
+        off += entry_size
+    return {'mode': mode, 'margin_us': margin}, entries
+
+
+def trigger_str(frame_id):
+    return "-" if frame_id == NO_TRIGGER else f"0x{frame_id:03x}"
+
+
+def print_tuning(header, entries):
+    mode = "auto" if header['mode'] == MODE_AUTO else "measure"
+    print(f"mode {mode}, margin {header['margin_us']} us")
+    print(f"{'rule':>4} {'target':>6} {'config':>6} {'active':>6} {'recom':>6} {'slack':>6} "
+          f"{'observed_us':>14} {'n':>6} {'latency_us':>14} {'inj':>6} {'sw':>4} status")
+    for (rule, status, target, configured, active, recommended, switches, rec_slack,
+         slack_min, slack_max, slack_n, lat_min, lat_max, lat_avg, lat_n) in entries:
+        observed = f"{slack_min}..{slack_max}" if slack_n else "-"
+        latency = f"{lat_min}/{lat_avg}/{lat_max}" if lat_n else "-"
+        rec = f"{rec_slack}" if recommended != NO_TRIGGER else "-"
+        print(f"{rule:>4} {'0x%03x' % target:>6} {'0x%03x' % configured:>6} {'0x%03x' % active:>6} "
+              f"{trigger_str(recommended):>6} {rec:>6} {observed:>14} {slack_n:>6} {latency:>14} "
+              f"{lat_n:>6} {switches:>4} {STATUS_NAMES.get(status, status)}")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="pico-flexray injection trigger tuner")
+    group = parser.add_mutually_exclusive_group()
+    group.add_argument("--auto", action="store_true", help="apply recommended triggers on the device")
+    group.add_argument("--measure", action="store_true", help="recommend only, restore compiled-in triggers")
+    parser.add_argument("--margin", type=int, default=0, help="required margin beyond latency in us (0 = default)")
+    args = parser.parse_args()
+
+    dev = find_device()
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+
+    if not 0 <= args.margin <= 255:
+        print("--margin must be 0..255 us", file=sys.stderr)
+        return 1
+    if args.auto or args.measure:
+        mode = MODE_AUTO if args.auto else MODE_MEASURE
+        dev.ctrl_transfer(BM_REQUEST_TYPE_OUT_VENDOR_DEVICE, FLEXRAY_SET_TRIGGER_TUNING, mode, args.margin, b"")
+
+    header, entries = read_tuning(dev)
+    if header is None:
+        print("No tuning data", file=sys.stderr)
+        return 1
+    print_tuning(header, entries)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
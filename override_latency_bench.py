@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""
+Compare override delivery latency over the bulk OUT endpoint (0x03) and the
+interrupt OUT endpoint (0x04) while the bulk IN capture stream is drained at
+full rate by a background thread.
+
+Each probe is a ping op ([0x9F][u32 token]) sent on one of the two OUT paths;
+the device answers on the interrupt IN endpoint (0x84) with an
+INTR_MSG_PONG, so both paths share the same return leg and the difference
+between them is the OUT-side queuing. With --override the probe becomes a
+real override (op 0x9A, with a sequence number) on the interrupt path, and
+both its QUEUED ack and its APPLIED ack (the injection itself) are timed.
+
+Usage:
+  python3 override_latency_bench.py                       # 500 probes per path under load
+  python3 override_latency_bench.py --count 2000 --interval-ms 2
+  python3 override_latency_bench.py --no-load             # idle bus baseline
+"""
+import argparse
+import statistics
+import struct
+import sys
+import threading
+import time
+
+try:
+    import usb.core  # type: ignore
+except Exception:
+    print("PyUSB is required. Install with: pip install pyusb", file=sys.stderr)
+    sys.exit(1)
+
+
+PANDA_VID = 0x3801
+PANDA_PID = 0xDDCC
+EP_VENDOR_OUT = 0x03
+EP_VENDOR_IN = 0x81
+EP_OVERRIDE_OUT = 0x04
+EP_OVERRIDE_IN = 0x84
+
+OP_PING = 0x9F
+INTR_MSG = struct.Struct("<BBHIII")  # type, status, arg, token, timestamp_us, aux
+INTR_MSG_OVERRIDE_ACK = 0x01
+OVERRIDE_QUEUED = 0
+OVERRIDE_APPLIED = 1
+OVERRIDE_RESULTS = {0: "queued", 1: "applied", 2: "crc", 3: "unknown_rule", 4: "length", 5: "superseded"}
+INTR_MSG_PONG = 0x02
+
+PATHS = (("bulk", EP_VENDOR_OUT), ("interrupt", EP_OVERRIDE_OUT))
+
+
+class CaptureLoad(threading.Thread):
+    """Drain the bulk IN stream as fast as possible, like a capture client."""
+
+    def __init__(self, dev):
+        super().__init__(daemon=True)
+        self.dev = dev
+        self.bytes = 0
+        self.stop = threading.Event()
+
+    def run(self):
+        while not self.stop.is_set():
+            try:
+                self.bytes += len(self.dev.read(EP_VENDOR_IN, 16384, timeout=100))
+            except usb.core.USBTimeoutError:
+                continue
+            except usb.core.USBError:
+                break
+
+
+def wait_for(dev, msg_type, token, timeout_s, statuses=None):
+    """Read interrupt IN packets until a message of msg_type/token (and status) arrives."""
+    deadline = time.perf_counter() + timeout_s
+    while time.perf_counter() < deadline:
+        try:
+            pkt = bytes(dev.read(EP_OVERRIDE_IN, 64, timeout=max(1, int((deadline - time.perf_counter()) * 1000))))
+        except usb.core.USBTimeoutError:
+            break
+        for off in range(0, len(pkt) - INTR_MSG.size + 1, INTR_MSG.size):
+            mtype, status, arg, tok, ts, aux = INTR_MSG.unpack_from(pkt, off)
+            if mtype == msg_type and tok == token and (statuses is None or status in statuses):
+                return (status, arg, tok, ts, aux)
+    return None
+
+
+def summarize(name, samples_us, lost):
+    if not samples_us:
+        print(f"{name:>10}: no replies ({lost} lost)")
+        return
+    s = sorted(samples_us)
+    pct = lambda p: s[min(len(s) - 1, int(p / 100.0 * len(s)))]
+    print(f"{name:>10}: n={len(s)} lost={lost} min={s[0]:.0f} p50={statistics.median(s):.0f} "
+          f"p90={pct(90):.0f} p99={pct(99):.0f} max={s[-1]:.0f} us")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="pico-flexray override latency benchmark")
+    parser.add_argument("--count", type=int, default=500, help="probes per path")
+    parser.add_argument("--interval-ms", type=float, default=5.0, help="gap between probes")
+    parser.add_argument("--no-load", action="store_true", help="do not drain the bulk IN stream")
+    parser.add_argument("--override", type=str, default=None,
+                        help="id:base:hexslice, also time an interrupt-path override ack")
+    args = parser.parse_args()
+
+    dev = usb.core.find(idVendor=PANDA_VID, idProduct=PANDA_PID)
+    if dev is None:
+        print("Device not found. Is the Pico connected and running the app?", file=sys.stderr)
+        return 1
+    try:
+        if hasattr(dev, "set_configuration"):
+            dev.set_configuration()  # type: ignore[attr-defined]
+    except Exception:
+        pass
+
+    override_args = None
+    if args.override:
+        fid, base, hexslice = args.override.split(":")
+        override_args = (int(fid, 0), int(base, 0), bytes.fromhex(hexslice))
+
+    load = None
+    if not args.no_load:
+        load = CaptureLoad(dev)
+        load.start()
+        time.sleep(0.5)  # let the IN stream reach steady state
+
+    results = {name: [] for name, _ in PATHS}
+    lost = {name: 0 for name, _ in PATHS}
+    queued_us, applied_us, outcomes = [], [], {}
+    started = time.perf_counter()
+    token = 1
+    try:
+        for i in range(args.count):
+            for name, ep in PATHS:  # interleave so both paths see the same load
+                t0 = time.perf_counter_ns()
+                dev.write(ep, struct.pack("<BI", OP_PING, token), timeout=1000)
+                reply = wait_for(dev, INTR_MSG_PONG, token, 0.5)
+                if reply is None:
+                    lost[name] += 1
+                else:
+                    results[name].append((time.perf_counter_ns() - t0) / 1000.0)
+                token += 1
+                time.sleep(args.interval_ms / 1000.0)
+            if override_args is not None:
+                fid, base, payload = override_args
+                op = struct.pack("<BIHBH", 0x9A, token, fid, base, len(payload)) + payload
+                t0 = time.perf_counter_ns()
+                dev.write(EP_OVERRIDE_OUT, op, timeout=1000)
+                reply = wait_for(dev, INTR_MSG_OVERRIDE_ACK, token, 0.5)
+                if reply is not None:
+                    queued_us.append((time.perf_counter_ns() - t0) / 1000.0)
+                    if reply[0] == OVERRIDE_QUEUED:
+                        # second ack: applied (or superseded) once the slot comes round
+                        reply = wait_for(dev, INTR_MSG_OVERRIDE_ACK, token, 0.5,
+                                         statuses=set(OVERRIDE_RESULTS) - {OVERRIDE_QUEUED})
+                        if reply is not None and reply[0] == OVERRIDE_APPLIED:
+                            applied_us.append((time.perf_counter_ns() - t0) / 1000.0)
+                if reply is not None:
+                    name = OVERRIDE_RESULTS.get(reply[0], str(reply[0]))
+                    outcomes[name] = outcomes.get(name, 0) + 1
+                token += 1
+    except KeyboardInterrupt:
+        print("Interrupted")
+    finally:
+        if load is not None:
+            load.stop.set()
+            load.join(timeout=1.0)
+
+    elapsed = time.perf_counter() - started
+    if load is not None:
+        print(f"Capture load: {load.bytes / elapsed / 1024:.1f} KiB/s on bulk IN")
+    print("Ping round trip (OUT path -> interrupt IN):")
+    for name, _ in PATHS:
+        summarize(name, results[name], lost[name])
+    if override_args is not None:
+        print("Override over interrupt OUT (send -> ack):")
+        summarize("queued", queued_us, args.count - len(queued_us))
+        summarize("applied", applied_us, args.count - len(applied_us))
+        print("Outcomes: " + ", ".join(f"{k}={v}" for k, v in sorted(outcomes.items())))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
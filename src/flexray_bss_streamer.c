@@ -14,7 +14,11 @@
 #include "flexray_bss_streamer.pio.h"
 #include "flexray_bss_streamer.h"
 #include "flexray_forwarder_with_injector.h"
+#include "flexray_gateway.h"
+#include "flexray_splice.h"
+#include "flexray_frame_id_matcher.h"
 #include "flexray_frame.h"
+#include "flexray_profile.h"
 
 // --- Global State ---
 uint dma_data_from_ecu_chan;
@@ -61,9 +65,21 @@ static inline uint32_t dma_ring_write_idx(uint dma_chan, volatile uint8_t *ring_
 static volatile uint32_t ecu_prev_write_idx = 0;
 static volatile uint32_t veh_prev_write_idx = 0;
 
+uint32_t streamer_frame_start_idx(bool is_vehicle)
+{
+    return is_vehicle ? veh_prev_write_idx : ecu_prev_write_idx;
+}
+
+uint32_t streamer_write_idx(bool is_vehicle)
+{
+    return is_vehicle ? dma_ring_write_idx(dma_data_from_vehicle_chan, vehicle_ring_buffer, VEH_RING_MASK)
+                      : dma_ring_write_idx(dma_data_from_ecu_chan, ecu_ring_buffer, ECU_RING_MASK);
+}
+
 // --- Cross-core notification ring (single-producer ISR on core1, single-consumer on core0) ---
 #define NOTIFY_RING_SIZE 1024u
 static volatile uint32_t notify_ring[NOTIFY_RING_SIZE];
+static volatile uint32_t notify_end_us[NOTIFY_RING_SIZE]; // time_us_32() at ISR entry = frame end
 static volatile uint16_t notify_head = 0; // producer writes head
 static volatile uint16_t notify_tail = 0; // consumer advances tail
 static volatile uint32_t notify_dropped = 0;
@@ -78,7 +94,7 @@ void notify_queue_init(void)
     notify_dropped = 0;
 }
 
-static inline bool notify_queue_push(uint32_t value)
+static inline bool notify_queue_push(uint32_t value, uint32_t end_us)
 {
     uint16_t head = notify_head;
     uint16_t next = (uint16_t)((head + 1u) & (NOTIFY_RING_SIZE - 1u));
@@ -88,12 +104,13 @@ static inline bool notify_queue_push(uint32_t value)
         return false; // full
     }
     notify_ring[head] = value;
+    notify_end_us[head] = end_us;
     notify_head = next;
     __sev(); // wake consumer after publishing head
     return true;
 }
 
-bool notify_queue_pop(uint32_t *encoded)
+bool notify_queue_pop(uint32_t *encoded, uint32_t *end_us)
 {
     uint16_t tail = notify_tail;
     if (tail == notify_head)
@@ -101,6 +118,7 @@ bool notify_queue_pop(uint32_t *encoded)
         return false; // empty
     }
     *encoded = notify_ring[tail];
+    *end_us = notify_end_us[tail];
     notify_tail = (uint16_t)((tail + 1u) & (NOTIFY_RING_SIZE - 1u));
     return true;
 }
@@ -113,6 +131,8 @@ uint32_t notify_queue_dropped(void)
 // This is the DMA interrupt handler, which is much more efficient.
 void __time_critical_func(streamer_irq0_handler)(void)
 {
+    PROFILE_BEGIN(isr_start);
+    uint32_t end_us = time_us_32();
     // GPIO7 high indicates ISR processing; use direct SIO for minimal overhead
     sio_hw->gpio_set = (1u << 7);
     uint32_t start_idx = 0;
@@ -171,21 +191,36 @@ void __time_critical_func(streamer_irq0_handler)(void)
 
         uint8_t h0 = ring_base[(start_idx + 0) & ring_mask];
         uint8_t h1 = ring_base[(start_idx + 1) & ring_mask];
-        // uint8_t h2 = ring_base[(start_idx + 2) & ring_mask];
+        uint8_t h2 = ring_base[(start_idx + 2) & ring_mask];
         // uint8_t h3 = ring_base[(start_idx + 3) & ring_mask];
         uint8_t h4 = ring_base[(start_idx + 4) & ring_mask];
         // (void)h3; // silence unused warnings; kept for clarity/extension
         current_frame_id = (uint16_t)(((uint16_t)(h0 & 0x07) << 8) | h1);
         current_cycle_count = (uint8_t)(h4 & 0x3F);
-
-        try_inject_frame(current_frame_id, current_cycle_count);
+        // First: a blocked frame holds its forwarder until this clears it
+        matcher_frame_end(is_vehicle, current_frame_id);
+        predicate_frame_t view = {
+            .ring = ring_base,
+            .start = start_idx,
+            .mask = ring_mask,
+            .payload_bytes = (uint8_t)(((h2 >> 1) & 0x7F) * 2u),
+        };
+
+        gateway_observe(current_frame_id, current_cycle_count, is_vehicle ? FROM_VEHICLE : FROM_ECU, &view);
+        // Before try_inject_frame, which may arm a splice for the next frame
+        splice_frame_end(is_vehicle);
+
+        PROFILE_BEGIN(inject_start);
+        try_inject_frame(current_frame_id, current_cycle_count, end_us, &view);
+        PROFILE_END(PROFILE_TRY_INJECT_FRAME, inject_start);
     }
 
     // Encode: [31]=source(1=VEH), [30:12]=seq(19 bits), [11:0]=ring index (4KB ring)
     uint32_t encoded = notify_encode(is_vehicle, ((irq_counter++) & 0x7FFFF), idx);
-    (void)notify_queue_push(encoded);
+    (void)notify_queue_push(encoded, end_us);
     // Set GPIO7 low to indicate ISR exit (idle)
     sio_hw->gpio_clr = (1u << 7);
+    PROFILE_END(PROFILE_STREAMER_ISR, isr_start);
 }
 
 void setup_stream(PIO pio,
@@ -254,6 +289,8 @@ void setup_stream(PIO pio,
     irq_set_exclusive_handler(pio_get_irq_num(pio, 0), streamer_irq0_handler);
     irq_set_enabled(pio_get_irq_num(pio, 0), true);
 
+    matcher_setup(pio, sm_from_ecu, rx_pin_from_ecu, sm_from_vehicle, rx_pin_from_vehicle);
+
     pio_interrupt_clear(pio, 3);
     pio_interrupt_clear(pio, 7);
     pio_sm_set_enabled(pio, sm_from_ecu, true);
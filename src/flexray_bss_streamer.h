@@ -33,9 +33,15 @@ void setup_stream(PIO pio,
                   uint rx_pin_from_ecu, uint tx_en_pin_to_vehicle,
                   uint rx_pin_from_vehicle, uint tx_en_pin_to_ecu);
 
+// Core1, for work on the frame now on the bus: ring index of its first byte
+// (the previous frame's end) and of the next byte the DMA will write
+uint32_t streamer_frame_start_idx(bool is_vehicle);
+uint32_t streamer_write_idx(bool is_vehicle);
+
 // --- Cross-core notification ring (single producer on core1 ISR, single consumer on core0) ---
 // Encoded format: [31]=source(1=VEH), [30:12]=seq(19 bits), [11:0]=ring index
-bool notify_queue_pop(uint32_t *encoded);
+// end_us: time_us_32() taken on ISR entry, i.e. just after the frame ended
+bool notify_queue_pop(uint32_t *encoded, uint32_t *end_us);
 void notify_queue_init(void);
 uint32_t notify_queue_dropped(void);
 
@@ -0,0 +1,160 @@
+#include "flexray_cycle_snapshot.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "flexray_filter.h"
+
+// Per direction, one buffer is being filled while the other holds the last
+// sealed record until the USB send path releases it. Everything runs on
+// core0 (parse loop and TinyUSB callbacks), so no locking is needed.
+
+#define SNAPSHOT_HEADER_BYTES 8u // len(2) + kind|src + cycle + first_id(2) + slot_count(2)
+#define SNAPSHOT_SLOT_BYTES   7u // len + indicators + header crc(2) + frame crc(3)
+#define SNAPSHOT_FIRST_ID     1u
+#define SNAPSHOT_MAX_SLOTS    (FLEXRAY_MAX_FRAME_ID - 1u)
+
+typedef struct {
+    uint8_t data[SNAPSHOT_MAX_RECORD_BYTES];
+    uint16_t len;     // bytes used, including the length prefix
+    int16_t cycle;    // cycle being collected, -1 when idle
+    uint16_t last_id; // highest ID added, entries must ascend
+    uint16_t entries;
+    uint32_t seq;     // seal order, oldest ready record goes first
+    uint32_t fifo_mark;
+} snapshot_buf_t;
+
+static snapshot_buf_t snapshot_bufs[2][2]; // [source][buffer]
+static uint8_t build_idx[2];
+static bool ready_valid[2];
+static bool snapshot_enabled = false;
+static uint16_t snapshot_slots = 0;
+static uint16_t bitmap_bytes = 0;
+static uint32_t seal_seq = 0;
+static cycle_snapshot_stats_t snapshot_stats;
+
+static void snapshot_start(snapshot_buf_t *b, uint8_t source, uint8_t cycle)
+{
+    b->data[2] = (uint8_t)((STREAM_RECORD_CYCLE_SNAPSHOT << STREAM_RECORD_KIND_SHIFT) | (source & STREAM_RECORD_SOURCE_MASK));
+    b->data[3] = cycle;
+    b->data[4] = (uint8_t)(SNAPSHOT_FIRST_ID & 0xFF);
+    b->data[5] = (uint8_t)(SNAPSHOT_FIRST_ID >> 8);
+    b->data[6] = (uint8_t)(snapshot_slots & 0xFF);
+    b->data[7] = (uint8_t)(snapshot_slots >> 8);
+    memset(&b->data[SNAPSHOT_HEADER_BYTES], 0, bitmap_bytes);
+    b->len = (uint16_t)(SNAPSHOT_HEADER_BYTES + bitmap_bytes);
+    b->cycle = cycle;
+    b->last_id = 0;
+    b->entries = 0;
+}
+
+static void snapshot_seal(uint8_t source, uint32_t fifo_mark)
+{
+    snapshot_buf_t *b = &snapshot_bufs[source][build_idx[source]];
+    uint16_t body_len = (uint16_t)(b->len - 2u);
+    b->data[0] = (uint8_t)(body_len & 0xFF);
+    b->data[1] = (uint8_t)(body_len >> 8);
+    b->seq = seal_seq++;
+    b->fifo_mark = fifo_mark;
+    if (ready_valid[source]) {
+        snapshot_stats.replaced++;
+    }
+    build_idx[source] ^= 1u;
+    ready_valid[source] = true;
+    snapshot_stats.snapshots++;
+}
+
+void cycle_snapshot_configure(bool enable, uint16_t last_static_id)
+{
+    if (last_static_id > SNAPSHOT_MAX_SLOTS) {
+        last_static_id = SNAPSHOT_MAX_SLOTS;
+    }
+    snapshot_enabled = enable && last_static_id > 0;
+    snapshot_slots = last_static_id;
+    bitmap_bytes = (uint16_t)((last_static_id + 7u) / 8u);
+    for (uint32_t src = 0; src < 2; src++) {
+        snapshot_bufs[src][0].cycle = -1;
+        snapshot_bufs[src][1].cycle = -1;
+        build_idx[src] = 0;
+        ready_valid[src] = false;
+    }
+    memset(&snapshot_stats, 0, sizeof(snapshot_stats));
+}
+
+bool __not_in_flash_func(cycle_snapshot_add)(const flexray_frame_t *frame, uint32_t fifo_pushed)
+{
+    if (!snapshot_enabled || frame->frame_id < SNAPSHOT_FIRST_ID || frame->frame_id > snapshot_slots) {
+        return false;
+    }
+    uint8_t source = frame->source & 1u;
+    snapshot_buf_t *b = &snapshot_bufs[source][build_idx[source]];
+
+    if (b->cycle != (int16_t)frame->cycle_count) {
+        // New cycle on this direction: the previous one is complete
+        if (b->cycle >= 0 && b->entries > 0) {
+            snapshot_seal(source, fifo_pushed);
+            b = &snapshot_bufs[source][build_idx[source]];
+        }
+        snapshot_start(b, source, frame->cycle_count);
+    }
+
+    if (frame->frame_id <= b->last_id) {
+        snapshot_stats.out_of_order++;
+        return false;
+    }
+    uint16_t payload_len = (uint16_t)(frame->payload_length_words * 2u);
+    if ((uint32_t)b->len + SNAPSHOT_SLOT_BYTES + payload_len > SNAPSHOT_MAX_RECORD_BYTES) {
+        snapshot_stats.overflow++;
+        return false;
+    }
+
+    uint16_t bit = (uint16_t)(frame->frame_id - SNAPSHOT_FIRST_ID);
+    b->data[SNAPSHOT_HEADER_BYTES + (bit >> 3)] |= (uint8_t)(1u << (bit & 7u));
+    b->data[b->len++] = frame->payload_length_words;
+    b->data[b->len++] = frame->indicators;
+    b->data[b->len++] = (uint8_t)(frame->header_crc & 0xFF);
+    b->data[b->len++] = (uint8_t)(frame->header_crc >> 8);
+    b->data[b->len++] = (uint8_t)((frame->frame_crc >> 16) & 0xFF);
+    b->data[b->len++] = (uint8_t)((frame->frame_crc >> 8) & 0xFF);
+    b->data[b->len++] = (uint8_t)(frame->frame_crc & 0xFF);
+    memcpy(&b->data[b->len], frame->payload, payload_len);
+    b->len = (uint16_t)(b->len + payload_len);
+    b->last_id = frame->frame_id;
+    b->entries++;
+    return true;
+}
+
+uint16_t cycle_snapshot_peek(const uint8_t **record, uint32_t *fifo_mark)
+{
+    int best = -1;
+    for (int src = 0; src < 2; src++) {
+        if (!ready_valid[src]) {
+            continue;
+        }
+        if (best < 0 || (int32_t)(snapshot_bufs[src][build_idx[src] ^ 1u].seq -
+                                  snapshot_bufs[best][build_idx[best] ^ 1u].seq) < 0) {
+            best = src;
+        }
+    }
+    if (best < 0) {
+        return 0;
+    }
+    const snapshot_buf_t *b = &snapshot_bufs[best][build_idx[best] ^ 1u];
+    *record = b->data;
+    *fifo_mark = b->fifo_mark;
+    return b->len;
+}
+
+void cycle_snapshot_release(void)
+{
+    const uint8_t *record;
+    uint32_t fifo_mark;
+    if (cycle_snapshot_peek(&record, &fifo_mark) == 0) {
+        return;
+    }
+    uint8_t source = record[2] & 1u;
+    ready_valid[source] = false;
+}
+
+void cycle_snapshot_get_stats(cycle_snapshot_stats_t *out)
+{
+    *out = snapshot_stats;
+}
@@ -0,0 +1,45 @@
+#ifndef FLEXRAY_CYCLE_SNAPSHOT_H
+#define FLEXRAY_CYCLE_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flexray_frame.h"
+#include "flexray_stream_codec.h"
+
+// Cycle snapshot mode (op 0x99): static-slot frames (IDs 1..last_static_id)
+// of one communication cycle and direction are packed into a single record,
+// sealed when that direction's cycle_count changes. Other IDs keep streaming
+// as per-frame records. Record kind STREAM_RECORD_CYCLE_SNAPSHOT:
+//
+//   [u16 body_len][src|0xC0][u8 cycle][u16 first_id][u16 slot_count]
+//   [bitmap, ceil(slot_count/8) bytes, bit i = first_id + i present]
+//   per present slot, ascending:
+//     [u8 payload_len_words][u8 indicators][u16 header_crc][3B frame_crc][payload]
+//
+// A record is sealed behind the per-frame records already queued: the send
+// path holds it until the USB FIFO has popped fifo_mark frames in total.
+
+#define SNAPSHOT_MAX_RECORD_BYTES 3072u
+
+typedef struct {
+    uint32_t snapshots;        // records sealed
+    uint32_t replaced;         // sealed records overwritten before USB took them
+    uint32_t overflow;         // frames that did not fit and went out per-frame
+    uint32_t out_of_order;     // frames not ascending within a cycle, sent per-frame
+} cycle_snapshot_stats_t;
+
+void cycle_snapshot_configure(bool enable, uint16_t last_static_id);
+
+// Core0 parse loop. Returns true if the frame was taken into a snapshot,
+// false if it should be streamed as a normal record. fifo_pushed is
+// panda_flexray_fifo_pushed(), the mark of a record this call seals.
+bool cycle_snapshot_add(const flexray_frame_t *frame, uint32_t fifo_pushed);
+
+// USB send path: oldest sealed record ([u16 len][body]) or 0 if none;
+// call cycle_snapshot_release() once it has been queued.
+uint16_t cycle_snapshot_peek(const uint8_t **record, uint32_t *fifo_mark);
+void cycle_snapshot_release(void);
+
+void cycle_snapshot_get_stats(cycle_snapshot_stats_t *out);
+
+#endif // FLEXRAY_CYCLE_SNAPSHOT_H
@@ -0,0 +1,285 @@
+#include "flexray_e2e.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "flexray_frame.h"
+#include "flexray_injector_rules.h"
+
+// Double-buffered per rule like flexray_predicate.c, with its reload guard:
+// the active copy is gen & 1, core1 flags each use (`reading`) and publishes
+// the generation it picked up (`seen`), and core0 refuses a reload while
+// core1 may still be on the copy it would overwrite. Seeds are derived from
+// the configuration on core0 and published with it.
+typedef struct {
+    e2e_config_t cfg;
+    uint8_t header;               // profile header bytes, the least an area can hold
+    uint8_t seed[16];             // P01: CRC state after the DataID, per counter
+} e2e_active_t;
+
+typedef struct {
+    e2e_active_t c[2];
+    volatile uint32_t gen;        // core0
+    volatile uint32_t seen;       // core1: last gen it used
+    volatile uint8_t reading;     // core1: e2e_protect in progress
+    volatile uint32_t rejected;   // core1: frames whose E2E area did not fit
+} e2e_slot_t;
+
+static e2e_slot_t slots[NUM_TRIGGER_RULES]; // zero = E2E_PROFILE_RULE
+
+static uint8_t crc8h2f_table[256];
+static uint16_t crc16_table[256];
+static uint64_t crc64_table[256];
+static bool have_crc8h2f = false;
+static bool have_crc16 = false;
+static bool have_crc64 = false;
+
+static void build_tables(uint8_t profile)
+{
+    if (profile == E2E_PROFILE_P02 && !have_crc8h2f) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint8_t c = (uint8_t)i;
+            for (int b = 0; b < 8; b++) c = (uint8_t)((c & 0x80u) ? ((unsigned)c << 1) ^ 0x2Fu : (unsigned)c << 1);
+            crc8h2f_table[i] = c;
+        }
+        have_crc8h2f = true;
+    } else if (profile == E2E_PROFILE_P05 && !have_crc16) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint16_t c = (uint16_t)(i << 8);
+            for (int b = 0; b < 8; b++) c = (uint16_t)((c & 0x8000u) ? ((unsigned)c << 1) ^ 0x1021u : (unsigned)c << 1);
+            crc16_table[i] = c;
+        }
+        have_crc16 = true;
+    } else if (profile == E2E_PROFILE_P07 && !have_crc64) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint64_t c = i;
+            for (int b = 0; b < 8; b++) c = (c & 1u) ? (c >> 1) ^ 0xC96C5795D7870F42ull : c >> 1;
+            crc64_table[i] = c;
+        }
+        have_crc64 = true;
+    }
+}
+
+static void p01_seeds(const e2e_config_t *cfg, uint8_t *seed)
+{
+    uint8_t lo = (uint8_t)cfg->data_id;
+    uint8_t hi = (uint8_t)(cfg->data_id >> 8);
+    for (uint8_t c = 0; c < 16; c++) {
+        uint8_t id[2];
+        uint8_t n;
+        switch (cfg->data_id_mode) {
+        case E2E_P01_DATAID_ALT:    id[0] = (c & 1u) ? hi : lo; n = 1; break;
+        case E2E_P01_DATAID_LOW:    id[0] = lo; n = 1; break;
+        case E2E_P01_DATAID_NIBBLE: id[0] = lo; id[1] = 0; n = 2; break;
+        default:                    id[0] = lo; id[1] = hi; n = 2; break;
+        }
+        seed[c] = calculate_autosar_e2e_crc8(id, 0x00, n);
+    }
+}
+
+e2e_config_result_t e2e_configure(uint8_t rule, const e2e_config_t *cfg)
+{
+    if (rule >= NUM_TRIGGER_RULES) {
+        return E2E_CONFIG_INVALID;
+    }
+    uint32_t header;
+    switch (cfg->profile) {
+    case E2E_PROFILE_RULE:
+    case E2E_PROFILE_NONE:
+        header = 0;
+        break;
+    case E2E_PROFILE_P01:
+        if (cfg->data_id_mode > E2E_P01_DATAID_NIBBLE || (cfg->counter_bit & 3u) || (cfg->nibble_bit & 3u)) {
+            return false;
+        }
+        header = 1u + (cfg->counter_bit / 8u > cfg->nibble_bit / 8u ? cfg->counter_bit / 8u : cfg->nibble_bit / 8u);
+        break;
+    case E2E_PROFILE_P02:
+        header = 2;
+        break;
+    case E2E_PROFILE_P05:
+        header = 3;
+        break;
+    case E2E_PROFILE_P07:
+        header = E2E_P07_HEADER_BYTES;
+        break;
+    default:
+        return false;
+    }
+    if ((uint32_t)cfg->offset + (cfg->length ? cfg->length : header) > MAX_FRAME_PAYLOAD_BYTES ||
+        (cfg->length && cfg->length < header)) {
+        return false;
+    }
+    e2e_slot_t *slot = &slots[rule];
+    uint32_t gen = slot->gen;
+    if (__atomic_load_n(&slot->seen, __ATOMIC_SEQ_CST) != gen &&
+        __atomic_load_n(&slot->reading, __ATOMIC_SEQ_CST)) {
+        return E2E_CONFIG_BUSY;
+    }
+    build_tables(cfg->profile);
+
+    e2e_active_t *next = &slot->c[(gen + 1u) & 1u];
+    next->cfg = *cfg;
+    next->cfg.rejected = 0;
+    next->header = (uint8_t)header;
+    if (cfg->profile == E2E_PROFILE_P01) {
+        p01_seeds(cfg, next->seed);
+    }
+    __atomic_store_n(&slot->gen, gen + 1u, __ATOMIC_SEQ_CST);
+    return E2E_CONFIG_OK;
+}
+
+uint16_t e2e_read(uint8_t *out, uint16_t cap)
+{
+    uint16_t w = 0;
+    for (uint32_t i = 0; i < NUM_TRIGGER_RULES && (uint32_t)w + sizeof(e2e_config_t) <= cap; i++) {
+        e2e_config_t cfg = slots[i].c[slots[i].gen & 1u].cfg;
+        uint32_t rejected = slots[i].rejected;
+        cfg.rejected = rejected > 0xFFFFu ? 0xFFFFu : (uint16_t)rejected;
+        memcpy(&out[w], &cfg, sizeof(cfg));
+        w = (uint16_t)(w + sizeof(cfg));
+    }
+    return w;
+}
+
+void e2e_area(uint8_t rule, uint32_t *offset, uint32_t *len)
+{
+    const e2e_active_t *a = &slots[rule].c[slots[rule].gen & 1u];
+    if (a->cfg.profile == E2E_PROFILE_RULE) {
+        *offset = INJECT_TRIGGERS[rule].e2e_offset;
+        *len = INJECT_TRIGGERS[rule].e2e_len + 1u;
+    } else if (a->cfg.profile == E2E_PROFILE_NONE) {
+        *offset = 0;
+        *len = 0;
+    } else {
+        *offset = a->cfg.offset;
+        *len = a->cfg.length ? a->cfg.length : a->header;
+    }
+}
+
+static inline uint8_t get_nibble(const uint8_t *area, uint8_t bit)
+{
+    return (uint8_t)((area[bit >> 3] >> (bit & 7u)) & 0x0Fu);
+}
+
+static inline void set_nibble(uint8_t *area, uint8_t bit, uint8_t v)
+{
+    uint8_t shift = bit & 7u;
+    area[bit >> 3] = (uint8_t)((area[bit >> 3] & ~(0x0Fu << shift)) | ((v & 0x0Fu) << shift));
+}
+
+static inline uint32_t get_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static bool __time_critical_func(protect_rule)(uint8_t rule, uint8_t *payload, uint16_t payload_len)
+{
+    const trigger_rule_t *r = &INJECT_TRIGGERS[rule];
+    if ((uint32_t)r->e2e_offset + r->e2e_len + 1u > payload_len) {
+        return false;
+    }
+    uint8_t *area = payload + r->e2e_offset;
+    // advance e2e alive counter lower nibble
+    uint8_t nibble = (area[1] & 0x0F) + 1;
+    if (nibble == 0x0F) {
+        nibble = 0;
+    }
+    area[1] = (area[1] & 0xF0) | (nibble & 0x0F);
+    area[0] = calculate_autosar_e2e_crc8(area + 1, r->e2e_init_value, r->e2e_len);
+    return true;
+}
+
+static void __time_critical_func(protect)(uint8_t rule, e2e_slot_t *slot, const e2e_active_t *a,
+                                         uint8_t *payload, uint16_t payload_len)
+{
+    const e2e_config_t *cfg = &a->cfg;
+    if (cfg->profile == E2E_PROFILE_RULE) {
+        if (!protect_rule(rule, payload, payload_len)) {
+            slot->rejected++;
+        }
+        return;
+    }
+    if (cfg->profile == E2E_PROFILE_NONE) {
+        return;
+    }
+    // A "rest of the payload" area is only known here: it must still hold
+    // the profile header, or P01/P05/P07 would write past the payload
+    uint32_t len = cfg->length ? cfg->length : (cfg->offset < payload_len ? (uint32_t)(payload_len - cfg->offset) : 0u);
+    if (cfg->offset + len > payload_len || len < a->header) {
+        slot->rejected++;
+        return;
+    }
+    uint8_t *area = payload + cfg->offset;
+
+    switch (cfg->profile) {
+    case E2E_PROFILE_P01: {
+        uint8_t counter = get_nibble(area, cfg->counter_bit) + 1u;
+        if (counter >= 15u) {
+            counter = 0;
+        }
+        set_nibble(area, cfg->counter_bit, counter);
+        if (cfg->data_id_mode == E2E_P01_DATAID_NIBBLE) {
+            set_nibble(area, cfg->nibble_bit, (uint8_t)(cfg->data_id >> 8));
+        }
+        area[0] = calculate_autosar_e2e_crc8(area + 1, a->seed[counter], (uint8_t)(len - 1u));
+        break;
+    }
+    case E2E_PROFILE_P02: {
+        uint8_t counter = (uint8_t)((area[1] + 1u) & 0x0Fu);
+        area[1] = (uint8_t)((area[1] & 0xF0u) | counter);
+        uint8_t crc = 0xFF;
+        for (uint32_t k = 1; k < len; k++) {
+            crc = crc8h2f_table[crc ^ area[k]];
+        }
+        crc = crc8h2f_table[crc ^ cfg->data_id_list[counter]];
+        area[0] = (uint8_t)(crc ^ 0xFFu);
+        break;
+    }
+    case E2E_PROFILE_P05: {
+        area[2] = (uint8_t)(area[2] + 1u);
+        uint16_t crc = 0xFFFF;
+        for (uint32_t k = 2; k < len; k++) {
+            crc = (uint16_t)((crc << 8) ^ crc16_table[(uint8_t)((crc >> 8) ^ area[k])]);
+        }
+        crc = (uint16_t)((crc << 8) ^ crc16_table[(uint8_t)((crc >> 8) ^ (uint8_t)cfg->data_id)]);
+        crc = (uint16_t)((crc << 8) ^ crc16_table[(uint8_t)((crc >> 8) ^ (uint8_t)(cfg->data_id >> 8))]);
+        area[0] = (uint8_t)crc;
+        area[1] = (uint8_t)(crc >> 8);
+        break;
+    }
+    case E2E_PROFILE_P07: {
+        put_be32(area + 8, len);
+        put_be32(area + 12, get_be32(area + 12) + 1u);
+        put_be32(area + 16, cfg->data_id);
+        uint64_t crc = ~0ull;
+        for (uint32_t k = 8; k < len; k++) {
+            crc = crc64_table[(uint8_t)(crc ^ area[k])] ^ (crc >> 8);
+        }
+        crc = ~crc;
+        put_be32(area, (uint32_t)(crc >> 32));
+        put_be32(area + 4, (uint32_t)crc);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void __time_critical_func(e2e_protect)(uint8_t rule, uint8_t *payload, uint16_t payload_len)
+{
+    e2e_slot_t *slot = &slots[rule];
+    __atomic_store_n(&slot->reading, 1, __ATOMIC_SEQ_CST);
+    uint32_t gen = __atomic_load_n(&slot->gen, __ATOMIC_SEQ_CST);
+    if (gen != slot->seen) {
+        __atomic_store_n(&slot->seen, gen, __ATOMIC_RELEASE);
+    }
+    protect(rule, slot, &slot->c[gen & 1u], payload, payload_len);
+    __atomic_store_n(&slot->reading, 0, __ATOMIC_RELEASE);
+}
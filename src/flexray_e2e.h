@@ -0,0 +1,80 @@
+#ifndef FLEXRAY_E2E_H
+#define FLEXRAY_E2E_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// E2E protection of injected frames, selectable per injection rule. fire_rule
+// calls e2e_protect() after all overrides are in the template: it advances
+// the counter found in the template (the ECU's last value) and rewrites the
+// CRC, before the FlexRay frame CRC is refreshed.
+//
+// The E2E area starts at payload byte `offset` with the profile header:
+//   RULE  the trigger_rule_t scheme: CRC8 0x1D seeded with e2e_init_value at
+//         e2e_offset, low-nibble counter 0..14 in the next byte
+//   P01   CRC8 0x1D (start 0x00) over the DataID bytes of the data_id_mode,
+//         then the area without the CRC byte; 4-bit counter 0..14 at
+//         counter_bit; NIBBLE mode also writes DataID bits 8..11 at nibble_bit
+//   P02   CRC8 0x2F over the area after the CRC byte, then
+//         data_id_list[counter]; counter 0..15 in the low nibble of byte 1
+//   P05   CRC16 CCITT-FALSE over the area after the CRC (bytes 0-1, little
+//         endian), then the DataID low and high byte; 8-bit counter in byte 2
+//   P07   CRC64 (ECMA, reflected) over the area after the CRC (bytes 0-7);
+//         big-endian Length, 32-bit Counter and DataID fields follow it
+//
+// The DataID part of P01 comes first, so configuring a rule folds it into a
+// CRC seed per counter value and the ISR only runs over the payload bytes.
+// P02/P05/P07 append the DataID or carry it in the data, which costs the ISR
+// at most two extra bytes. Tables for the CRC8 0x2F, CRC16 and CRC64
+// polynomials are built the first time a rule selects that profile.
+//
+// Op 0xA0 sets a rule's e2e_config_t; FLEXRAY_READ_E2E reads them back.
+
+#define E2E_PROFILE_RULE 0x00
+#define E2E_PROFILE_P01  0x01
+#define E2E_PROFILE_P02  0x02
+#define E2E_PROFILE_P05  0x05
+#define E2E_PROFILE_P07  0x07
+#define E2E_PROFILE_NONE 0xFF     // frame CRC only
+
+typedef enum {
+    E2E_P01_DATAID_BOTH = 0,      // low byte, then high byte
+    E2E_P01_DATAID_ALT = 1,       // low byte on even counters, high byte on odd
+    E2E_P01_DATAID_LOW = 2,       // low byte only
+    E2E_P01_DATAID_NIBBLE = 3,    // low byte, then 0x00; bits 8..11 sent in the data
+} e2e_p01_dataid_mode_t;
+
+#define E2E_P07_HEADER_BYTES 20u
+
+typedef struct __attribute__((packed)) {
+    uint8_t profile;              // E2E_PROFILE_*
+    uint8_t data_id_mode;         // P01: e2e_p01_dataid_mode_t
+    uint8_t offset;               // payload byte where the E2E header starts
+    uint8_t length;               // E2E area bytes including the header, 0 = rest of the payload
+    uint8_t counter_bit;          // P01: counter bit offset in the area, multiple of 4 (AUTOSAR default 8)
+    uint8_t nibble_bit;           // P01 NIBBLE: DataID nibble bit offset, multiple of 4 (default 12)
+    uint16_t rejected;            // readback only: injections left unprotected because
+                                  // the area did not fit the payload (saturates); send 0
+    uint32_t data_id;             // P01/P05: 16 bits, P07: 32 bits
+    uint8_t data_id_list[16];     // P02
+} e2e_config_t;
+
+typedef enum {
+    E2E_CONFIG_OK = 0,
+    E2E_CONFIG_INVALID,
+    E2E_CONFIG_BUSY,              // core1 may still use the copy a reload would overwrite
+} e2e_config_result_t;
+
+// Core0 (USB). Unless E2E_CONFIG_OK the rule keeps its old configuration.
+e2e_config_result_t e2e_configure(uint8_t rule, const e2e_config_t *cfg);
+// e2e_config_t per rule
+uint16_t e2e_read(uint8_t *out, uint16_t cap);
+// Core0: payload bytes of the rule's active E2E area, its length or else the
+// profile header; len 0 if the rule is not protected.
+void e2e_area(uint8_t rule, uint32_t *offset, uint32_t *len);
+
+// Core1, from fire_rule. An area that does not fit the payload, or is
+// shorter than the profile header, is left alone and counted as rejected.
+void e2e_protect(uint8_t rule, uint8_t *payload, uint16_t payload_len);
+
+#endif // FLEXRAY_E2E_H
@@ -1,11 +1,9 @@
 #include "flexray_fifo.h"
 #include "pico/sync.h"
 #include <string.h>
-#include <stdio.h>
 
 void flexray_fifo_init(flexray_fifo_t *fifo) {
     memset(fifo, 0, sizeof(*fifo));
-    printf("FlexRay FIFO initialized\n");
 }
 
 bool flexray_fifo_is_empty(const flexray_fifo_t *fifo) {
@@ -37,6 +35,14 @@ bool flexray_fifo_push(flexray_fifo_t *fifo, const flexray_frame_t *frame) {
     return true;
 }
 
+bool flexray_fifo_push_limited(flexray_fifo_t *fifo, const flexray_frame_t *frame, uint32_t max_count) {
+    if (flexray_fifo_count(fifo) >= max_count) {
+        fifo->stats.frames_dropped++;
+        return false;
+    }
+    return flexray_fifo_push(fifo, frame);
+}
+
 bool flexray_fifo_pop(flexray_fifo_t *fifo, flexray_frame_t *frame) {
     if (flexray_fifo_is_empty(fifo)) {
         return false; // FIFO empty
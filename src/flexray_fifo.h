@@ -21,6 +21,10 @@ typedef struct {
 
 void flexray_fifo_init(flexray_fifo_t *fifo);
 bool flexray_fifo_push(flexray_fifo_t *fifo, const flexray_frame_t *frame);
+// Push only while fewer than max_count frames are queued (QoS reserves)
+bool flexray_fifo_push_limited(flexray_fifo_t *fifo, const flexray_frame_t *frame, uint32_t max_count);
+// Usable slots (one is kept empty to tell full from empty)
+#define FLEXRAY_FIFO_CAPACITY (FLEXRAY_FIFO_SIZE - 1u)
 bool flexray_fifo_pop(flexray_fifo_t *fifo, flexray_frame_t *frame);
 // Peek the frame at the head without removing it. Returns false if empty.
 bool flexray_fifo_peek(const flexray_fifo_t *fifo, flexray_frame_t *frame);
@@ -0,0 +1,87 @@
+#include "flexray_filter.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+
+// Null Frame Indicator within flexray_frame_t.indicators (header[0] >> 3):
+// 0 means the frame is a null frame.
+#define INDICATOR_NULL_FRAME_BIT 0x04
+
+static stream_filter_rule_t filter_rules[FLEXRAY_MAX_FRAME_ID];
+static uint8_t filter_flags = 0;
+static stream_filter_stats_t filter_stats;
+static bool filter_initialized = false;
+
+void stream_filter_reset(uint8_t default_dir_mask, uint8_t flags)
+{
+    for (uint32_t id = 0; id < FLEXRAY_MAX_FRAME_ID; id++) {
+        filter_rules[id] = (stream_filter_rule_t){
+            .dir_mask = (uint8_t)(default_dir_mask & FILTER_DIR_ALL),
+            .cycle_mask = 0,
+            .cycle_base = 0,
+            .decimation = 1,
+        };
+    }
+    memset(&filter_stats, 0, sizeof(filter_stats));
+    filter_flags = flags;
+    filter_initialized = true;
+}
+
+bool stream_filter_set_rule(uint16_t frame_id, const stream_filter_rule_t *rule)
+{
+    if (frame_id >= FLEXRAY_MAX_FRAME_ID || rule == NULL) {
+        return false;
+    }
+    if (!filter_initialized) {
+        stream_filter_reset(FILTER_DIR_ALL, 0);
+    }
+    filter_rules[frame_id] = *rule;
+    filter_rules[frame_id].dir_mask &= FILTER_DIR_ALL;
+    filter_rules[frame_id].cycle_base &= filter_rules[frame_id].cycle_mask;
+    return true;
+}
+
+void stream_filter_load_bitmap(uint16_t first_id, const uint8_t *bitmap, uint16_t nbytes, uint8_t dir_mask)
+{
+    if (!filter_initialized) {
+        stream_filter_reset(FILTER_DIR_ALL, 0);
+    }
+    for (uint32_t bit = 0; bit < (uint32_t)nbytes * 8u; bit++) {
+        uint32_t id = first_id + bit;
+        if (id >= FLEXRAY_MAX_FRAME_ID) {
+            break;
+        }
+        bool set = (bitmap[bit >> 3] >> (bit & 7u)) & 1u;
+        filter_rules[id].dir_mask = set ? (uint8_t)(dir_mask & FILTER_DIR_ALL) : 0;
+    }
+}
+
+bool __not_in_flash_func(stream_filter_accept)(uint16_t frame_id, uint8_t cycle_count, uint8_t source, uint8_t indicators)
+{
+    if (!filter_initialized || frame_id >= FLEXRAY_MAX_FRAME_ID || source > FROM_VEHICLE) {
+        return true;
+    }
+    const stream_filter_rule_t *rule = &filter_rules[frame_id];
+    if (!(rule->dir_mask & (1u << source))) {
+        filter_stats.dropped_id++;
+        return false;
+    }
+    if ((filter_flags & FILTER_FLAG_DROP_NULL_FRAMES) && !(indicators & INDICATOR_NULL_FRAME_BIT)) {
+        filter_stats.dropped_null++;
+        return false;
+    }
+    if ((uint8_t)(cycle_count & rule->cycle_mask) != rule->cycle_base) {
+        filter_stats.dropped_cycle++;
+        return false;
+    }
+    // Stateless, phased on cycle_base: a corrupt frame cannot shift it
+    if (rule->decimation > 1 && cycle_count % rule->decimation != rule->cycle_base % rule->decimation) {
+        filter_stats.dropped_decimated++;
+        return false;
+    }
+    return true;
+}
+
+void stream_filter_get_stats(stream_filter_stats_t *out)
+{
+    memcpy(out, &filter_stats, sizeof(*out));
+}
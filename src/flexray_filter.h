@@ -0,0 +1,50 @@
+#ifndef FLEXRAY_FILTER_H
+#define FLEXRAY_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flexray_frame.h"
+
+// Host-configurable stream filter, applied in the main loop to validated
+// frames before they are copied into the USB FIFO. It only decides what is
+// streamed to the host; the frame table and injection caching are unaffected.
+
+#define FLEXRAY_MAX_FRAME_ID 2048
+
+// dir_mask bits, indexed by frame source
+#define FILTER_DIR_ECU      (1u << FROM_ECU)
+#define FILTER_DIR_VEHICLE  (1u << FROM_VEHICLE)
+#define FILTER_DIR_ALL      (FILTER_DIR_ECU | FILTER_DIR_VEHICLE)
+
+// Global flags
+#define FILTER_FLAG_DROP_NULL_FRAMES 0x01
+
+typedef struct {
+    uint8_t dir_mask;   // directions streamed for this ID (0 = never)
+    uint8_t cycle_mask; // streamed when (cycle_count & cycle_mask) == cycle_base
+    uint8_t cycle_base;
+    uint8_t decimation; // stream cycles with cycle_count % N == cycle_base % N (0/1 = all);
+                        // N should divide 64 for an even rate
+} stream_filter_rule_t;
+
+typedef struct {
+    uint32_t dropped_id;        // ID/direction not enabled
+    uint32_t dropped_cycle;     // cycle mask/base mismatch
+    uint32_t dropped_decimated; // skipped by decimation
+    uint32_t dropped_null;      // null frames with FILTER_FLAG_DROP_NULL_FRAMES
+} stream_filter_stats_t;
+
+// Give every ID the same rule: all cycles, no decimation, streamed in
+// default_dir_mask directions. Boot default is FILTER_DIR_ALL with no flags.
+void stream_filter_reset(uint8_t default_dir_mask, uint8_t flags);
+bool stream_filter_set_rule(uint16_t frame_id, const stream_filter_rule_t *rule);
+// Load a frame-ID bitmap (bit i of bitmap = first_id + i, LSB first): set
+// bits stream in dir_mask directions, clear bits are disabled.
+void stream_filter_load_bitmap(uint16_t first_id, const uint8_t *bitmap, uint16_t nbytes, uint8_t dir_mask);
+
+// Hot path: header fields only, no state.
+bool stream_filter_accept(uint16_t frame_id, uint8_t cycle_count, uint8_t source, uint8_t indicators);
+
+void stream_filter_get_stats(stream_filter_stats_t *out);
+
+#endif // FLEXRAY_FILTER_H
@@ -4,21 +4,120 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "hardware/pio.h"
+#include "flexray_predicate.h"
 
 // Cache a frame's raw bytes (header+payload+CRC) when rules match
 void try_cache_last_target_frame(uint16_t frame_id, uint8_t cycle_count, uint16_t frame_length, uint8_t *captured_bytes);
 
-// On receiving a frame, check triggers; if matched, mutate template and request injection
-void try_inject_frame(uint16_t frame_id, uint8_t cycle_count);
+// On receiving a frame, check triggers; if matched, mutate template and request injection.
+// frame_end_us is the streamer ISR entry time, used to measure trigger-to-DMA latency.
+// frame is the trigger frame in the DMA ring, for rules with a content predicate.
+void try_inject_frame(uint16_t frame_id, uint8_t cycle_count, uint32_t frame_end_us,
+                      const predicate_frame_t *frame);
 
 void setup_forwarder_with_injector(PIO pio,
     uint rx_pin_from_ecu, uint tx_pin_to_vehicle,
     uint rx_pin_from_vehicle, uint tx_pin_to_ecu);
 
+// Outcome of a host override, reported in an injector_ack_t
+typedef enum {
+    OVERRIDE_QUEUED = 0,            // accepted, waiting for its slot
+    OVERRIDE_APPLIED = 1,           // on the wire; timestamp_us/cycle_count say when
+    OVERRIDE_ERR_CRC = 2,           // E2E CRC of the submitted slice is wrong
+    OVERRIDE_ERR_UNKNOWN_RULE = 3,  // no rule with this target id and cycle base
+    OVERRIDE_ERR_LENGTH = 4,        // slice length does not match rule->replace_len
+    OVERRIDE_SUPERSEDED = 5,        // dropped unused: the oldest queued one when a new override found the queue full
+} override_result_t;
+
+#define INJECTOR_ACK_NO_RULE  0xFF
+#define INJECTOR_ACK_NO_CYCLE 0xFF
+
+typedef struct __attribute__((packed)) {
+    uint32_t seq;           // host sequence number (op 0x9A), 0 for op 0x90
+    uint32_t timestamp_us;  // time_us_32() when applied, else when the result was decided
+    uint16_t target_id;
+    uint8_t rule;           // index into INJECT_TRIGGERS, INJECTOR_ACK_NO_RULE if none matched
+    uint8_t result;         // override_result_t
+    uint8_t cycle_count;    // cycle it was injected in, INJECTOR_ACK_NO_CYCLE otherwise
+    uint8_t reserved[3];
+} injector_ack_t;
+
 // Submit a host-provided replacement slice to be used on next matching injection
 // bytes must contain only the replacement payload slice; length must equal rule->replace_len
 // The override applies when id matches a rule's target_id and (cycle_count & rule->cycle_mask) == rule->cycle_base
-bool injector_submit_override(uint16_t id, uint8_t base, uint16_t len, const uint8_t *bytes);
+// Every submission produces at least one ack (the result, then APPLIED or SUPERSEDED once queued).
+override_result_t injector_submit_override(uint16_t id, uint8_t base, uint16_t len, const uint8_t *bytes, uint32_t seq);
+
+// Core0 consumer of override acks, produced on both cores
+bool injector_pop_ack(injector_ack_t *out);
+uint32_t injector_ack_dropped(void);
+
+// Runtime trigger of a rule. Starts as INJECT_TRIGGERS[rule].trigger_id;
+// the trigger tuner moves it. trigger_id 0 restores the compiled-in one.
+void injector_set_trigger(uint8_t rule, uint16_t trigger_id);
+uint16_t injector_get_trigger(uint8_t rule);
+
+// Trigger frame end (streamer ISR entry) to injector DMA start, per rule
+typedef struct {
+    uint32_t samples;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t sum_us;
+} injector_latency_t;
+
+void injector_get_latency(uint8_t rule, injector_latency_t *out);
+void injector_reset_latency(void);
+
+// Timed injection: a rule with lead_us != 0 ignores its trigger frame and is
+// armed by a hardware alarm lead_us before its target slot starts (planned
+// on core0 by flexray_timed_injection.c). The alarm IRQ runs on the core that
+// calls injector_timed_init(), which must be core1 like try_inject_frame.
+#define INJECTOR_TIMED_TRIGGER 0 // trigger_id in injection telemetry
+
+typedef struct {
+    uint32_t fired;            // alarms that ran
+    uint32_t injected;         // ...and loaded a frame
+    uint32_t idle;             // ...with no override or template pending
+    uint32_t late;             // ...too late (>= lead_us) and skipped
+    uint32_t lateness_sum_us;  // alarm callback behind its planned time
+    uint32_t lateness_max_us;
+} injector_timed_stats_t;
+
+void injector_timed_init(void);
+void injector_set_timed(uint8_t rule, uint16_t lead_us);
+uint16_t injector_get_timed(uint8_t rule);
+// Core0: false if the rule is still armed for an earlier cycle
+bool injector_arm_timed(uint8_t rule, uint8_t cycle_count, uint32_t at_us);
+void injector_get_timed_stats(uint8_t rule, injector_timed_stats_t *out);
+
+// Early triggers: a rule in early mode has FRAME_ID_MATCHER flag its trigger
+// ID while the trigger frame's header streams in, and composes its target
+// then (host slice, signals, routes, E2E, CRC or splice plan) for the cycle
+// it predicts. The trigger frame end only checks the cycle and the content
+// predicate and starts the DMA. Routes read their sources as of the
+// previous frame end, so a route from the trigger frame itself lags a
+// cycle. A frame composed for the wrong cycle, rejected by the predicate
+// or beaten by an earlier rule on the same trigger is dropped; its override
+// goes back to the queue unacked for a later trigger. A mispredicted plan
+// also skips that trigger's normal-path injection for the rule.
+//
+// Op 0xA3 sets a rule's mode; FLEXRAY_READ_EARLY_TRIGGER reads
+// injector_early_stats_t per rule.
+typedef struct __attribute__((packed)) {
+    uint8_t enabled;
+    uint8_t reserved[3];
+    uint32_t seen;                // matcher verdicts for the trigger ID
+    uint32_t prepared;            // target composed mid-frame
+    uint32_t fired;               // ...and started at the frame end
+    uint32_t mispredicted;        // ...for the wrong cycle, dropped
+    uint32_t rejected;            // ...but the predicate failed or another rule fired, dropped
+} injector_early_stats_t;
+
+// Core0. False if there is no such rule.
+bool injector_set_early(uint8_t rule, bool enabled);
+uint16_t injector_early_read(uint8_t *out, uint16_t cap);
+// Core1, matcher IRQ: a trigger ID in the loaded set is on the wire
+void injector_trigger_seen(uint16_t frame_id);
 
 // Enable/disable injection at runtime
 void injector_set_enabled(bool enabled);
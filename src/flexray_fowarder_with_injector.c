@@ -4,11 +4,18 @@
 #include "flexray_frame.h"
 #include "hardware/pio.h"
 #include "hardware/clocks.h"
+#include "hardware/timer.h"
 
 
 #include "flexray_forwarder_with_injector.pio.h"
 #include "flexray_forwarder_with_injector.h"
 #include "flexray_injector_rules.h"
+#include "flexray_telemetry.h"
+#include "flexray_gateway.h"
+#include "flexray_signals.h"
+#include "flexray_e2e.h"
+#include "flexray_splice.h"
+#include "flexray_frame_id_matcher.h"
 
 static PIO pio_forwarder_with_injector;
 static uint sm_forwarder_with_injector_to_vehicle;
@@ -29,57 +36,187 @@ typedef struct {
 
 static frame_template_t TEMPLATES[NUM_TRIGGER_RULES];
 
-// Host override storage: small ring to avoid malloc; single-consumer in ISR context
+// Host override storage: a small slot pool to avoid malloc. Core0 fills FREE
+// slots, core1 (ISR context) claims QUEUED ones oldest first; every state
+// change is a CAS on `valid`, so each entry gets exactly one final ack.
+enum {
+    OVERRIDE_SLOT_FREE = 0,
+    OVERRIDE_SLOT_QUEUED = 1,
+    OVERRIDE_SLOT_RESERVED = 2, // composed into a plan that has not started yet
+};
+
 typedef struct {
-    uint8_t valid;
+    uint8_t valid; // OVERRIDE_SLOT_*
     uint16_t id;
     uint8_t mask;
     uint8_t base;
+    uint8_t rule;
     uint16_t len;
+    uint32_t seq;
+    uint32_t order;             // push order, oldest entry goes first
     uint8_t data[MAX_FRAME_PAYLOAD_BYTES + 8];
 } host_override_t;
 
-#define HOST_OVERRIDE_CAP 4
-static volatile uint32_t host_override_head = 0;
-static volatile uint32_t host_override_tail = 0;
+// Each rule holds at most one reserved entry, so HOST_OVERRIDE_QUEUE slots
+// are always left for queued overrides
+#define HOST_OVERRIDE_QUEUE 4
+#define HOST_OVERRIDE_CAP (HOST_OVERRIDE_QUEUE + NUM_TRIGGER_RULES)
+static uint32_t host_override_order = 0; // core0
 static host_override_t host_overrides[HOST_OVERRIDE_CAP];
 static volatile bool injector_enabled = true;
 
-static inline bool host_override_push(uint16_t id, uint8_t mask, uint8_t base, uint16_t len, const uint8_t *bytes)
+// Runtime trigger per rule; 0 = INJECT_TRIGGERS[i].trigger_id (FlexRay IDs start at 1)
+static volatile uint16_t trigger_override[NUM_TRIGGER_RULES];
+
+// Written by try_inject_frame on core1 only; core0 asks for a reset via the
+// flag and reads under latency_seq (odd while core1 updates), as in
+// flexray_signals.c
+static injector_latency_t latency[NUM_TRIGGER_RULES];
+static volatile uint32_t latency_seq[NUM_TRIGGER_RULES];
+static volatile bool latency_reset_pending = false;
+
+// Override acks: same bounded MPSC scheme as flexray_log.c. Producers are
+// the USB handler on core0 and try_inject_frame on core1; panda_usb drains.
+#define ACK_RING_SIZE 16u // power of two
+#define ACK_RING_MASK (ACK_RING_SIZE - 1u)
+
+typedef struct {
+    volatile uint32_t seq;
+    injector_ack_t ack;
+} ack_slot_t;
+
+static ack_slot_t ack_ring[ACK_RING_SIZE];
+static volatile uint32_t ack_head = 0;
+static volatile uint32_t ack_tail = 0;
+static volatile uint32_t ack_drops = 0;
+
+static void __not_in_flash_func(post_ack)(uint32_t seq, uint16_t target_id, uint8_t rule, override_result_t result, uint8_t cycle_count)
+{
+    uint32_t head = __atomic_load_n(&ack_head, __ATOMIC_RELAXED);
+    do {
+        if ((uint32_t)(head - __atomic_load_n(&ack_tail, __ATOMIC_ACQUIRE)) >= ACK_RING_SIZE) {
+            __atomic_fetch_add(&ack_drops, 1u, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&ack_head, &head, head + 1u, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    ack_slot_t *slot = &ack_ring[head & ACK_RING_MASK];
+    slot->ack = (injector_ack_t){
+        .seq = seq,
+        .timestamp_us = time_us_32(),
+        .target_id = target_id,
+        .rule = rule,
+        .result = (uint8_t)result,
+        .cycle_count = cycle_count,
+    };
+    __atomic_store_n(&slot->seq, head + 1u, __ATOMIC_RELEASE);
+}
+
+bool injector_pop_ack(injector_ack_t *out)
+{
+    uint32_t tail = ack_tail;
+    ack_slot_t *slot = &ack_ring[tail & ACK_RING_MASK];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != tail + 1u) {
+        return false;
+    }
+    *out = slot->ack;
+    __atomic_store_n(&ack_tail, tail + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t injector_ack_dropped(void)
+{
+    return ack_drops;
+}
+
+// Retire a queued (not reserved) entry; the CAS makes this the only ack it gets
+static inline bool supersede(host_override_t *slot)
+{
+    uint8_t expected = OVERRIDE_SLOT_QUEUED;
+    if (!__atomic_compare_exchange_n(&slot->valid, &expected, OVERRIDE_SLOT_FREE, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    post_ack(slot->seq, slot->id, slot->rule, OVERRIDE_SUPERSEDED, INJECTOR_ACK_NO_CYCLE);
+    return true;
+}
+
+// Oldest slot in `state`, or -1
+static inline int host_override_oldest(uint8_t state, uint16_t id, uint8_t cycle_count, bool any_id)
 {
-    uint32_t next_head = (host_override_head + 1u) % HOST_OVERRIDE_CAP;
-    if (next_head == host_override_tail) {
-        // drop oldest on overflow
-        host_override_tail = (host_override_tail + 1u) % HOST_OVERRIDE_CAP;
+    int best = -1;
+    for (int k = 0; k < (int)HOST_OVERRIDE_CAP; k++) {
+        const host_override_t *slot = &host_overrides[k];
+        if (__atomic_load_n(&slot->valid, __ATOMIC_ACQUIRE) != state ||
+            (!any_id && (slot->id != id || (uint8_t)(cycle_count & slot->mask) != slot->base))) {
+            continue;
+        }
+        if (best < 0 || (int32_t)(slot->order - host_overrides[best].order) < 0) {
+            best = k;
+        }
     }
-    host_override_t *slot = &host_overrides[host_override_head];
+    return best;
+}
+
+// Core0. A full queue retires its oldest queued entry (acked SUPERSEDED)
+// so the newest slice always gets in, as a control loop wants.
+static inline void host_override_push(uint16_t id, uint8_t rule, uint8_t mask, uint8_t base, uint16_t len, const uint8_t *bytes, uint32_t seq)
+{
+    int k;
+    while ((k = host_override_oldest(OVERRIDE_SLOT_FREE, 0, 0, true)) < 0) {
+        int oldest = host_override_oldest(OVERRIDE_SLOT_QUEUED, 0, 0, true);
+        if (oldest >= 0) {
+            (void)supersede(&host_overrides[oldest]); // lost to a core1 reservation: look again
+        }
+    }
+    host_override_t *slot = &host_overrides[k];
     slot->id = id;
+    slot->rule = rule;
     slot->mask = mask;
     slot->base = base;
+    slot->seq = seq;
+    slot->order = host_override_order++;
     slot->len = len;
     if (len > sizeof(slot->data)) len = sizeof(slot->data);
     memcpy(slot->data, bytes, len);
-    __atomic_store_n(&slot->valid, 1, __ATOMIC_RELEASE);
-    host_override_head = next_head;
-    return true;
+    __atomic_store_n(&slot->valid, OVERRIDE_SLOT_QUEUED, __ATOMIC_RELEASE);
 }
 
-static inline bool host_override_try_pop_for(uint16_t id, uint8_t cycle_count, uint8_t *out)
+// Core1. Reserve the oldest queued entry for id/cycle_count and copy it out.
+// The entry stays in the pool until host_override_commit(), or goes back to
+// queued with host_override_unreserve() if its plan is dropped.
+static inline int host_override_reserve_for(uint16_t id, uint8_t cycle_count, uint8_t *out, uint32_t *seq, uint8_t *rule)
 {
-    uint32_t t = host_override_tail;
-    while (t != host_override_head) {
-        host_override_t *slot = &host_overrides[t];
-        uint8_t v = __atomic_load_n(&slot->valid, __ATOMIC_ACQUIRE);
-        if (v && slot->id == id && (uint8_t)(cycle_count & slot->mask) == slot->base) {
-            memcpy(out, slot->data, slot->len);
-            // invalidate and advance tail to this+1
-            slot->valid = 0;
-            host_override_tail = (t + 1u) % HOST_OVERRIDE_CAP;
-            return true;
+    int k;
+    while ((k = host_override_oldest(OVERRIDE_SLOT_QUEUED, id, cycle_count, false)) >= 0) {
+        host_override_t *slot = &host_overrides[k];
+        uint8_t expected = OVERRIDE_SLOT_QUEUED;
+        if (!__atomic_compare_exchange_n(&slot->valid, &expected, OVERRIDE_SLOT_RESERVED, false,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            continue; // superseded by core0 meanwhile
         }
-        t = (t + 1u) % HOST_OVERRIDE_CAP;
+        // Core0 may have reused the slot between the scan and the CAS
+        if (slot->id != id || (uint8_t)(cycle_count & slot->mask) != slot->base) {
+            __atomic_store_n(&slot->valid, OVERRIDE_SLOT_QUEUED, __ATOMIC_RELEASE);
+            continue;
+        }
+        memcpy(out, slot->data, slot->len);
+        *seq = slot->seq;
+        *rule = slot->rule;
+        return k;
     }
-    return false;
+    return -1;
+}
+
+static inline void host_override_commit(uint8_t index)
+{
+    __atomic_store_n(&host_overrides[index].valid, OVERRIDE_SLOT_FREE, __ATOMIC_RELEASE);
+}
+
+static inline void host_override_unreserve(uint8_t index)
+{
+    __atomic_store_n(&host_overrides[index].valid, OVERRIDE_SLOT_QUEUED, __ATOMIC_RELEASE);
 }
 
 static inline int find_cache_slot_for_id(uint16_t id, uint8_t cycle_count) {
@@ -107,6 +244,9 @@ void try_cache_last_target_frame(uint16_t frame_id, uint8_t cycle_count, uint16_
     memcpy(TEMPLATES[slot].data, captured_bytes, frame_len);
     TEMPLATES[slot].len = (uint16_t)frame_len;
     TEMPLATES[slot].valid = 1;
+    if (frame_len >= 8) {
+        splice_prepare((uint8_t)slot, (uint16_t)(frame_len - 8u));
+    }
 }
 
 static void fix_cycle_count(uint8_t *full_frame, uint8_t cycle_count)
@@ -115,17 +255,6 @@ static void fix_cycle_count(uint8_t *full_frame, uint8_t cycle_count)
     full_frame[4] = (full_frame[4] & 0b11000000) | (cycle_count & 0x3F);
 }
 
-static void fix_e2e_payload(uint8_t *e2e_start_offset, uint8_t init_value, uint8_t len)
-{
-    // advance e2e alive counter lower nibble
-    uint8_t nibble = (e2e_start_offset[1] & 0x0F) + 1;
-    if (nibble == 0x0F) {
-        nibble = 0;
-    }
-    e2e_start_offset[1] = (e2e_start_offset[1] & 0xF0) | (nibble & 0x0F);
-    e2e_start_offset[0] = calculate_autosar_e2e_crc8(e2e_start_offset+1, init_value, len);
-}
-
 static void inject_frame(uint8_t *full_frame, uint16_t injector_payload_length, uint8_t direction)
 {
     // first word is length indicator, rest is payload
@@ -146,41 +275,301 @@ static void inject_frame(uint8_t *full_frame, uint16_t injector_payload_length,
 // flexray_frame_t dummy_frame;
 // always fetch cache before store new value
 uint8_t replace_bytes[254];
-void __time_critical_func(try_inject_frame)(uint16_t frame_id, uint8_t cycle_count)
+
+// Timed rules: armed from core0, fired by a hardware alarm whose IRQ runs on core1
+#define TIMED_IDLE  0
+#define TIMED_ARMED 1
+
+typedef struct {
+    volatile uint8_t state;
+    uint8_t cycle_count;
+    uint32_t at_us;
+} timed_slot_t;
+
+static volatile uint16_t timed_lead_us[NUM_TRIGGER_RULES];
+static timed_slot_t timed_slots[NUM_TRIGGER_RULES];
+static injector_timed_stats_t timed_stats[NUM_TRIGGER_RULES]; // core1 writes
+static int timed_alarm = -1;
+static inline uint16_t rule_trigger_id(int i)
 {
-    // Find any trigger where current frame is the "previous" id
+    uint16_t id = trigger_override[i];
+    return id ? id : INJECT_TRIGGERS[i].trigger_id;
+}
+
+static inline void latency_write_begin(int rule)
+{
+    __atomic_store_n(&latency_seq[rule], latency_seq[rule] + 1u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void latency_write_end(int rule)
+{
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&latency_seq[rule], latency_seq[rule] + 1u, __ATOMIC_RELAXED);
+}
+
+static inline void note_latency(int rule, uint32_t us)
+{
+    injector_latency_t *l = &latency[rule];
+    if (latency_reset_pending) {
+        for (int r = 0; r < (int)NUM_TRIGGER_RULES; r++) {
+            latency_write_begin(r);
+            memset(&latency[r], 0, sizeof(latency[r]));
+            latency_write_end(r);
+        }
+        latency_reset_pending = false;
+    }
+    latency_write_begin(rule);
+    if (l->samples == 0 || us < l->min_us) l->min_us = us;
+    if (us > l->max_us) l->max_us = us;
+    l->sum_us += us;
+    l->samples++;
+    latency_write_end(rule);
+}
+
+// A composed target, waiting for its DMA start
+typedef struct {
+    uint8_t target_slot;
+    uint8_t cycle_count;
+    bool has_data;
+    bool splice;
+    uint8_t override_slot; // host_overrides index, valid when has_data
+    uint8_t override_rule; // rule the override was queued for (its acks' rule)
+    uint16_t trigger_id;
+    uint32_t seq;
+} fire_plan_t;
+
+// Mutate rule i's template with a pending override, ready for start_rule.
+static bool __time_critical_func(compose_rule)(int i, uint16_t trigger_id, uint8_t cycle_count, fire_plan_t *plan)
+{
+    int target_slot = find_cache_slot_for_id(INJECT_TRIGGERS[i].target_id, cycle_count);
+    if (target_slot < 0){
+        return false;
+    }
+
+    frame_template_t *tpl = &TEMPLATES[target_slot];
+    uint8_t *tpl_payload = tpl->data+5;
+    if (!tpl->valid || tpl->len < 8){
+        return false;
+    }
+    uint16_t payload_len = (uint16_t)(tpl->len - 8u);
+    // Saves the window as the ECU sent it, before any override lands
+    bool splice = splice_begin((uint8_t)i, tpl_payload, payload_len);
+
+    uint32_t seq = 0;
+    uint8_t override_rule = 0;
+    int override_slot = host_override_reserve_for(INJECT_TRIGGERS[i].target_id, cycle_count, replace_bytes, &seq,
+                                                  &override_rule);
+    bool has_data = override_slot >= 0;
+    if (has_data) {
+        memcpy(tpl_payload+INJECT_TRIGGERS[i].replace_offset, replace_bytes, INJECT_TRIGGERS[i].replace_len);
+    }
+    // Host signals, then routed signals, go on top of the host slice (timed rules are host-only)
+    bool routed = false;
+    if (trigger_id != INJECTOR_TIMED_TRIGGER) {
+        routed = signals_apply((uint8_t)i, tpl_payload, payload_len);
+        routed = gateway_apply((uint8_t)i, tpl_payload, payload_len) || routed;
+    }
+    if (!has_data && !routed) {
+        return false;
+    }
+
+    e2e_protect((uint8_t)i, tpl_payload, payload_len);
+    fix_cycle_count(tpl->data, cycle_count);
+    if (!splice) {
+        fix_flexray_frame_crc(tpl->data, tpl->len);
+    }
+    *plan = (fire_plan_t){
+        .target_slot = (uint8_t)target_slot,
+        .cycle_count = cycle_count,
+        .has_data = has_data,
+        .splice = splice,
+        .override_slot = (uint8_t)override_slot,
+        .override_rule = override_rule,
+        .trigger_id = trigger_id,
+        .seq = seq,
+    };
+    return true;
+}
+
+// ref_us is when the injection was due (trigger frame end or alarm time).
+static void __time_critical_func(start_rule)(int i, const fire_plan_t *plan, uint32_t ref_us)
+{
+    frame_template_t *tpl = &TEMPLATES[plan->target_slot];
+    if (plan->splice) {
+        splice_fire((uint8_t)i, tpl->data);
+    } else {
+        inject_frame(tpl->data, tpl->len, INJECT_TRIGGERS[i].direction);
+    }
+    uint32_t dma_start_us = time_us_32();
+    note_latency(i, dma_start_us - ref_us);
+
+    telemetry_injection_t ev = {
+        .timestamp_us = dma_start_us,
+        .target_id = INJECT_TRIGGERS[i].target_id,
+        .cycle_count = plan->cycle_count,
+        .direction = INJECT_TRIGGERS[i].direction,
+        .trigger_id = plan->trigger_id,
+        .frame_len = tpl->len,
+    };
+    telemetry_post(STREAM_TLV_INJECTION, &ev, sizeof(ev));
+    if (plan->has_data) {
+        host_override_commit(plan->override_slot);
+        post_ack(plan->seq, INJECT_TRIGGERS[i].target_id, plan->override_rule, OVERRIDE_APPLIED, plan->cycle_count);
+    }
+}
+
+static bool __time_critical_func(fire_rule)(int i, uint16_t trigger_id, uint8_t cycle_count, uint32_t ref_us)
+{
+    fire_plan_t plan;
+    if (!compose_rule(i, trigger_id, cycle_count, &plan)) {
+        return false;
+    }
+    start_rule(i, &plan, ref_us);
+    return true;
+}
+
+// Early triggers (core1 only: the matcher IRQ and the streamer ISR share a priority)
+static volatile uint8_t early_enabled[NUM_TRIGGER_RULES];
+static uint8_t early_ready[NUM_TRIGGER_RULES];
+static fire_plan_t early_plans[NUM_TRIGGER_RULES];
+static injector_early_stats_t early_stats[NUM_TRIGGER_RULES];
+static uint16_t last_frame_id;
+static uint8_t last_cycle_count;
+
+static void early_load_triggers(void)
+{
+    uint16_t ids[MATCHER_MAX_TRIGGERS];
+    uint8_t n = 0;
+    for (int i = 0; i < (int)NUM_TRIGGER_RULES && n < MATCHER_MAX_TRIGGERS; i++) {
+        if (early_enabled[i]) {
+            ids[n++] = rule_trigger_id(i);
+        }
+    }
+    matcher_set_triggers(ids, n);
+}
+
+// The override goes back to the queue, as on the normal path when a
+// predicate rejects the trigger
+static void __time_critical_func(early_drop)(int i)
+{
+    early_ready[i] = 0;
+    const fire_plan_t *plan = &early_plans[i];
+    if (plan->has_data) {
+        host_override_unreserve(plan->override_slot);
+    }
+}
+
+void __time_critical_func(injector_trigger_seen)(uint16_t frame_id)
+{
+    // Static slots run in ID order: an ID not above the last one starts a new cycle
+    uint8_t cycle_count = frame_id > last_frame_id ? last_cycle_count : (uint8_t)((last_cycle_count + 1u) & 0x3Fu);
     for (int i = 0; i < (int)NUM_TRIGGER_RULES; i++) {
-        if (INJECT_TRIGGERS[i].trigger_id != frame_id){
+        if (!early_enabled[i] || timed_lead_us[i] || rule_trigger_id(i) != frame_id) {
             continue;
         }
-        if ((uint8_t)(cycle_count & INJECT_TRIGGERS[i].cycle_mask) != INJECT_TRIGGERS[i].cycle_base){
+        early_stats[i].seen++;
+        if (early_ready[i] ||
+            (uint8_t)(cycle_count & INJECT_TRIGGERS[i].cycle_mask) != INJECT_TRIGGERS[i].cycle_base) {
             continue;
         }
+        if (compose_rule(i, frame_id, cycle_count, &early_plans[i])) {
+            early_ready[i] = 1;
+            early_stats[i].prepared++;
+            break; // same once-per-trigger rule as try_inject_frame
+        }
+    }
+}
 
-        int target_slot = find_cache_slot_for_id(INJECT_TRIGGERS[i].target_id, cycle_count);
-        if (target_slot < 0){
+void __time_critical_func(try_inject_frame)(uint16_t frame_id, uint8_t cycle_count, uint32_t frame_end_us,
+                                            const predicate_frame_t *frame)
+{
+    last_frame_id = frame_id;
+    last_cycle_count = cycle_count;
+    // Find any trigger where current frame is the "previous" id
+    int fired = -1;
+    for (int i = 0; i < (int)NUM_TRIGGER_RULES && fired < 0; i++) {
+        if (timed_lead_us[i] || rule_trigger_id(i) != frame_id){
             continue;
         }
-
-        frame_template_t *tpl = &TEMPLATES[target_slot];
-        uint8_t *tpl_payload = tpl->data+5;
-        if (!tpl->valid || tpl->len < 8){
+        if (early_ready[i]) {
+            if (early_plans[i].cycle_count != cycle_count) {
+                early_stats[i].mispredicted++;
+                early_drop(i);
+            } else if (predicate_eval((uint8_t)i, frame)) {
+                early_ready[i] = 0;
+                early_stats[i].fired++;
+                start_rule(i, &early_plans[i], frame_end_us);
+                fired = i;
+            }
             continue;
         }
-
-        bool has_data = host_override_try_pop_for(INJECT_TRIGGERS[i].target_id, cycle_count, replace_bytes);
-        if (!has_data) {
+        if ((uint8_t)(cycle_count & INJECT_TRIGGERS[i].cycle_mask) != INJECT_TRIGGERS[i].cycle_base){
+            continue;
+        }
+        // A failed predicate leaves the override queued for a later trigger
+        if (!predicate_eval((uint8_t)i, frame)) {
             continue;
         }
+        if (fire_rule(i, frame_id, cycle_count, frame_end_us)) {
+            fired = i; // fire once per triggering frame
+        }
+    }
+    // Early plans this frame did not start: predicate failed, or another rule fired first
+    for (int i = 0; i < (int)NUM_TRIGGER_RULES; i++) {
+        if (early_ready[i] && rule_trigger_id(i) == frame_id) {
+            early_stats[i].rejected++;
+            early_drop(i);
+        }
+    }
+}
 
-        memcpy(tpl_payload+INJECT_TRIGGERS[i].replace_offset, replace_bytes, INJECT_TRIGGERS[i].replace_len);
-    
-        fix_e2e_payload(tpl_payload+INJECT_TRIGGERS[i].e2e_offset, INJECT_TRIGGERS[i].e2e_init_value, INJECT_TRIGGERS[i].e2e_len);
-        fix_cycle_count(tpl->data, cycle_count);
-        fix_flexray_frame_crc(tpl->data, tpl->len);
-        inject_frame(tpl->data, tpl->len, INJECT_TRIGGERS[i].direction);
-        break; // fire once per triggering frame
-        
+static inline absolute_time_t us32_to_absolute(uint32_t at_us)
+{
+    uint64_t now = time_us_64();
+    return from_us_since_boot(now + (int64_t)(int32_t)(at_us - (uint32_t)now));
+}
+
+static void __time_critical_func(timed_alarm_callback)(uint alarm_num)
+{
+    for (;;) {
+        uint32_t now = time_us_32();
+        bool have_next = false;
+        uint32_t next = 0;
+        for (int i = 0; i < (int)NUM_TRIGGER_RULES; i++) {
+            timed_slot_t *slot = &timed_slots[i];
+            if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != TIMED_ARMED) {
+                continue;
+            }
+            int32_t late = (int32_t)(now - slot->at_us);
+            if (late < 0) {
+                if (!have_next || (int32_t)(slot->at_us - next) < 0) {
+                    next = slot->at_us;
+                    have_next = true;
+                }
+                continue;
+            }
+            injector_timed_stats_t *st = &timed_stats[i];
+            st->fired++;
+            st->lateness_sum_us += (uint32_t)late;
+            if ((uint32_t)late > st->lateness_max_us) st->lateness_max_us = (uint32_t)late;
+            if ((uint32_t)late >= timed_lead_us[i]) {
+                // Slot already started: arming now would replace the frame after it
+                st->late++;
+            } else if (fire_rule(i, INJECTOR_TIMED_TRIGGER, slot->cycle_count, slot->at_us)) {
+                st->injected++;
+            } else {
+                st->idle++;
+            }
+            __atomic_store_n(&slot->state, TIMED_IDLE, __ATOMIC_RELEASE);
+        }
+        if (!have_next) {
+            return;
+        }
+        // true = target already passed: go round again
+        if (!hardware_alarm_set_target(alarm_num, us32_to_absolute(next))) {
+            return;
+        }
     }
 }
 
@@ -208,41 +597,158 @@ static void setup_dma(void){
 
 }
 
-bool injector_submit_override(uint16_t id, uint8_t base, uint16_t len, const uint8_t *bytes)
+static override_result_t check_override(uint16_t id, uint8_t base, uint16_t len, const uint8_t *bytes, int *rule_index)
 {
     // Host should provide only the replacement slice, not a full frame.
     // Match the provided id/base against a trigger rule's target_id/cycle_base
     // and enforce len == rule->replace_len. We use the rule's cycle_mask/cycle_base.
-    if (bytes == NULL) {
-        return false;
+    *rule_index = -1;
+    if (bytes == NULL || len < 1 || len > MAX_FRAME_PAYLOAD_BYTES+1) {
+        return OVERRIDE_ERR_LENGTH;
     }
 
-    if (len < 1 || len > MAX_FRAME_PAYLOAD_BYTES+1) {
-        return false;
+    for (int i = 0; i < (int)NUM_TRIGGER_RULES; i++) {
+        if (INJECT_TRIGGERS[i].target_id == id && INJECT_TRIGGERS[i].cycle_base == base) {
+            *rule_index = i;
+            break;
+        }
+    }
+    if (*rule_index < 0) {
+        return OVERRIDE_ERR_UNKNOWN_RULE;
     }
 
-    uint8_t crc = calculate_autosar_e2e_crc8(bytes+1, 0xf1, len-1);
+    uint8_t crc = calculate_autosar_e2e_crc8(bytes+1, INJECT_TRIGGERS[*rule_index].override_crc_init, len-1);
     if (crc != bytes[0]) {
-        return false;
+        return OVERRIDE_ERR_CRC;
     }
 
-    const trigger_rule_t *matched_rule = NULL;
-    for (int i = 0; i < (int)NUM_TRIGGER_RULES; i++) {
-        if (INJECT_TRIGGERS[i].target_id == id && INJECT_TRIGGERS[i].cycle_base == base) {
-            matched_rule = &INJECT_TRIGGERS[i];
-            break;
+    const trigger_rule_t *matched_rule = &INJECT_TRIGGERS[*rule_index];
+    if (len < 1u + matched_rule->replace_offset ||
+        len - 1u - matched_rule->replace_offset != matched_rule->replace_len) {
+        return OVERRIDE_ERR_LENGTH;
+    }
+    return OVERRIDE_QUEUED;
+}
+
+override_result_t injector_submit_override(uint16_t id, uint8_t base, uint16_t len, const uint8_t *bytes, uint32_t seq)
+{
+    int rule_index;
+    override_result_t result = check_override(id, base, len, bytes, &rule_index);
+    uint8_t rule = rule_index < 0 ? INJECTOR_ACK_NO_RULE : (uint8_t)rule_index;
+    post_ack(seq, id, rule, result, INJECTOR_ACK_NO_CYCLE);
+    if (result != OVERRIDE_QUEUED) {
+        return result;
+    }
+    const trigger_rule_t *matched_rule = &INJECT_TRIGGERS[rule_index];
+    // bytes+1: skip the first byte, which is the cycle count
+    host_override_push(id, rule, matched_rule->cycle_mask, matched_rule->cycle_base, matched_rule->replace_len,
+                       bytes + 1 + matched_rule->replace_offset, seq);
+    return result;
+}
+
+void injector_set_trigger(uint8_t rule, uint16_t trigger_id)
+{
+    if (rule < NUM_TRIGGER_RULES) {
+        trigger_override[rule] = trigger_id & 0x7FFu;
+        if (early_enabled[rule]) {
+            early_load_triggers();
         }
     }
-    if (matched_rule == NULL) {
+}
+
+uint16_t injector_get_trigger(uint8_t rule)
+{
+    return rule < NUM_TRIGGER_RULES ? rule_trigger_id(rule) : 0;
+}
+
+void injector_get_latency(uint8_t rule, injector_latency_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (rule >= NUM_TRIGGER_RULES || latency_reset_pending) {
+        return;
+    }
+    // core1 holds the sequence odd for a few instructions only
+    for (;;) {
+        uint32_t s1 = __atomic_load_n(&latency_seq[rule], __ATOMIC_ACQUIRE);
+        if (s1 & 1u) {
+            continue;
+        }
+        *out = latency[rule];
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&latency_seq[rule], __ATOMIC_RELAXED) == s1) {
+            return;
+        }
+    }
+}
+
+void injector_reset_latency(void)
+{
+    latency_reset_pending = true;
+}
+
+void injector_timed_init(void)
+{
+    timed_alarm = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback((uint)timed_alarm, timed_alarm_callback);
+}
+
+void injector_set_timed(uint8_t rule, uint16_t lead_us)
+{
+    if (rule < NUM_TRIGGER_RULES) {
+        timed_lead_us[rule] = lead_us;
+    }
+}
+
+uint16_t injector_get_timed(uint8_t rule)
+{
+    return rule < NUM_TRIGGER_RULES ? timed_lead_us[rule] : 0;
+}
+
+bool injector_arm_timed(uint8_t rule, uint8_t cycle_count, uint32_t at_us)
+{
+    if (rule >= NUM_TRIGGER_RULES || timed_alarm < 0) {
         return false;
     }
-    len = len - 1 - matched_rule->replace_offset;
+    timed_slot_t *slot = &timed_slots[rule];
+    if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != TIMED_IDLE) {
+        return false;
+    }
+    slot->cycle_count = cycle_count;
+    slot->at_us = at_us;
+    __atomic_store_n(&slot->state, TIMED_ARMED, __ATOMIC_RELEASE);
+    // The callback (core1) owns the alarm target: let it pick the earliest slot
+    hardware_alarm_force_irq((uint)timed_alarm);
+    return true;
+}
+
+void injector_get_timed_stats(uint8_t rule, injector_timed_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (rule < NUM_TRIGGER_RULES) {
+        *out = timed_stats[rule];
+    }
+}
 
-    if (len != matched_rule->replace_len) {
+bool injector_set_early(uint8_t rule, bool enabled)
+{
+    if (rule >= NUM_TRIGGER_RULES) {
         return false;
     }
-    // bytes+1: skip the first byte, which is the cycle count
-    return host_override_push(id, matched_rule->cycle_mask, matched_rule->cycle_base, matched_rule->replace_len, bytes + 1 + matched_rule->replace_offset);
+    early_enabled[rule] = enabled ? 1u : 0u;
+    early_load_triggers();
+    return true;
+}
+
+uint16_t injector_early_read(uint8_t *out, uint16_t cap)
+{
+    uint16_t n = 0;
+    for (uint8_t i = 0; i < NUM_TRIGGER_RULES && n + sizeof(injector_early_stats_t) <= cap; i++) {
+        injector_early_stats_t s = early_stats[i];
+        s.enabled = early_enabled[i];
+        memcpy(out + n, &s, sizeof(s));
+        n += (uint16_t)sizeof(s);
+    }
+    return n;
 }
 
 void injector_set_enabled(bool enabled)
@@ -267,4 +773,6 @@ void setup_forwarder_with_injector(PIO pio,
     flexray_forwarder_with_injector_program_init(pio, sm_forwarder_with_injector_to_vehicle, offset, rx_pin_from_ecu, tx_pin_to_vehicle);
     flexray_forwarder_with_injector_program_init(pio, sm_forwarder_with_injector_to_ecu, offset, rx_pin_from_vehicle, tx_pin_to_ecu);
     setup_dma();
+    splice_setup(pio, sm_forwarder_with_injector_to_vehicle, sm_forwarder_with_injector_to_ecu, offset);
+    matcher_attach_forwarder(pio, sm_forwarder_with_injector_to_vehicle, sm_forwarder_with_injector_to_ecu);
 }
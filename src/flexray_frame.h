@@ -15,6 +15,16 @@
 #define FROM_VEHICLE 1
 #define FROM_UNKNOWN 0xff
 
+// On-wire length at 10 Mbit/s: TSS + FSS + 10 bits per byte (BSS + data) + FES.
+// Assumes the longest TSS, so a start derived from a frame end is never late.
+#define FLEXRAY_TSS_BITS_MAX 15u
+
+static inline uint32_t flexray_frame_duration_us(uint8_t payload_words)
+{
+    uint32_t bits = FLEXRAY_TSS_BITS_MAX + 1u + 10u * (5u + 2u * payload_words + 3u) + 2u;
+    return (bits + 9u) / 10u;
+}
+
 // FlexRay frame structure definition based on specification
 typedef struct
 {
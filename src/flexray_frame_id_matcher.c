@@ -0,0 +1,221 @@
+#include "flexray_frame_id_matcher.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "hardware/dma.h"
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
+#include "flexray_frame_id_matcher.pio.h"
+#include "flexray_injector_rules.h"
+#include "flexray_forwarder_with_injector.h"
+
+#define MATCHER_TABLE_BYTES (1u << 13)
+#define MATCHER_BLOCK_FLAG 4u     // forwarder: wait 0 irq 4 rel
+
+// Indexed by the matcher's 13 samples: ID10..8, BSS (always 1, 0), ID7..0.
+// Per INJECT_DIRECTION_*, each a separate 8 KB for the matcher's X << 13.
+static uint8_t tables[2][MATCHER_TABLE_BYTES] __attribute__((aligned(MATCHER_TABLE_BYTES)));
+static uint8_t bitmaps[2][MATCHER_BITMAP_BYTES];
+
+static PIO fwd_pio;
+static uint8_t fwd_flag[2];       // forwarder IRQ_FORCE bit per direction
+static uint8_t trig_flag[2];      // early trigger bit per direction, see matcher_attach_forwarder
+static uint16_t triggers[MATCHER_MAX_TRIGGERS];
+static uint8_t n_triggers;
+static int lookup_chan[2] = { -1, -1 };
+static int verdict_chan[2] = { -1, -1 };
+static volatile bool attached = false;
+
+static matcher_block_stats_t stats; // counters written by core1
+
+static inline uint32_t table_index(uint16_t frame_id)
+{
+    return ((uint32_t)(frame_id >> 8) & 0x7u) << 10 | 0x200u | (frame_id & 0xFFu);
+}
+
+static bool is_trigger(uint16_t frame_id)
+{
+    for (uint8_t i = 0; i < n_triggers; i++) {
+        if (triggers[i] == frame_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void set_entry(uint8_t direction, uint16_t frame_id)
+{
+    uint8_t entry = 0;
+    if (attached) {
+        if ((bitmaps[direction][frame_id >> 3] >> (frame_id & 7u)) & 1u) {
+            entry |= fwd_flag[direction];
+        }
+        if (is_trigger(frame_id)) {
+            entry |= trig_flag[direction];
+        }
+    }
+    tables[direction][table_index(frame_id)] = entry;
+}
+
+// The matcher's push writes the lookup address into the verdict channel's
+// READ_ADDR_TRIG; the verdict channel moves that byte to IRQ_FORCE and
+// chains back, so the pair rearms itself once per frame.
+static void setup_lookup(PIO pio, uint sm, uint8_t direction)
+{
+    uint lookup = dma_claim_unused_channel(true);
+    uint verdict = dma_claim_unused_channel(true);
+
+    dma_channel_config c = dma_channel_get_default_config(lookup);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(pio, sm, false));
+    channel_config_set_high_priority(&c, true);
+    dma_channel_configure(lookup, &c, &dma_channel_hw_addr(verdict)->al3_read_addr_trig, &pio->rxf[sm], 1, false);
+
+    // 8-bit write: narrow writes to IO registers are replicated, bits 0-7 land in IRQ_FORCE
+    dma_channel_config v = dma_channel_get_default_config(verdict);
+    channel_config_set_transfer_data_size(&v, DMA_SIZE_8);
+    channel_config_set_read_increment(&v, false);
+    channel_config_set_write_increment(&v, false);
+    channel_config_set_chain_to(&v, lookup);
+    channel_config_set_high_priority(&v, true);
+    dma_channel_configure(verdict, &v, NULL, tables[direction], 1, false);
+
+    lookup_chan[direction] = (int)lookup;
+    verdict_chan[direction] = (int)verdict;
+}
+
+void matcher_setup(PIO pio, uint streamer_sm_from_ecu, uint rx_pin_from_ecu,
+                   uint streamer_sm_from_vehicle, uint rx_pin_from_vehicle)
+{
+    uint offset = pio_add_program(pio, &flexray_frame_id_matcher_program);
+    // The streamer's irq 0 rel and the matcher's irq 2 rel meet on the same flag
+    uint sm_from_ecu = (streamer_sm_from_ecu + 2u) & 3u;
+    uint sm_from_vehicle = (streamer_sm_from_vehicle + 2u) & 3u;
+    pio_sm_claim(pio, sm_from_ecu);
+    pio_sm_claim(pio, sm_from_vehicle);
+
+    // Frames from the ECU are forwarded to the vehicle and vice versa
+    setup_lookup(pio, sm_from_ecu, INJECT_DIRECTION_TO_VEHICLE);
+    setup_lookup(pio, sm_from_vehicle, INJECT_DIRECTION_TO_ECU);
+    flexray_frame_id_matcher_program_init(pio, sm_from_ecu, offset, rx_pin_from_ecu,
+                                          (uint32_t)(uintptr_t)tables[INJECT_DIRECTION_TO_VEHICLE]);
+    flexray_frame_id_matcher_program_init(pio, sm_from_vehicle, offset, rx_pin_from_vehicle,
+                                          (uint32_t)(uintptr_t)tables[INJECT_DIRECTION_TO_ECU]);
+}
+
+void matcher_attach_forwarder(PIO pio, uint sm_to_vehicle, uint sm_to_ecu)
+{
+    fwd_pio = pio;
+    fwd_flag[INJECT_DIRECTION_TO_VEHICLE] = (uint8_t)(1u << (MATCHER_BLOCK_FLAG + sm_to_vehicle));
+    fwd_flag[INJECT_DIRECTION_TO_ECU] = (uint8_t)(1u << (MATCHER_BLOCK_FLAG + sm_to_ecu));
+    pio_interrupt_clear(pio, MATCHER_BLOCK_FLAG + sm_to_vehicle);
+    pio_interrupt_clear(pio, MATCHER_BLOCK_FLAG + sm_to_ecu);
+    // Two of flags 0-3 that no forwarder SM raises with its splice irq 0 rel
+    uint8_t d = 0;
+    for (uint flag = 0; flag < 4u && d < 2u; flag++) {
+        if (flag != sm_to_vehicle && flag != sm_to_ecu) {
+            trig_flag[d++] = (uint8_t)(1u << flag);
+            pio_interrupt_clear(pio, flag);
+            pio_set_irq1_source_enabled(pio, (enum pio_interrupt_source)(pis_interrupt0 + flag), true);
+        }
+    }
+    attached = true;
+    for (d = 0; d < 2; d++) {
+        for (uint16_t id = 0; id < MATCHER_BITMAP_BYTES * 8u; id++) {
+            set_entry(d, id);
+        }
+        if (lookup_chan[d] >= 0) {
+            dma_channel_set_write_addr((uint)verdict_chan[d], &pio->irq_force, false);
+            dma_channel_start((uint)lookup_chan[d]);
+        }
+    }
+    stats.attached = 1;
+}
+
+bool matcher_set_block(uint8_t direction, uint8_t first_byte, uint8_t n, const uint8_t *bits)
+{
+    if (direction > 1u || (uint32_t)first_byte + n > MATCHER_BITMAP_BYTES) {
+        return false;
+    }
+    memcpy(&bitmaps[direction][first_byte], bits, n);
+    for (uint16_t id = (uint16_t)(first_byte * 8u); id < (uint16_t)((first_byte + n) * 8u); id++) {
+        set_entry(direction, id);
+    }
+    return true;
+}
+
+bool matcher_set_triggers(const uint16_t *ids, uint8_t n)
+{
+    if (n > MATCHER_MAX_TRIGGERS) {
+        return false;
+    }
+    uint16_t old[MATCHER_MAX_TRIGGERS];
+    uint8_t n_old = n_triggers;
+    memcpy(old, triggers, sizeof(old));
+    for (uint8_t i = 0; i < n; i++) {
+        triggers[i] = ids[i] & 0x7FFu;
+    }
+    n_triggers = n;
+    for (uint8_t d = 0; d < 2; d++) {
+        for (uint8_t i = 0; i < n_old; i++) {
+            set_entry(d, old[i]);
+        }
+        for (uint8_t i = 0; i < n; i++) {
+            set_entry(d, triggers[i]);
+        }
+    }
+    return true;
+}
+
+// The verdict channel does not increment, so READ_ADDR still points at the
+// entry it moved: the table index gives the ID back
+static void __time_critical_func(matcher_irq_handler)(void)
+{
+    if (!attached) {
+        return;
+    }
+    for (uint8_t d = 0; d < 2; d++) {
+        uint flag = (uint)__builtin_ctz(trig_flag[d]);
+        if (!pio_interrupt_get(fwd_pio, flag)) {
+            continue;
+        }
+        pio_interrupt_clear(fwd_pio, flag);
+        uint32_t idx = dma_channel_hw_addr((uint)verdict_chan[d])->read_addr - (uint32_t)(uintptr_t)tables[d];
+        injector_trigger_seen((uint16_t)(((idx >> 10) & 0x7u) << 8 | (idx & 0xFFu)));
+    }
+}
+
+void matcher_irq_init(PIO pio)
+{
+    uint irq = pio_get_irq_num(pio, 1);
+    irq_set_exclusive_handler(irq, matcher_irq_handler);
+    irq_set_enabled(irq, true);
+}
+
+uint16_t matcher_block_read(uint8_t *out, uint16_t cap)
+{
+    if (cap < sizeof(stats) + sizeof(bitmaps)) {
+        return 0;
+    }
+    memcpy(out, &stats, sizeof(stats));
+    memcpy(out + sizeof(stats), bitmaps, sizeof(bitmaps));
+    return (uint16_t)(sizeof(stats) + sizeof(bitmaps));
+}
+
+void __time_critical_func(matcher_frame_end)(bool is_vehicle, uint16_t frame_id)
+{
+    if (!attached) {
+        return;
+    }
+    uint8_t d = is_vehicle ? INJECT_DIRECTION_TO_ECU : INJECT_DIRECTION_TO_VEHICLE;
+    uint flag = (uint)__builtin_ctz(fwd_flag[d]);
+    bool held = pio_interrupt_get(fwd_pio, flag);
+    if (held) {
+        pio_interrupt_clear(fwd_pio, flag);
+        stats.blocked[d]++;
+        stats.last_blocked_id[d] = frame_id;
+    } else if (tables[d][table_index(frame_id & 0x7FFu)] & fwd_flag[d]) {
+        stats.missed[d]++;
+    }
+}
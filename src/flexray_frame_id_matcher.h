@@ -0,0 +1,59 @@
+#ifndef FLEXRAY_FRAME_ID_MATCHER_H
+#define FLEXRAY_FRAME_ID_MATCHER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/pio.h"
+
+// FRAME_ID_MATCHER from state_machines_layout.txt. One PIO SM per receive
+// side, next to the streamer, samples the frame ID while the header streams
+// in (see flexray_frame_id_matcher.pio). A pair of DMA channels then looks
+// it up in a per-direction table of forwarder IRQ flags and writes the entry
+// straight to the forwarder PIO's IRQ_FORCE. No CPU runs before the frame
+// ends; the verdict is in about 2.2 us after FSS.
+//
+// Frame blocking: a blocked slot's entry sets the forwarder's flag 4 rel,
+// which the forwarder waits on at its next rising edge, so TXD stays
+// recessive for the rest of the frame. The receiver sees TSS, FSS and the
+// first two header bytes, then nothing: a syntax error in place of the
+// frame. The streamer ISR clears the flag when the frame ends.
+//
+// Op 0xA2 edits the per-direction block bitmaps (id = 8 * byte + bit);
+// FLEXRAY_READ_BLOCK reads matcher_block_stats_t, then both bitmaps.
+//
+// Early triggers: the entries of a small set of trigger IDs, loaded by the
+// injector, also set a forwarder flag that no SM waits on but that raises
+// the forwarder PIO's IRQ1 on core1. The handler reads the matched ID back
+// from the verdict channel and hands it to injector_trigger_seen while the
+// trigger frame is still on the wire.
+
+#define MATCHER_BITMAP_BYTES 256u // 2048 frame IDs
+#define MATCHER_MAX_TRIGGERS 8u
+
+typedef struct __attribute__((packed)) {
+    uint8_t attached;             // forwarder registered, blocking is live
+    uint8_t reserved[3];
+    uint32_t blocked[2];          // per INJECT_DIRECTION_*
+    uint32_t missed[2];           // frame in the bitmap ended without the forwarder holding it
+    uint16_t last_blocked_id[2];
+} matcher_block_stats_t;
+
+// Core1, from setup_stream: matcher SMs are streamer SM + 2 on the same PIO
+void matcher_setup(PIO pio, uint streamer_sm_from_ecu, uint rx_pin_from_ecu,
+                   uint streamer_sm_from_vehicle, uint rx_pin_from_vehicle);
+// Core0, from setup_forwarder_with_injector: starts the lookups
+void matcher_attach_forwarder(PIO pio, uint sm_to_vehicle, uint sm_to_ecu);
+
+// Core0 (USB). False if the range is outside the bitmap.
+bool matcher_set_block(uint8_t direction, uint8_t first_byte, uint8_t n, const uint8_t *bits);
+uint16_t matcher_block_read(uint8_t *out, uint16_t cap);
+
+// Core0. Replaces the early trigger set; false (set unchanged) if n is too large.
+bool matcher_set_triggers(const uint16_t *ids, uint8_t n);
+// Must run on core1, at the streamer IRQ's priority so the two never interleave
+void matcher_irq_init(PIO pio);
+
+// Core1, streamer ISR, before anything slow: a frame from this source ended
+void matcher_frame_end(bool is_vehicle, uint16_t frame_id);
+
+#endif // FLEXRAY_FRAME_ID_MATCHER_H
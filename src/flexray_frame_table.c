@@ -0,0 +1,188 @@
+#include "flexray_frame_table.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "hardware/timer.h"
+
+// Entries are allocated in arrival order and never evicted; a bucket array of
+// twice the entry count maps keys to entries with linear probing. Changed
+// entries move to the tail of a doubly linked list, so the list is always in
+// ascending seq order and a read only walks what changed since the caller's
+// seq. Updates and reads both run on core0, so no locking is needed.
+
+#if (FLEXRAY_FRAME_TABLE_SIZE & (FLEXRAY_FRAME_TABLE_SIZE - 1u)) != 0 || FLEXRAY_FRAME_TABLE_SIZE > 0x8000u
+#error "FLEXRAY_FRAME_TABLE_SIZE must be a power of two up to 32768"
+#endif
+
+#define TABLE_BUCKETS     (2u * FLEXRAY_FRAME_TABLE_SIZE)
+#define TABLE_BUCKET_MASK (TABLE_BUCKETS - 1u)
+#define TABLE_NONE        0xFFFFu
+
+typedef struct {
+    uint32_t key;
+    uint32_t seq;            // table seq of the last payload change
+    uint32_t last_seen_us;
+    uint16_t prev;           // change-order list
+    uint16_t next;
+    uint8_t cycle_count;
+    uint8_t indicators;
+    uint8_t payload_len;     // bytes
+    uint8_t payload[MAX_FRAME_PAYLOAD_BYTES];
+} frame_table_entry_t;
+
+static frame_table_entry_t entries[FLEXRAY_FRAME_TABLE_SIZE];
+static uint16_t buckets[TABLE_BUCKETS];
+static uint16_t entry_count = 0;
+static uint16_t list_head = TABLE_NONE; // oldest change
+static uint16_t list_tail = TABLE_NONE; // newest change
+static uint32_t table_seq = 0;
+static uint8_t table_mux_mask = 0x03;
+static frame_table_stats_t table_stats;
+
+static inline uint32_t make_key(const flexray_frame_t *frame)
+{
+    return ((uint32_t)(frame->source & 1u) << 17) |
+           ((uint32_t)(frame->frame_id & 0x7FFu) << 6) |
+           (uint32_t)(frame->cycle_count & table_mux_mask);
+}
+
+static inline uint32_t key_bucket(uint32_t key)
+{
+    return (key * 2654435761u) & TABLE_BUCKET_MASK;
+}
+
+static void list_unlink(uint16_t i)
+{
+    frame_table_entry_t *e = &entries[i];
+    if (e->prev != TABLE_NONE) {
+        entries[e->prev].next = e->next;
+    } else {
+        list_head = e->next;
+    }
+    if (e->next != TABLE_NONE) {
+        entries[e->next].prev = e->prev;
+    } else {
+        list_tail = e->prev;
+    }
+}
+
+static void list_append(uint16_t i)
+{
+    entries[i].prev = list_tail;
+    entries[i].next = TABLE_NONE;
+    if (list_tail != TABLE_NONE) {
+        entries[list_tail].next = i;
+    } else {
+        list_head = i;
+    }
+    list_tail = i;
+}
+
+void frame_table_reset(uint8_t cycle_mux_mask)
+{
+    memset(buckets, 0xFF, sizeof(buckets));
+    entry_count = 0;
+    list_head = TABLE_NONE;
+    list_tail = TABLE_NONE;
+    table_seq = 0;
+    table_mux_mask = (uint8_t)(cycle_mux_mask & 0x3F);
+    memset(&table_stats, 0, sizeof(table_stats));
+}
+
+void __not_in_flash_func(frame_table_update)(const flexray_frame_t *frame)
+{
+    uint32_t key = make_key(frame);
+    uint32_t b = key_bucket(key);
+    uint16_t i;
+    table_stats.updates++;
+    while ((i = buckets[b]) != TABLE_NONE && entries[i].key != key) {
+        b = (b + 1u) & TABLE_BUCKET_MASK;
+    }
+
+    uint8_t len = (uint8_t)(frame->payload_length_words * 2u);
+    if (len > MAX_FRAME_PAYLOAD_BYTES) {
+        len = MAX_FRAME_PAYLOAD_BYTES;
+    }
+    frame_table_entry_t *e;
+    if (i == TABLE_NONE) {
+        if (entry_count >= FLEXRAY_FRAME_TABLE_SIZE) {
+            table_stats.table_full++;
+            return;
+        }
+        i = entry_count++;
+        buckets[b] = i;
+        e = &entries[i];
+        e->key = key;
+        table_stats.entries = entry_count;
+    } else {
+        e = &entries[i];
+        e->last_seen_us = time_us_32();
+        e->cycle_count = frame->cycle_count;
+        if (e->payload_len == len && e->indicators == frame->indicators &&
+            memcmp(e->payload, frame->payload, len) == 0) {
+            return;
+        }
+        list_unlink(i);
+    }
+
+    e->last_seen_us = time_us_32();
+    e->cycle_count = frame->cycle_count;
+    e->indicators = frame->indicators;
+    e->payload_len = len;
+    memcpy(e->payload, frame->payload, len);
+    e->seq = ++table_seq;
+    table_stats.changes = table_seq;
+    list_append(i);
+}
+
+uint16_t frame_table_read(uint32_t since_seq, uint8_t *out, uint16_t cap)
+{
+    uint8_t flags = 0;
+    if (since_seq > table_seq) {
+        since_seq = 0;
+        flags |= FRAME_TABLE_FLAG_RESET;
+    }
+
+    // Walk back from the newest change to the first one after since_seq
+    uint16_t i = list_tail;
+    uint16_t start = TABLE_NONE;
+    while (i != TABLE_NONE && entries[i].seq > since_seq) {
+        start = i;
+        i = entries[i].prev;
+    }
+
+    uint16_t count = 0;
+    uint16_t w = FRAME_TABLE_HEADER_BYTES;
+    for (i = start; i != TABLE_NONE; i = entries[i].next) {
+        const frame_table_entry_t *e = &entries[i];
+        uint16_t need = (uint16_t)(FRAME_TABLE_ENTRY_HEADER_BYTES + e->payload_len);
+        if ((uint32_t)w + need > cap) {
+            flags |= FRAME_TABLE_FLAG_MORE;
+            break;
+        }
+        uint16_t frame_id = (uint16_t)((e->key >> 6) & 0x7FFu);
+        memcpy(&out[w], &e->seq, 4);
+        memcpy(&out[w + 4], &e->last_seen_us, 4);
+        memcpy(&out[w + 8], &frame_id, 2);
+        out[w + 10] = (uint8_t)(e->key >> 17);
+        out[w + 11] = e->cycle_count;
+        out[w + 12] = e->indicators;
+        out[w + 13] = e->payload_len;
+        memcpy(&out[w + FRAME_TABLE_ENTRY_HEADER_BYTES], e->payload, e->payload_len);
+        w = (uint16_t)(w + need);
+        count++;
+    }
+
+    if (cap >= FRAME_TABLE_HEADER_BYTES) {
+        memcpy(&out[0], &table_seq, 4);
+        memcpy(&out[4], &count, 2);
+        out[6] = flags;
+        out[7] = 0;
+        return w;
+    }
+    return 0;
+}
+
+void frame_table_get_stats(frame_table_stats_t *out)
+{
+    *out = table_stats;
+}
@@ -0,0 +1,47 @@
+#ifndef FLEXRAY_FRAME_TABLE_H
+#define FLEXRAY_FRAME_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flexray_frame.h"
+
+// Latest payload per (source, frame_id, cycle_count & mux), updated by the
+// core0 parse loop and read with FLEXRAY_READ_FRAME_TABLE, so pollers can
+// see current values without consuming the bulk stream.
+//
+// Every payload change takes the next table sequence number. A read returns
+// the entries changed after since_seq, oldest change first:
+//
+//   wValue = since_seq & 0xFFFF, wIndex = since_seq >> 16
+//   [u32 table_seq][u16 count][u8 flags][u8 reserved]
+//   count x [u32 seq][u32 last_seen_us][u16 frame_id][u8 source][u8 cycle_count]
+//           [u8 indicators][u8 payload_len][payload_len bytes]
+//
+// FRAME_TABLE_FLAG_MORE means the reply was full; read again with the seq of
+// the last entry. FRAME_TABLE_FLAG_RESET means since_seq is ahead of the
+// table (it was reset), so the reply starts from scratch.
+
+#ifndef FLEXRAY_FRAME_TABLE_SIZE
+#define FLEXRAY_FRAME_TABLE_SIZE 256u // entries, power of two (CMake option)
+#endif
+
+#define FRAME_TABLE_HEADER_BYTES       8u
+#define FRAME_TABLE_ENTRY_HEADER_BYTES 14u
+#define FRAME_TABLE_FLAG_MORE          0x01
+#define FRAME_TABLE_FLAG_RESET         0x02
+
+typedef struct {
+    uint32_t entries;      // keys in use
+    uint32_t updates;      // frames seen
+    uint32_t changes;      // payload changes (table_seq)
+    uint32_t table_full;   // frames of new keys dropped, table at capacity
+} frame_table_stats_t;
+
+// Clear all entries; cycle_mux_mask selects which cycle_count bits are part of the key
+void frame_table_reset(uint8_t cycle_mux_mask);
+void frame_table_update(const flexray_frame_t *frame);
+// Fill out with the reply described above; returns its length
+uint16_t frame_table_read(uint32_t since_seq, uint8_t *out, uint16_t cap);
+void frame_table_get_stats(frame_table_stats_t *out);
+
+#endif // FLEXRAY_FRAME_TABLE_H
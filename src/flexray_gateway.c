@@ -0,0 +1,210 @@
+#include "flexray_gateway.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "flexray_frame.h"
+#include "flexray_injector_rules.h"
+
+// Same double buffering and reload guard as flexray_predicate.c: core0
+// writes the inactive copy and publishes it by bumping gen, which is the
+// generation and (gen & 1) the active copy in one atomic store. Core1 flags
+// its passes over the routes (`reading`) and publishes the generation each
+// route was last used at, and core0 refuses a reload while core1 may still
+// be on the copy it would overwrite. Everything below seen_gen is core1 only.
+typedef struct {
+    gateway_route_t cfg[2];
+    volatile uint32_t gen;
+    volatile uint32_t seen_gen;   // core1: gen the value and stats belong to
+    bool fresh;
+    int32_t value;
+    gateway_stats_t stats;
+} gateway_slot_t;
+
+static gateway_slot_t slots[GATEWAY_MAX_ROUTES];
+static volatile uint32_t enabled_mask = 0;
+static volatile uint8_t reading = 0; // core1: inside gateway_observe/gateway_apply
+
+static inline uint8_t field_bytes(const gateway_field_t *f)
+{
+    return (uint8_t)((f->start_bit + f->bits + 7u) / 8u);
+}
+
+bool gateway_field_valid(const gateway_field_t *f)
+{
+    return f->bits >= 1u && f->bits <= 32u && (uint32_t)f->start_bit + f->bits <= 32u &&
+           (uint32_t)f->byte_offset + field_bytes(f) <= MAX_FRAME_PAYLOAD_BYTES;
+}
+
+gateway_result_t gateway_set_route(uint8_t index, const gateway_route_t *route)
+{
+    if (index >= GATEWAY_MAX_ROUTES) {
+        return GATEWAY_INVALID;
+    }
+    bool enable = route->source_dir_mask != 0;
+    if (enable && (route->rule >= NUM_TRIGGER_RULES || !gateway_field_valid(&route->src) ||
+                   !gateway_field_valid(&route->dst) || route->min > route->max)) {
+        return GATEWAY_INVALID;
+    }
+    gateway_slot_t *slot = &slots[index];
+    uint32_t gen = slot->gen;
+    if (__atomic_load_n(&slot->seen_gen, __ATOMIC_SEQ_CST) != gen &&
+        __atomic_load_n(&reading, __ATOMIC_SEQ_CST)) {
+        return GATEWAY_BUSY;
+    }
+    slot->cfg[(gen + 1u) & 1u] = *route;
+    __atomic_store_n(&slot->gen, gen + 1u, __ATOMIC_SEQ_CST);
+    if (enable) {
+        __atomic_fetch_or(&enabled_mask, 1u << index, __ATOMIC_RELEASE);
+    } else {
+        __atomic_fetch_and(&enabled_mask, ~(1u << index), __ATOMIC_RELEASE);
+    }
+    return GATEWAY_OK;
+}
+
+bool gateway_get_route(uint8_t index, gateway_route_t *out)
+{
+    if (index >= GATEWAY_MAX_ROUTES) {
+        return false;
+    }
+    *out = slots[index].cfg[slots[index].gen & 1u];
+    return true;
+}
+
+// Core1, with `reading` set for as long as the route is used
+static inline const gateway_route_t *current(gateway_slot_t *slot)
+{
+    uint32_t gen = __atomic_load_n(&slot->gen, __ATOMIC_SEQ_CST);
+    if (slot->seen_gen != gen) {
+        slot->fresh = false;
+        memset(&slot->stats, 0, sizeof(slot->stats));
+        __atomic_store_n(&slot->seen_gen, gen, __ATOMIC_RELEASE);
+    }
+    return &slot->cfg[gen & 1u];
+}
+
+static inline uint32_t field_mask(uint8_t bits)
+{
+    return bits >= 32u ? 0xFFFFFFFFu : ((1u << bits) - 1u);
+}
+
+bool __time_critical_func(gateway_field_store)(const gateway_field_t *f, uint8_t *payload, uint16_t payload_len,
+                                               uint32_t value)
+{
+    uint8_t n = field_bytes(f);
+    if ((uint32_t)f->byte_offset + n > payload_len) {
+        return false;
+    }
+    uint8_t *p = &payload[f->byte_offset];
+    uint32_t window = 0;
+    for (uint8_t k = 0; k < n; k++) {
+        window |= (f->flags & GATEWAY_FIELD_LE) ? (uint32_t)p[k] << (8u * k) : (uint32_t)p[k] << (8u * (n - 1u - k));
+    }
+    uint32_t m = field_mask(f->bits) << f->start_bit;
+    window = (window & ~m) | ((value << f->start_bit) & m);
+    for (uint8_t k = 0; k < n; k++) {
+        p[k] = (uint8_t)((f->flags & GATEWAY_FIELD_LE) ? window >> (8u * k) : window >> (8u * (n - 1u - k)));
+    }
+    return true;
+}
+
+void __time_critical_func(gateway_observe)(uint16_t frame_id, uint8_t cycle_count, uint8_t dir,
+                                           const predicate_frame_t *frame)
+{
+    __atomic_store_n(&reading, 1, __ATOMIC_SEQ_CST);
+    uint32_t mask = __atomic_load_n(&enabled_mask, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; mask; i++, mask >>= 1) {
+        if (!(mask & 1u)) {
+            continue;
+        }
+        gateway_slot_t *slot = &slots[i];
+        const gateway_route_t *r = current(slot);
+        if (r->source_id != frame_id || !(r->source_dir_mask & (1u << dir)) ||
+            (uint8_t)(cycle_count & r->cycle_mask) != r->cycle_base) {
+            continue;
+        }
+        const gateway_field_t *f = &r->src;
+        uint8_t n = field_bytes(f);
+        if ((uint32_t)f->byte_offset + n > frame->payload_bytes) {
+            continue;
+        }
+        uint32_t base = frame->start + 5u + f->byte_offset;
+        uint32_t raw = 0;
+        for (uint8_t k = 0; k < n; k++) {
+            uint32_t b = frame->ring[(base + k) & frame->mask];
+            raw |= (f->flags & GATEWAY_FIELD_LE) ? b << (8u * k) : b << (8u * (n - 1u - k));
+        }
+        raw = (raw >> f->start_bit) & field_mask(f->bits);
+        int32_t in = (int32_t)raw;
+        if ((f->flags & GATEWAY_FIELD_SIGNED) && f->bits < 32u) {
+            uint32_t sign = 1u << (f->bits - 1u);
+            in = (int32_t)((raw ^ sign) - sign);
+        }
+
+        int64_t v = (((int64_t)in * r->scale_q16) + 0x8000) >> 16;
+        v += r->offset;
+        // Limits of the destination field itself
+        int64_t lo = r->min, hi = r->max;
+        if (r->dst.flags & GATEWAY_FIELD_SIGNED) {
+            int64_t half = (int64_t)1 << (r->dst.bits - 1u);
+            if (lo < -half) lo = -half;
+            if (hi > half - 1) hi = half - 1;
+        } else {
+            int64_t top = (int64_t)field_mask(r->dst.bits);
+            if (lo < 0) lo = 0;
+            if (hi > top) hi = top;
+        }
+        bool clamped = false;
+        if (v < lo) { v = lo; clamped = true; }
+        if (v > hi) { v = hi; clamped = true; }
+
+        slot->value = (int32_t)v;
+        slot->fresh = true;
+        slot->stats.updates++;
+        slot->stats.clamped += clamped ? 1u : 0u;
+        slot->stats.last_in = in;
+        slot->stats.last_out = (int32_t)v;
+    }
+    __atomic_store_n(&reading, 0, __ATOMIC_RELEASE);
+}
+
+bool __time_critical_func(gateway_apply)(uint8_t rule, uint8_t *payload, uint16_t payload_len)
+{
+    bool wrote = false;
+    __atomic_store_n(&reading, 1, __ATOMIC_SEQ_CST);
+    uint32_t mask = __atomic_load_n(&enabled_mask, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; mask; i++, mask >>= 1) {
+        if (!(mask & 1u)) {
+            continue;
+        }
+        gateway_slot_t *slot = &slots[i];
+        const gateway_route_t *r = current(slot);
+        if (r->rule != rule || !slot->fresh) {
+            continue;
+        }
+        if (!gateway_field_store(&r->dst, payload, payload_len, (uint32_t)slot->value)) {
+            continue;
+        }
+        slot->fresh = false;
+        slot->stats.applied++;
+        wrote = true;
+    }
+    __atomic_store_n(&reading, 0, __ATOMIC_RELEASE);
+    return wrote;
+}
+
+uint16_t gateway_read_stats(uint8_t *out, uint16_t cap)
+{
+    uint16_t w = 0;
+    uint32_t mask = enabled_mask;
+    for (uint32_t i = 0; i < GATEWAY_MAX_ROUTES && (uint32_t)w + sizeof(gateway_stats_t) <= cap; i++) {
+        gateway_stats_t s = slots[i].stats;
+        if (slots[i].seen_gen != slots[i].gen) {
+            memset(&s, 0, sizeof(s)); // not yet seen by core1 since it was set
+        }
+        s.route = (uint8_t)i;
+        s.enabled = (mask >> i) & 1u;
+        s.rule = slots[i].cfg[slots[i].gen & 1u].rule;
+        memcpy(&out[w], &s, sizeof(s));
+        w = (uint16_t)(w + sizeof(s));
+    }
+    return w;
+}
@@ -0,0 +1,92 @@
+#ifndef FLEXRAY_GATEWAY_H
+#define FLEXRAY_GATEWAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flexray_predicate.h"
+
+// On-device signal gateway. A route copies one signal from an observed frame
+// into the target template of an injection rule, so simple gateway functions
+// run without the host: the value is read in the streamer ISR when the
+// source frame ends and written by fire_rule the next time the rule's
+// trigger arrives, followed by the usual E2E and frame CRC refresh.
+//
+//   out = clamp(((in * scale_q16) >> 16) + offset, min, max)
+//
+// and out is also clamped to what the destination field can hold. A routed
+// value is used once: if the source stops, so does the injection. When a
+// host override is queued for the same rule its slice is applied first and
+// routed fields are written on top. Routes do not apply to timed rules.
+//
+// Fields are up to 32 bits inside a window of up to 4 payload bytes starting
+// at byte_offset, read big-endian (FlexRay/Motorola) unless GATEWAY_FIELD_LE.
+// start_bit is the field's LSB counted from the LSB of that window.
+//
+// Routes are set one at a time with op 0x9C; a route with source_dir_mask 0
+// is disabled. Read (FLEXRAY_READ_GATEWAY): gateway_stats_t per route.
+
+#define GATEWAY_MAX_ROUTES 8u
+
+#define GATEWAY_FIELD_LE     0x01
+#define GATEWAY_FIELD_SIGNED 0x02
+
+typedef struct __attribute__((packed)) {
+    uint8_t byte_offset;          // payload-relative
+    uint8_t start_bit;
+    uint8_t bits;                 // 1..32, start_bit + bits <= 32
+    uint8_t flags;                // GATEWAY_FIELD_*
+} gateway_field_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t source_id;
+    uint8_t source_dir_mask;      // FILTER_DIR_* the source is taken from, 0 = disabled
+    uint8_t cycle_mask;           // source cycles: (cycle & mask) == base
+    uint8_t cycle_base;
+    uint8_t rule;                 // injection rule whose target receives the value
+    uint16_t reserved;
+    gateway_field_t src;
+    gateway_field_t dst;
+    int32_t scale_q16;            // 0x10000 = 1.0
+    int32_t offset;
+    int32_t min;
+    int32_t max;
+} gateway_route_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t route;
+    uint8_t enabled;
+    uint8_t rule;
+    uint8_t reserved;
+    uint32_t updates;             // source frames read
+    uint32_t applied;             // values written into an injected frame
+    uint32_t clamped;             // updates that hit a limit
+    int32_t last_in;              // raw source field
+    int32_t last_out;             // value after scaling and clamping
+} gateway_stats_t;
+
+typedef enum {
+    GATEWAY_OK = 0,
+    GATEWAY_INVALID,
+    GATEWAY_BUSY,                 // core1 may still use the copy a reload would overwrite
+} gateway_result_t;
+
+// Core0 (USB). Unless GATEWAY_OK the route is left unchanged.
+gateway_result_t gateway_set_route(uint8_t index, const gateway_route_t *route);
+bool gateway_get_route(uint8_t index, gateway_route_t *out);
+
+// Core1 streamer ISR, for every frame before try_inject_frame.
+// dir is FROM_ECU or FROM_VEHICLE.
+void gateway_observe(uint16_t frame_id, uint8_t cycle_count, uint8_t dir, const predicate_frame_t *frame);
+
+// Core1, from fire_rule: write fresh routed values for rule into a template
+// payload. True if anything was written.
+bool gateway_apply(uint8_t rule, uint8_t *payload, uint16_t payload_len);
+
+uint16_t gateway_read_stats(uint8_t *out, uint16_t cap);
+
+// Field helpers, shared with flexray_signals.c. store writes the low bits of
+// value into the field; false if the field does not fit payload_len.
+bool gateway_field_valid(const gateway_field_t *f);
+bool gateway_field_store(const gateway_field_t *f, uint8_t *payload, uint16_t payload_len, uint32_t value);
+
+#endif // FLEXRAY_GATEWAY_H
@@ -0,0 +1,133 @@
+#include "flexray_id_stats.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "flexray_filter.h"
+
+// Direct index (source, frame_id) -> entry, so the parse loop pays one load
+// and a few adds per frame. Core0 only, no locking.
+
+#define ID_STATS_NONE 0xFFFFu
+
+static uint16_t id_index[2][FLEXRAY_MAX_FRAME_ID];
+static id_stats_entry_t id_entries[ID_STATS_ENTRIES];
+static uint16_t id_entry_count = 0;
+static uint32_t id_table_full = 0;
+// last_seen_us of the entry is an exact frame end, usable as interval start
+static bool id_time_exact[ID_STATS_ENTRIES];
+
+void id_stats_reset(void)
+{
+    memset(id_index, 0xFF, sizeof(id_index));
+    id_entry_count = 0;
+    id_table_full = 0;
+}
+
+static inline id_stats_entry_t *lookup(uint16_t frame_id, uint8_t source, bool create)
+{
+    uint16_t *slot = &id_index[source & 1u][frame_id & 0x7FFu];
+    if (*slot != ID_STATS_NONE) {
+        return &id_entries[*slot];
+    }
+    if (!create) {
+        return NULL;
+    }
+    if (id_entry_count >= ID_STATS_ENTRIES) {
+        id_table_full++;
+        return NULL;
+    }
+    id_stats_entry_t *e = &id_entries[id_entry_count];
+    memset(e, 0, sizeof(*e));
+    e->frame_id = frame_id & 0x7FFu;
+    e->source = source & 1u;
+    id_time_exact[id_entry_count] = false;
+    *slot = id_entry_count++;
+    return e;
+}
+
+static inline uint8_t jitter_bin(uint32_t jitter_us)
+{
+    uint8_t bin = 0;
+    while (jitter_us > 1u && bin < ID_STATS_JITTER_BINS - 1u) {
+        jitter_us >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+void __not_in_flash_func(id_stats_update)(uint16_t frame_id, uint8_t cycle_count, uint8_t source,
+                                          uint8_t payload_words, bool timed, uint32_t end_us)
+{
+    id_stats_entry_t *e = lookup(frame_id, source, true);
+    if (e == NULL) {
+        return;
+    }
+    e->frames++;
+    e->payload_words = payload_words;
+    e->cycle_mask |= 1ull << (cycle_count & 0x3Fu);
+    bool *exact = &id_time_exact[e - id_entries];
+    if (!timed) {
+        // Chunk end is only an upper bound for this frame: keep it as last
+        // seen, but do not measure the next interval from it
+        e->last_seen_us = end_us;
+        e->last_interval_us = 0;
+        *exact = false;
+        return;
+    }
+    if (*exact) {
+        uint32_t interval = end_us - e->last_seen_us;
+        if (e->min_interval_us == 0 || interval < e->min_interval_us) {
+            e->min_interval_us = interval;
+        }
+        if (interval > e->max_interval_us) {
+            e->max_interval_us = interval;
+        }
+        if (interval > e->min_interval_us + (e->min_interval_us >> 1)) {
+            e->gaps++;
+            interval = 0; // do not compare the next interval against a gap
+        } else if (e->last_interval_us != 0) {
+            uint32_t prev = e->last_interval_us;
+            uint32_t jitter = interval > prev ? interval - prev : prev - interval;
+            uint8_t bin = jitter_bin(jitter);
+            if (e->jitter_hist[bin] != UINT16_MAX) {
+                e->jitter_hist[bin]++;
+            }
+        }
+        e->last_interval_us = interval;
+    }
+    e->last_seen_us = end_us;
+    *exact = true;
+}
+
+void id_stats_crc_fail(uint16_t frame_id, uint8_t source)
+{
+    id_stats_entry_t *e = lookup(frame_id, source, false);
+    if (e != NULL) {
+        e->crc_fail++;
+    }
+}
+
+uint16_t id_stats_read(uint16_t first, uint8_t *out, uint16_t cap)
+{
+    if (cap < ID_STATS_HEADER_BYTES) {
+        return 0;
+    }
+    uint16_t count = 0;
+    uint16_t w = ID_STATS_HEADER_BYTES;
+    for (uint16_t i = first; i < id_entry_count && (uint32_t)w + sizeof(id_stats_entry_t) <= cap; i++) {
+        memcpy(&out[w], &id_entries[i], sizeof(id_stats_entry_t));
+        w = (uint16_t)(w + sizeof(id_stats_entry_t));
+        count++;
+    }
+    memcpy(&out[0], &id_entry_count, 2);
+    memcpy(&out[2], &first, 2);
+    memcpy(&out[4], &count, 2);
+    out[6] = (uint8_t)sizeof(id_stats_entry_t);
+    out[7] = 0;
+    return w;
+}
+
+void id_stats_get_summary(id_stats_summary_t *out)
+{
+    out->entries = id_entry_count;
+    out->table_full = id_table_full;
+}
@@ -0,0 +1,54 @@
+#ifndef FLEXRAY_ID_STATS_H
+#define FLEXRAY_ID_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Per-(source, frame ID) traffic statistics kept by the core0 parse loop and
+// read with FLEXRAY_READ_ID_STATS. Entries are allocated on first sight.
+//
+// Timing uses the frame-end timestamp from the streamer ISR, which is only
+// exact for the last frame of a notification chunk; other frames update the
+// counters and last_seen_us (to the chunk end) but not the interval/jitter
+// fields. Jitter is the change between
+// consecutive inter-arrival intervals, binned in powers of two:
+// bucket 0 = 0..1 us, 1 = 2..3 us, ..., 7 = 128 us and more. An interval
+// longer than 1.5x the shortest seen counts as a gap (missed occurrence).
+//
+// Read: wValue = first entry index; the reply is
+//   [u16 total_entries][u16 first][u16 count][u8 entry_size][u8 reserved]
+//   count x id_stats_entry_t
+
+#define ID_STATS_ENTRIES      512u
+#define ID_STATS_JITTER_BINS  8u
+#define ID_STATS_HEADER_BYTES 8u
+
+typedef struct __attribute__((packed)) {
+    uint16_t frame_id;
+    uint8_t source;               // FROM_ECU / FROM_VEHICLE
+    uint8_t payload_words;        // last seen payload length
+    uint32_t frames;
+    uint32_t crc_fail;            // parsed but failed header/frame CRC
+    uint32_t gaps;
+    uint32_t last_seen_us;
+    uint32_t last_interval_us;
+    uint32_t min_interval_us;     // 0 until two timed frames were seen
+    uint32_t max_interval_us;
+    uint64_t cycle_mask;          // bit n set once cycle_count n was seen
+    uint16_t jitter_hist[ID_STATS_JITTER_BINS];
+} id_stats_entry_t;
+
+typedef struct {
+    uint32_t entries;
+    uint32_t table_full;          // frames of new IDs dropped, table at capacity
+} id_stats_summary_t;
+
+void id_stats_reset(void);
+// timed: end_us is this frame's end (last frame of its chunk)
+void id_stats_update(uint16_t frame_id, uint8_t cycle_count, uint8_t source, uint8_t payload_words,
+                     bool timed, uint32_t end_us);
+void id_stats_crc_fail(uint16_t frame_id, uint8_t source);
+uint16_t id_stats_read(uint16_t first, uint8_t *out, uint16_t cap);
+void id_stats_get_summary(id_stats_summary_t *out);
+
+#endif // FLEXRAY_ID_STATS_H
@@ -13,6 +13,7 @@ typedef struct {
 	uint8_t e2e_offset;
 	uint8_t e2e_len;
 	uint8_t e2e_init_value;
+	uint8_t override_crc_init; // CRC8 seed of the slices hosts submit with op 0x90/0x9A
 	uint8_t replace_offset;
 	uint8_t replace_len;
 	uint8_t direction;
@@ -28,6 +29,7 @@ static const trigger_rule_t INJECT_TRIGGERS[] = {
 		.e2e_offset = 0,
 		.e2e_len = 15,
 		.e2e_init_value = 0xd6,
+		.override_crc_init = 0xf1,
 		.replace_offset = 2,
 		.replace_len = 14,
 		.direction = INJECT_DIRECTION_TO_ECU,
@@ -0,0 +1,145 @@
+#include "flexray_log.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+
+// Bounded MPSC ring. A producer reserves an index with a CAS on log_head,
+// fills the slot, then publishes it by storing index+1 into slot->seq. The
+// consumer only takes the slot at log_tail once its seq matches, so a producer
+// preempted mid-write (ISR, other core) simply delays the reader. RP2350's
+// global exclusive monitor makes the LDREX/STREX CAS safe across both cores.
+
+#define LOG_RING_MASK (FLEXRAY_LOG_RING_SIZE - 1u)
+
+typedef struct {
+    volatile uint32_t seq;
+    flexray_log_record_t rec;
+} log_slot_t;
+
+static log_slot_t log_ring[FLEXRAY_LOG_RING_SIZE];
+static volatile uint32_t log_head = 0;
+static volatile uint32_t log_tail = 0;
+static volatile uint32_t log_dropped = 0;
+static volatile flexray_log_sink_t log_sink = LOG_SINK_UART;
+
+void flexray_log_init(void)
+{
+    memset(log_ring, 0, sizeof(log_ring));
+    log_head = 0;
+    log_tail = 0;
+    log_dropped = 0;
+}
+
+bool __not_in_flash_func(flexray_log_write)(uint16_t id, uint8_t nargs, const uint32_t *args)
+{
+    uint32_t head = __atomic_load_n(&log_head, __ATOMIC_RELAXED);
+    do {
+        if ((uint32_t)(head - __atomic_load_n(&log_tail, __ATOMIC_ACQUIRE)) >= FLEXRAY_LOG_RING_SIZE) {
+            __atomic_fetch_add(&log_dropped, 1u, __ATOMIC_RELAXED);
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&log_head, &head, head + 1u, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    log_slot_t *slot = &log_ring[head & LOG_RING_MASK];
+    if (nargs > FLEXRAY_LOG_MAX_ARGS) nargs = FLEXRAY_LOG_MAX_ARGS;
+    slot->rec.id = id;
+    slot->rec.nargs = nargs;
+    slot->rec.core = (uint8_t)get_core_num();
+    slot->rec.timestamp_us = time_us_32();
+    for (uint8_t i = 0; i < FLEXRAY_LOG_MAX_ARGS; i++) {
+        slot->rec.args[i] = (i < nargs) ? args[i] : 0u;
+    }
+    __atomic_store_n(&slot->seq, head + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool flexray_log_pop(flexray_log_record_t *out)
+{
+    uint32_t tail = log_tail;
+    log_slot_t *slot = &log_ring[tail & LOG_RING_MASK];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != tail + 1u) {
+        return false; // empty, or the producer has not published yet
+    }
+    memcpy(out, &slot->rec, sizeof(*out));
+    __atomic_store_n(&log_tail, tail + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t flexray_log_dropped(void)
+{
+    return log_dropped;
+}
+
+void flexray_log_set_sink(flexray_log_sink_t sink)
+{
+    log_sink = sink;
+}
+
+flexray_log_sink_t flexray_log_get_sink(void)
+{
+    return log_sink;
+}
+
+#if FLEXRAY_LOG_UART
+#define FLEXRAY_LOG_FORMAT_ENTRY(name, fmt) fmt,
+static const char *const log_formats[LOG_MESSAGE_COUNT] = {
+    FLEXRAY_LOG_MESSAGES(FLEXRAY_LOG_FORMAT_ENTRY)
+};
+#undef FLEXRAY_LOG_FORMAT_ENTRY
+
+static char uart_line[192];
+static uint16_t uart_line_len = 0;
+static uint16_t uart_line_pos = 0;
+
+static uint16_t format_record(const flexray_log_record_t *rec, char *buf, size_t cap)
+{
+    int n;
+    if (rec->id < LOG_MESSAGE_COUNT) {
+        const uint32_t *a = rec->args;
+        n = snprintf(buf, cap, log_formats[rec->id], a[0], a[1], a[2], a[3], a[4], a[5]);
+    } else {
+        n = snprintf(buf, cap, "log id %u\n", rec->id);
+    }
+    if (n < 0) return 0;
+    if ((size_t)n >= cap) n = (int)cap - 1;
+    // Raw UART writes bypass stdio's CRLF translation
+    if (n > 0 && buf[n - 1] == '\n' && (size_t)n + 1 < cap) {
+        buf[n - 1] = '\r';
+        buf[n++] = '\n';
+        buf[n] = '\0';
+    }
+    return (uint16_t)n;
+}
+
+bool flexray_log_uart_pump(void)
+{
+    if (log_sink != LOG_SINK_UART) {
+        return false;
+    }
+    uart_inst_t *uart = uart_get_instance(PICO_DEFAULT_UART);
+    while (true) {
+        if (uart_line_pos >= uart_line_len) {
+            flexray_log_record_t rec;
+            if (!flexray_log_pop(&rec)) {
+                return false;
+            }
+            uart_line_len = format_record(&rec, uart_line, sizeof(uart_line));
+            uart_line_pos = 0;
+        }
+        while (uart_line_pos < uart_line_len && uart_is_writable(uart)) {
+            uart_putc_raw(uart, uart_line[uart_line_pos++]);
+        }
+        if (uart_line_pos < uart_line_len) {
+            return true; // TX FIFO full: resume on the next idle pass
+        }
+    }
+}
+#else
+bool flexray_log_uart_pump(void)
+{
+    return false;
+}
+#endif
@@ -0,0 +1,111 @@
+#ifndef FLEXRAY_LOG_H
+#define FLEXRAY_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Deferred binary logging: producers store a message ID plus raw uint32_t
+// arguments in a lock-free ring; formatting happens later, either by the
+// non-blocking UART pump on core0's idle path or on the host
+// (flexray_log_reader.py reads records over USB and decodes them with the
+// table below).
+
+// Ring capacity in records (power of two)
+#ifndef FLEXRAY_LOG_RING_SIZE
+#define FLEXRAY_LOG_RING_SIZE 256u
+#endif
+
+// Build the UART pump (set to 0 to leave USB as the only drain)
+#ifndef FLEXRAY_LOG_UART
+#define FLEXRAY_LOG_UART 1
+#endif
+
+#define FLEXRAY_LOG_MAX_ARGS 6
+
+// Message table: IDs are assigned in order. flexray_log_reader.py parses this
+// macro to decode records, so keep one X(...) entry per line.
+#define FLEXRAY_LOG_MESSAGES(X) \
+    X(LOG_RING_STATS,          "Ring Stats: total=%lu seq_gap=%lu src[ECU=%lu,VEH=%lu] len_ok=%lu len_mis=%lu\n") \
+    X(LOG_RING_STATS_2,        "Ring Stats: overflow=%lu zero=%lu parse_fail=%lu valid=%lu | fps[frames=%lu/s,valid=%lu/s]\n") \
+    X(LOG_NOTIFY_DROPPED,      "Notify dropped=%lu\n") \
+    X(LOG_RAM_USAGE,           "RAM usage: heap_used=%lu B, stack_used=%lu B, gap(heap->sp)=%lu B, stack_free=%lu B\n") \
+    X(LOG_CTRL_READ_UNKNOWN,   "Control Read: Unknown request 0x%02lx\n") \
+    X(LOG_CTRL_WRITE_UNKNOWN,  "Control Write: Unknown request 0x%02lx\n") \
+    X(LOG_CTRL_DATA_UNKNOWN,   "Control Data: Unexpected request 0x%02lx with %lu bytes\n") \
+    X(LOG_CTRL_FD_AUTO_SWITCH, "Control Data: SET_CAN_FD_AUTO_SWITCH -> %lu\n") \
+    X(LOG_CTRL_CAN_SPEED,      "Control Data: SET_CAN_SPEED_KBPS bus=%lu speed=%lu kbps\n") \
+    X(LOG_CTRL_CAN_SPEED_BUS,  "Control Data: SET_CAN_SPEED_KBPS invalid bus_id=%lu\n") \
+    X(LOG_CTRL_CAN_SPEED_LEN,  "Control Data: SET_CAN_SPEED_KBPS insufficient data (got %lu bytes)\n") \
+    X(LOG_CTRL_FD_BITRATE,     "Control Data: SET_CAN_FD_DATA_BITRATE bus=%lu data_speed=%lu kbps\n") \
+    X(LOG_CTRL_FD_BITRATE_BUS, "Control Data: SET_CAN_FD_DATA_BITRATE invalid bus_id=%lu\n") \
+    X(LOG_CTRL_FD_BITRATE_LEN, "Control Data: SET_CAN_FD_DATA_BITRATE insufficient data (got %lu bytes)\n") \
+    X(LOG_USB_MOUNTED,         "USB Device mounted\n") \
+    X(LOG_USB_UNMOUNTED,       "USB Device unmounted\n") \
+    X(LOG_USB_SUSPENDED,       "USB Device suspended\n") \
+    X(LOG_USB_RESUMED,         "USB Device resumed\n") \
+    X(LOG_FIFO_RESET,          "FlexRay FIFO reset\n") \
+    X(LOG_FILTER_STATS,        "Stream filter: filtered=%lu id=%lu cycle=%lu decimated=%lu null=%lu\n") \
+    X(LOG_CODEC_STATS,         "Stream codec: full=%lu keyframes=%lu unchanged=%lu suppressed=%lu table_full=%lu\n") \
+    X(LOG_CODEC_DELTA_STATS,   "Stream codec: delta=%lu delta_saved=%lu B ref_pool_full=%lu\n") \
+    X(LOG_FLUSH_STATS,         "USB flush: mode=%lu flushes=%lu threshold=%lu timer=%lu full=%lu bytes=%lu\n") \
+    X(LOG_FLUSH_STATS_2,       "USB flush: avg_hold=%lu us max_hold=%lu us throughput=%lu B/s\n") \
+    X(LOG_QOS_STATS,           "FIFO QoS: control=%lu/%lu normal=%lu/%lu bulk=%lu/%lu (queued/dropped)\n") \
+    X(LOG_SNAPSHOT_STATS,      "Cycle snapshots: sealed=%lu replaced=%lu overflow=%lu out_of_order=%lu\n") \
+    X(LOG_INTR_STATS,          "Override EP: rx=%lu tx=%lu msgs=%lu dropped=%lu ack_dropped=%lu\n") \
+    X(LOG_FRAME_TABLE_STATS,   "Frame table: entries=%lu updates=%lu changes=%lu table_full=%lu\n") \
+    X(LOG_ID_STATS,            "ID stats: entries=%lu table_full=%lu\n") \
+    X(LOG_TRIGGER_TUNER,       "Trigger tuner: target=0x%03lx trigger=0x%03lx recommended=0x%03lx slack_min=%ld us latency_max=%lu us status=%lu\n") \
+    X(LOG_TIMEBASE,            "Timebase: locked=%lu period=%lu ns drift=%ld ppb jitter_avg=%lu ns jitter_max=%lu ns locks=%lu\n") \
+    X(LOG_TIMEBASE_MODEL,      "Timebase: macrotick=%lu ps cycle=%lu MT static_slot=%lu MT static_slots=%lu fit_points=%lu\n") \
+    X(LOG_INVALID_FRAMES,      "Invalid frames: crc_fail=%lu\n")
+
+#define FLEXRAY_LOG_ENUM_ENTRY(name, fmt) name,
+typedef enum {
+    FLEXRAY_LOG_MESSAGES(FLEXRAY_LOG_ENUM_ENTRY)
+    LOG_MESSAGE_COUNT
+} flexray_log_id_t;
+#undef FLEXRAY_LOG_ENUM_ENTRY
+
+// One decoded record, also the wire format of FLEXRAY_READ_LOG (32 bytes, LE)
+typedef struct {
+    uint16_t id;
+    uint8_t nargs;
+    uint8_t core;
+    uint32_t timestamp_us;
+    uint32_t args[FLEXRAY_LOG_MAX_ARGS];
+} flexray_log_record_t;
+
+// Where records are drained to
+typedef enum {
+    LOG_SINK_UART = 0,
+    LOG_SINK_USB = 1,
+} flexray_log_sink_t;
+
+void flexray_log_init(void);
+
+// Safe from either core and from interrupt context. Never blocks; returns
+// false (and counts a drop) when the ring is full.
+bool flexray_log_write(uint16_t id, uint8_t nargs, const uint32_t *args);
+
+// Single consumer (core0 main loop / USB control handler)
+bool flexray_log_pop(flexray_log_record_t *out);
+uint32_t flexray_log_dropped(void);
+
+void flexray_log_set_sink(flexray_log_sink_t sink);
+flexray_log_sink_t flexray_log_get_sink(void);
+
+// Feed pending records to the UART without ever waiting on it. Call from the
+// idle path; does nothing unless the sink is LOG_SINK_UART. Returns true while
+// output is still pending, so the caller should not sleep.
+bool flexray_log_uart_pump(void);
+
+#define FLOG0(id)                       flexray_log_write((id), 0, NULL)
+#define FLOG1(id, a)                    flexray_log_write((id), 1, (const uint32_t[]){(uint32_t)(a)})
+#define FLOG2(id, a, b)                 flexray_log_write((id), 2, (const uint32_t[]){(uint32_t)(a), (uint32_t)(b)})
+#define FLOG3(id, a, b, c)              flexray_log_write((id), 3, (const uint32_t[]){(uint32_t)(a), (uint32_t)(b), (uint32_t)(c)})
+#define FLOG4(id, a, b, c, d)           flexray_log_write((id), 4, (const uint32_t[]){(uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d)})
+#define FLOG5(id, a, b, c, d, e)        flexray_log_write((id), 5, (const uint32_t[]){(uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d), (uint32_t)(e)})
+#define FLOG6(id, a, b, c, d, e, f)     flexray_log_write((id), 6, (const uint32_t[]){(uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d), (uint32_t)(e), (uint32_t)(f)})
+
+#endif // FLEXRAY_LOG_H
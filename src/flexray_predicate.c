@@ -0,0 +1,201 @@
+#include "flexray_predicate.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "flexray_injector_rules.h"
+#include "flexray_profile.h"
+
+// Double-buffered per rule: core0 fills the inactive copy and bumps `gen`
+// (the active copy is gen & 1), so core1 never sees a half-written program.
+// Several 0x9B ops in one bulk packet can reload a rule back to back, so the
+// inactive copy may still be the one core1 is evaluating. Core1 publishes the
+// generation it picked up (`seen`) and flags each evaluation (`reading`);
+// core0 refuses a reload while core1 may still be on the previous copy.
+typedef struct {
+    predicate_insn_t code[PREDICATE_MAX_INSNS];
+    uint8_t count;
+} predicate_prog_t;
+
+typedef struct {
+    predicate_prog_t prog[2];
+    volatile uint32_t gen;     // core0
+    volatile uint32_t seen;    // core1: last gen it evaluated
+    volatile uint8_t reading;  // core1: evaluation in progress
+    bool have_prev;            // core1 only from here on
+    int32_t prev;
+} predicate_slot_t;
+
+static predicate_slot_t slots[NUM_TRIGGER_RULES];
+static predicate_stats_t stats[NUM_TRIGGER_RULES]; // core1 writes counters
+static volatile bool stats_reset_pending = false;
+
+static bool check_insn(const predicate_insn_t *in)
+{
+    switch (in->op) {
+    case PRED_OP_LDB:
+        return in->a < PREDICATE_WINDOW_BYTES;
+    case PRED_OP_LDW:
+    case PRED_OP_LDWL:
+        return in->a + 1u < PREDICATE_WINDOW_BYTES;
+    case PRED_OP_SHR:
+        return in->a < 32u;
+    case PRED_OP_SEXT:
+        return in->a >= 1u && in->a <= 31u;
+    case PRED_OP_AND:
+    case PRED_OP_EQ:
+    case PRED_OP_NE:
+    case PRED_OP_LT:
+    case PRED_OP_LE:
+    case PRED_OP_GT:
+    case PRED_OP_GE:
+    case PRED_OP_RISE:
+    case PRED_OP_FALL:
+    case PRED_OP_OR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int predicate_load(uint8_t rule, const uint8_t *insns, uint8_t count)
+{
+    if (rule >= NUM_TRIGGER_RULES || count > PREDICATE_MAX_INSNS) {
+        return PREDICATE_MAX_INSNS;
+    }
+    predicate_slot_t *slot = &slots[rule];
+    uint32_t gen = slot->gen;
+    if (__atomic_load_n(&slot->seen, __ATOMIC_SEQ_CST) != gen &&
+        __atomic_load_n(&slot->reading, __ATOMIC_SEQ_CST)) {
+        return PREDICATE_LOAD_BUSY;
+    }
+    predicate_prog_t *next = &slot->prog[(gen + 1u) & 1u];
+    memcpy(next->code, insns, (size_t)count * sizeof(predicate_insn_t));
+    for (uint8_t i = 0; i < count; i++) {
+        if (!check_insn(&next->code[i])) {
+            return i;
+        }
+    }
+    next->count = count;
+    __atomic_store_n(&slot->gen, gen + 1u, __ATOMIC_SEQ_CST);
+    stats[rule].insns = count;
+    return -1;
+}
+
+static inline bool load(const predicate_frame_t *f, uint8_t off, uint8_t n, uint32_t *out, bool little)
+{
+    if ((uint32_t)off + n > f->payload_bytes) {
+        return false;
+    }
+    uint32_t i = f->start + 5u + off;
+    uint32_t b0 = f->ring[i & f->mask];
+    if (n == 1) {
+        *out = b0;
+        return true;
+    }
+    uint32_t b1 = f->ring[(i + 1u) & f->mask];
+    *out = little ? (b0 | (b1 << 8)) : ((b0 << 8) | b1);
+    return true;
+}
+
+bool __time_critical_func(predicate_eval)(uint8_t rule, const predicate_frame_t *frame)
+{
+    predicate_slot_t *slot = &slots[rule];
+    __atomic_store_n(&slot->reading, 1, __ATOMIC_SEQ_CST);
+    uint32_t gen = __atomic_load_n(&slot->gen, __ATOMIC_SEQ_CST);
+    if (gen != slot->seen) {
+        slot->have_prev = false; // RISE/FALL history belongs to the old program
+        __atomic_store_n(&slot->seen, gen, __ATOMIC_RELEASE);
+    }
+    const predicate_prog_t *p = &slot->prog[gen & 1u];
+    if (p->count == 0) {
+        __atomic_store_n(&slot->reading, 0, __ATOMIC_RELEASE);
+        return true;
+    }
+    PROFILE_BEGIN(pred_start);
+    predicate_stats_t *st = &stats[rule];
+    if (stats_reset_pending) {
+        for (uint32_t r = 0; r < NUM_TRIGGER_RULES; r++) {
+            stats[r].evals = stats[r].passes = stats[r].steps_max = stats[r].steps_total = 0;
+        }
+        stats_reset_pending = false;
+    }
+
+    uint32_t acc = 0;
+    bool clause_ok = true;
+    bool result = false;
+    uint32_t pc = 0;
+    uint32_t steps = 0;
+    while (pc < p->count) {
+        const predicate_insn_t *in = &p->code[pc++];
+        steps++;
+        if (!clause_ok && in->op != PRED_OP_OR) {
+            continue; // failed clause: skip to the next alternative
+        }
+        int32_t imm = (in->a & PRED_IMM_SIGNED) ? (int32_t)(int16_t)in->imm : (int32_t)in->imm;
+        int32_t sacc = (int32_t)acc;
+        switch (in->op) {
+        case PRED_OP_LDB:  clause_ok = load(frame, in->a, 1, &acc, false); break;
+        case PRED_OP_LDW:  clause_ok = load(frame, in->a, 2, &acc, false); break;
+        case PRED_OP_LDWL: clause_ok = load(frame, in->a, 2, &acc, true); break;
+        case PRED_OP_AND:  acc &= in->imm; break;
+        case PRED_OP_SHR:  acc >>= in->a; break;
+        case PRED_OP_SEXT: {
+            uint32_t sign = 1u << (in->a - 1u);
+            acc = (acc & ((sign << 1) - 1u));
+            acc = (acc ^ sign) - sign;
+            break;
+        }
+        case PRED_OP_EQ:   clause_ok = sacc == imm; break;
+        case PRED_OP_NE:   clause_ok = sacc != imm; break;
+        case PRED_OP_LT:   clause_ok = sacc < imm; break;
+        case PRED_OP_LE:   clause_ok = sacc <= imm; break;
+        case PRED_OP_GT:   clause_ok = sacc > imm; break;
+        case PRED_OP_GE:   clause_ok = sacc >= imm; break;
+        case PRED_OP_RISE:
+            clause_ok = slot->have_prev && slot->prev < imm && sacc >= imm;
+            slot->prev = sacc;
+            slot->have_prev = true;
+            break;
+        case PRED_OP_FALL:
+            clause_ok = slot->have_prev && slot->prev >= imm && sacc < imm;
+            slot->prev = sacc;
+            slot->have_prev = true;
+            break;
+        case PRED_OP_OR:
+            if (clause_ok) {
+                result = true;
+                pc = p->count;
+            }
+            clause_ok = true;
+            break;
+        default:
+            clause_ok = false;
+            break;
+        }
+    }
+    result = result || clause_ok;
+
+    st->evals++;
+    st->passes += result ? 1u : 0u;
+    st->steps_total += steps;
+    if (steps > st->steps_max) st->steps_max = steps;
+    __atomic_store_n(&slot->reading, 0, __ATOMIC_RELEASE);
+    PROFILE_END(PROFILE_PREDICATE_EVAL, pred_start);
+    return result;
+}
+
+uint16_t predicate_read_stats(uint8_t *out, uint16_t cap)
+{
+    uint16_t w = 0;
+    for (uint32_t i = 0; i < NUM_TRIGGER_RULES && (uint32_t)w + sizeof(predicate_stats_t) <= cap; i++) {
+        predicate_stats_t s = stats[i];
+        s.rule = (uint8_t)i;
+        memcpy(&out[w], &s, sizeof(s));
+        w = (uint16_t)(w + sizeof(s));
+    }
+    return w;
+}
+
+void predicate_reset_stats(void)
+{
+    stats_reset_pending = true;
+}
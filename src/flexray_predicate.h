@@ -0,0 +1,82 @@
+#ifndef FLEXRAY_PREDICATE_H
+#define FLEXRAY_PREDICATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Content predicates on injection triggers. A rule with a predicate only
+// fires when its trigger frame's payload satisfies it. Programs are compiled
+// on the host (flexray_predicate.py), uploaded with op 0x9B and evaluated by
+// try_inject_frame in the streamer ISR straight from the DMA ring.
+//
+// A program is up to PREDICATE_MAX_INSNS 4-byte instructions [op][a][u16 imm]
+// run on one accumulator. Compares are clauses ANDed together; OP_OR starts
+// the next alternative, so a program is a sum of products. A failed compare
+// skips to the next OP_OR; reaching OP_OR or the end with every compare true
+// passes. Loads only see the first PREDICATE_WINDOW_BYTES payload bytes; a
+// load beyond the window or the frame fails its clause. There are no
+// backward jumps, so cost is at most PREDICATE_MAX_INSNS steps.
+//
+// Crossing compares (RISE/FALL) keep one previous value per program, which is
+// only updated when they run: put them first in their clause.
+
+#define PREDICATE_MAX_INSNS    15u // one op 0x9B fits a 64-byte bulk packet
+#define PREDICATE_LOAD_BUSY    0xFF // predicate_load: retry later
+#define PREDICATE_WINDOW_BYTES 32u
+
+typedef enum {
+    PRED_OP_LDB  = 0x01, // acc = p[a]
+    PRED_OP_LDW  = 0x02, // acc = p[a] << 8 | p[a+1]   (big-endian)
+    PRED_OP_LDWL = 0x03, // acc = p[a] | p[a+1] << 8   (little-endian)
+    PRED_OP_AND  = 0x04, // acc &= imm
+    PRED_OP_SHR  = 0x05, // acc >>= a
+    PRED_OP_SEXT = 0x06, // sign-extend acc from a bits
+    PRED_OP_EQ   = 0x10, // compares: acc ? imm, imm sign-extended if a & PRED_IMM_SIGNED
+    PRED_OP_NE   = 0x11,
+    PRED_OP_LT   = 0x12,
+    PRED_OP_LE   = 0x13,
+    PRED_OP_GT   = 0x14,
+    PRED_OP_GE   = 0x15,
+    PRED_OP_RISE = 0x18, // previous < imm <= acc
+    PRED_OP_FALL = 0x19, // previous >= imm > acc
+    PRED_OP_OR   = 0x1F,
+} predicate_op_t;
+
+#define PRED_IMM_SIGNED 0x01
+
+typedef struct __attribute__((packed)) {
+    uint8_t op;
+    uint8_t a;
+    uint16_t imm;
+} predicate_insn_t;
+
+// Trigger frame in the streamer's DMA ring
+typedef struct {
+    const volatile uint8_t *ring;
+    uint32_t start;           // index of header byte 0
+    uint32_t mask;
+    uint8_t payload_bytes;
+} predicate_frame_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t rule;
+    uint8_t insns;            // program length, 0 = no predicate
+    uint16_t reserved;
+    uint32_t evals;
+    uint32_t passes;
+    uint32_t steps_max;       // instructions executed, worst case seen
+    uint32_t steps_total;
+} predicate_stats_t;
+
+// Core0 (USB). Returns -1 when accepted, else the index of the first bad
+// instruction (or PREDICATE_MAX_INSNS if the program is too long, or
+// PREDICATE_LOAD_BUSY if core1 has not picked up the previous load yet).
+int predicate_load(uint8_t rule, const uint8_t *insns, uint8_t count);
+
+// Core1, from try_inject_frame. True if the rule has no predicate.
+bool predicate_eval(uint8_t rule, const predicate_frame_t *frame);
+
+uint16_t predicate_read_stats(uint8_t *out, uint16_t cap);
+void predicate_reset_stats(void);
+
+#endif // FLEXRAY_PREDICATE_H
@@ -0,0 +1,42 @@
+#include "flexray_profile.h"
+
+#if FLEXRAY_PROFILE
+
+#include <limits.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+
+#if !PICO_RP2350 || PICO_RISCV
+#error "FLEXRAY_PROFILE needs the Cortex-M33 DWT cycle counter (RP2350, Arm build)"
+#endif
+
+profile_stats_block_t profile_stats;
+
+void profile_init_core(void)
+{
+    m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+    m33_hw->dwt_cyccnt = 0;
+    m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+}
+
+void profile_reset(void)
+{
+    memset(&profile_stats, 0, sizeof(profile_stats));
+    profile_stats.version = PROFILE_STATS_VERSION;
+    profile_stats.probe_count = PROFILE_PROBE_COUNT;
+    profile_stats.hist_buckets = PROFILE_HIST_BUCKETS;
+    profile_stats.sys_clk_hz = clock_get_hz(clk_sys);
+    for (int i = 0; i < PROFILE_PROBE_COUNT; i++) {
+        profile_stats.probes[i].min_cycles = UINT32_MAX;
+    }
+    __dmb();
+}
+
+void profile_snapshot(profile_stats_block_t *out)
+{
+    memcpy(out, &profile_stats, sizeof(*out));
+}
+
+#endif // FLEXRAY_PROFILE
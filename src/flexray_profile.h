@@ -0,0 +1,87 @@
+#ifndef FLEXRAY_PROFILE_H
+#define FLEXRAY_PROFILE_H
+
+#include <stdint.h>
+
+// Cycle-accurate hot-path profiling based on the Cortex-M33 DWT cycle counter.
+// Enabled with -DFLEXRAY_PROFILE=ON at configure time; when disabled every
+// PROFILE_* macro expands to nothing and no stats block is linked in.
+
+typedef enum {
+    PROFILE_STREAMER_ISR = 0,    // streamer_irq0_handler (core1)
+    PROFILE_TRY_INJECT_FRAME,    // try_inject_frame (core1, inside the ISR)
+    PROFILE_PARSE_LOOP,          // one notification in the main.c parse loop (core0)
+    PROFILE_IS_VALID_FRAME,      // is_valid_frame (core0)
+    PROFILE_TRY_SEND_FROM_FIFO,  // try_send_from_fifo (core0)
+    PROFILE_STREAM_CODEC_ENCODE, // stream_codec_encode, per frame (core0)
+    PROFILE_PREDICATE_EVAL,      // predicate_eval, rules with a program (core1, inside try_inject_frame)
+    PROFILE_PROBE_COUNT
+} profile_probe_t;
+
+#define PROFILE_STATS_VERSION 1
+// Bucket i counts samples with floor(log2(cycles)) == i; the last bucket also
+// takes everything above it.
+#define PROFILE_HIST_BUCKETS 24
+
+// Layout is shared with flexray_profile_reader.py (little-endian, no padding).
+typedef struct {
+    uint64_t total_cycles;
+    uint32_t count;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint32_t reserved;
+    uint32_t hist[PROFILE_HIST_BUCKETS];
+} profile_probe_stats_t;
+
+typedef struct {
+    uint8_t version;
+    uint8_t probe_count;
+    uint8_t hist_buckets;
+    uint8_t reserved;
+    uint32_t sys_clk_hz;
+    profile_probe_stats_t probes[PROFILE_PROBE_COUNT];
+} profile_stats_block_t;
+
+#if FLEXRAY_PROFILE
+
+#include "hardware/structs/m33.h"
+
+// Each probe is only ever written from one core, so updates need no locking.
+// A reader on the other core may observe a probe mid-update; that is
+// acceptable for statistics and keeps the hot path to a handful of cycles.
+extern profile_stats_block_t profile_stats;
+
+// Must be called once on each core that records samples (DWT is per-core).
+void profile_init_core(void);
+void profile_reset(void);
+// Copy the live block into out for transfer to the host
+void profile_snapshot(profile_stats_block_t *out);
+
+static inline uint32_t profile_cycles_now(void)
+{
+    return m33_hw->dwt_cyccnt;
+}
+
+static inline void profile_record(profile_probe_t probe, uint32_t cycles)
+{
+    profile_probe_stats_t *p = &profile_stats.probes[probe];
+    p->count++;
+    p->total_cycles += cycles;
+    if (cycles < p->min_cycles) p->min_cycles = cycles;
+    if (cycles > p->max_cycles) p->max_cycles = cycles;
+    uint32_t bucket = cycles ? (31u - (uint32_t)__builtin_clz(cycles)) : 0u;
+    if (bucket >= PROFILE_HIST_BUCKETS) bucket = PROFILE_HIST_BUCKETS - 1;
+    p->hist[bucket]++;
+}
+
+#define PROFILE_BEGIN(var)      uint32_t var = profile_cycles_now()
+#define PROFILE_END(probe, var) profile_record((probe), profile_cycles_now() - (var))
+
+#else
+
+#define PROFILE_BEGIN(var)      do { } while (0)
+#define PROFILE_END(probe, var) do { } while (0)
+
+#endif // FLEXRAY_PROFILE
+
+#endif // FLEXRAY_PROFILE_H
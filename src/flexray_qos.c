@@ -0,0 +1,77 @@
+#include "flexray_qos.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "flexray_injector_rules.h"
+
+// Only BULK pays for the default reserve, and no ID is BULK until the host
+// says so: an unconfigured device may fill the whole FIFO as before.
+#define QOS_DEFAULT_RESERVE_NORMAL  64u
+#define QOS_DEFAULT_RESERVE_CONTROL 0u
+
+static uint8_t qos_class[FLEXRAY_MAX_FRAME_ID];
+static uint16_t reserve_normal = QOS_DEFAULT_RESERVE_NORMAL;
+static uint16_t reserve_control = QOS_DEFAULT_RESERVE_CONTROL;
+static qos_stats_t qos_stats;
+
+void qos_reset(void)
+{
+    memset(qos_class, QOS_CLASS_NORMAL, sizeof(qos_class));
+    for (uint32_t i = 0; i < NUM_TRIGGER_RULES; i++) {
+        qos_class[INJECT_TRIGGERS[i].trigger_id & 0x7FF] = QOS_CLASS_CONTROL;
+        qos_class[INJECT_TRIGGERS[i].target_id & 0x7FF] = QOS_CLASS_CONTROL;
+    }
+    reserve_normal = QOS_DEFAULT_RESERVE_NORMAL;
+    reserve_control = QOS_DEFAULT_RESERVE_CONTROL;
+    memset(&qos_stats, 0, sizeof(qos_stats));
+}
+
+bool qos_set_class(uint16_t frame_id, qos_class_t cls)
+{
+    if (frame_id >= FLEXRAY_MAX_FRAME_ID || cls >= QOS_CLASS_COUNT) {
+        return false;
+    }
+    qos_class[frame_id] = (uint8_t)cls;
+    return true;
+}
+
+qos_class_t qos_get_class(uint16_t frame_id)
+{
+    return frame_id < FLEXRAY_MAX_FRAME_ID ? (qos_class_t)qos_class[frame_id] : QOS_CLASS_NORMAL;
+}
+
+void qos_set_reserve(uint16_t normal, uint16_t control)
+{
+    reserve_normal = normal;
+    reserve_control = control;
+}
+
+uint32_t __not_in_flash_func(qos_fill_limit)(uint16_t frame_id, uint32_t fifo_capacity)
+{
+    uint32_t reserved;
+    switch (qos_class[frame_id & 0x7FF]) {
+    case QOS_CLASS_CONTROL:
+        return fifo_capacity;
+    case QOS_CLASS_NORMAL:
+        reserved = reserve_control;
+        break;
+    default:
+        reserved = (uint32_t)reserve_control + reserve_normal;
+        break;
+    }
+    return (reserved < fifo_capacity) ? fifo_capacity - reserved : 0;
+}
+
+void __not_in_flash_func(qos_account)(uint16_t frame_id, bool queued)
+{
+    uint8_t cls = qos_class[frame_id & 0x7FF];
+    if (queued) {
+        qos_stats.enqueued[cls]++;
+    } else {
+        qos_stats.dropped[cls]++;
+    }
+}
+
+void qos_get_stats(qos_stats_t *out)
+{
+    *out = qos_stats;
+}
@@ -0,0 +1,43 @@
+#ifndef FLEXRAY_QOS_H
+#define FLEXRAY_QOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flexray_filter.h"
+
+// Per-ID priority classes for the USB FIFO. All classes share one ring so
+// frame order is preserved, but capacity is reserved from the top: BULK may
+// only fill the FIFO up to (size - reserve_normal - reserve_control) and
+// NORMAL up to (size - reserve_control), so under pressure the device sheds
+// BULK first, then NORMAL, and CONTROL frames still find room.
+//
+// Defaults cost nothing: IDs start NORMAL and no slots are reserved for
+// CONTROL, so NORMAL and CONTROL may both fill the whole FIFO. Demoting
+// IDs to BULK sheds them first (64 slots kept back); CONTROL protection
+// needs a CONTROL reserve from the host.
+
+typedef enum {
+    QOS_CLASS_BULK = 0,
+    QOS_CLASS_NORMAL = 1,  // default for every ID
+    QOS_CLASS_CONTROL = 2, // injector trigger/target IDs by default
+    QOS_CLASS_COUNT
+} qos_class_t;
+
+typedef struct {
+    uint32_t enqueued[QOS_CLASS_COUNT];
+    uint32_t dropped[QOS_CLASS_COUNT];
+} qos_stats_t;
+
+// All IDs back to NORMAL, injector rule IDs to CONTROL, default reserves
+void qos_reset(void);
+bool qos_set_class(uint16_t frame_id, qos_class_t cls);
+qos_class_t qos_get_class(uint16_t frame_id);
+void qos_set_reserve(uint16_t reserve_normal, uint16_t reserve_control);
+
+// Highest FIFO occupancy at which a frame of frame_id may still be queued
+uint32_t qos_fill_limit(uint16_t frame_id, uint32_t fifo_capacity);
+void qos_account(uint16_t frame_id, bool queued);
+
+void qos_get_stats(qos_stats_t *out);
+
+#endif // FLEXRAY_QOS_H
@@ -0,0 +1,215 @@
+#include "flexray_schedule.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "flexray_filter.h"
+
+// Direct index frame_id -> entry; core0 only, no locking.
+
+#define SCHEDULE_NONE      0xFFFFu
+#define CYCLE_MASK_ALL     0xFFFFFFFFFFFFFFFFull
+
+typedef struct {
+    schedule_entry_t pub;
+    uint8_t seen_len;             // payload_words recorded at least once
+} schedule_slot_t;
+
+static uint16_t sched_index[FLEXRAY_MAX_FRAME_ID];
+static schedule_slot_t sched_entries[SCHEDULE_ENTRIES];
+static uint16_t sched_count = 0;
+
+static uint16_t anchor_id = SCHEDULE_NO_ANCHOR;
+static uint8_t anchor_source = 0;
+static bool anchor_valid = false;  // anchor_end_us/anchor_cycle hold the last anchor frame
+static uint32_t anchor_end_us = 0;
+static uint8_t anchor_cycle = 0;
+static uint32_t cycle_period_us = 0;
+static uint32_t cycles_seen = 0;
+
+static void reset_offsets(void)
+{
+    for (uint16_t i = 0; i < sched_count; i++) {
+        sched_entries[i].pub.flags = 0;
+        sched_entries[i].pub.samples = 0;
+    }
+    anchor_valid = false;
+    cycle_period_us = 0;
+    cycles_seen = 0;
+}
+
+void schedule_reset(void)
+{
+    memset(sched_index, 0xFF, sizeof(sched_index));
+    sched_count = 0;
+    anchor_id = SCHEDULE_NO_ANCHOR;
+    reset_offsets();
+}
+
+// Smallest power-of-two repetition that the mask is periodic in with one base
+static void derive_repetition(schedule_entry_t *e)
+{
+    for (uint8_t rep = 1; rep <= 64; rep = (uint8_t)(rep << 1)) {
+        uint64_t first = e->cycle_mask & ((rep == 64) ? CYCLE_MASK_ALL : ((1ull << rep) - 1u));
+        if (first == 0 || (first & (first - 1u)) != 0) {
+            continue; // no or several bases within one repetition
+        }
+        uint8_t base = (uint8_t)__builtin_ctzll(first);
+        uint64_t expected = 0;
+        for (uint32_t c = base; c < 64; c += rep) {
+            expected |= 1ull << c;
+        }
+        if (expected == e->cycle_mask) {
+            e->cycle_base = base;
+            e->cycle_rep = rep;
+            return;
+        }
+    }
+    e->cycle_base = 0;
+    e->cycle_rep = 0;
+}
+
+static void note_anchor(uint8_t cycle_count, uint32_t end_us)
+{
+    if (anchor_valid) {
+        uint32_t interval = end_us - anchor_end_us;
+        uint8_t cycles = (uint8_t)((cycle_count - anchor_cycle) & 0x3Fu);
+        if (cycles == 1) {
+            // 1/8 EMA: follows crystal drift, averages out ISR entry jitter
+            cycle_period_us = (cycle_period_us == 0) ? interval
+                : (uint32_t)((int32_t)cycle_period_us + ((int32_t)(interval - cycle_period_us) / 8));
+        }
+    }
+    anchor_valid = true;
+    anchor_end_us = end_us;
+    anchor_cycle = cycle_count;
+    cycles_seen++;
+}
+
+void __not_in_flash_func(schedule_update)(uint16_t frame_id, uint8_t cycle_count, uint8_t source,
+                                          uint8_t payload_words, bool timed, uint32_t end_us)
+{
+    frame_id &= 0x7FFu;
+    uint16_t idx = sched_index[frame_id];
+    if (idx == SCHEDULE_NONE) {
+        if (sched_count >= SCHEDULE_ENTRIES) {
+            return;
+        }
+        idx = sched_count++;
+        sched_index[frame_id] = idx;
+        memset(&sched_entries[idx], 0, sizeof(sched_entries[idx]));
+        sched_entries[idx].pub.frame_id = frame_id;
+    }
+    schedule_slot_t *slot = &sched_entries[idx];
+    schedule_entry_t *e = &slot->pub;
+
+    e->sources |= (source == 1) ? SCHEDULE_SOURCE_VEHICLE : SCHEDULE_SOURCE_ECU;
+    if (!slot->seen_len) {
+        e->payload_words = payload_words;
+        slot->seen_len = 1;
+    } else if (e->payload_words != payload_words) {
+        e->payload_words = SCHEDULE_LEN_VARIES;
+    }
+    uint64_t bit = 1ull << (cycle_count & 0x3Fu);
+    if (!(e->cycle_mask & bit)) {
+        e->cycle_mask |= bit;
+        derive_repetition(e);
+        if (e->cycle_mask == CYCLE_MASK_ALL && frame_id < anchor_id) {
+            // Lower every-cycle ID: re-anchor and relearn offsets
+            anchor_id = frame_id;
+            anchor_source = source;
+            reset_offsets();
+        }
+    }
+
+    if (!timed) {
+        return;
+    }
+    if (frame_id == anchor_id && source == anchor_source) {
+        note_anchor(cycle_count, end_us);
+        e->offset_min_us = 0;
+        e->offset_max_us = 0;
+        e->samples++;
+        e->flags |= SCHEDULE_FLAG_OFFSET | SCHEDULE_FLAG_STATIC;
+        return;
+    }
+    if (!anchor_valid || cycle_period_us == 0) {
+        return;
+    }
+    uint8_t cycles = (uint8_t)((cycle_count - anchor_cycle) & 0x3Fu);
+    if (cycles > 1) {
+        return; // anchor missed; no reference for this cycle
+    }
+    int32_t offset = (int32_t)(end_us - anchor_end_us - cycles * cycle_period_us);
+    if (!(e->flags & SCHEDULE_FLAG_OFFSET)) {
+        e->offset_min_us = offset;
+        e->offset_max_us = offset;
+        e->flags |= SCHEDULE_FLAG_OFFSET;
+    } else if (offset < e->offset_min_us) {
+        e->offset_min_us = offset;
+    } else if (offset > e->offset_max_us) {
+        e->offset_max_us = offset;
+    }
+    e->samples++;
+    bool stable = (e->offset_max_us - e->offset_min_us) <= SCHEDULE_STATIC_JITTER_US;
+    if (stable && e->samples >= SCHEDULE_MIN_SAMPLES) {
+        e->flags |= SCHEDULE_FLAG_STATIC;
+    } else {
+        e->flags &= (uint8_t)~SCHEDULE_FLAG_STATIC;
+    }
+}
+
+uint16_t schedule_read(uint16_t first, uint8_t *out, uint16_t cap)
+{
+    if (cap < sizeof(schedule_header_t)) {
+        return 0;
+    }
+    uint16_t count = 0;
+    uint16_t w = sizeof(schedule_header_t);
+    for (uint16_t i = first; i < sched_count && (uint32_t)w + sizeof(schedule_entry_t) <= cap; i++) {
+        memcpy(&out[w], &sched_entries[i].pub, sizeof(schedule_entry_t));
+        w = (uint16_t)(w + sizeof(schedule_entry_t));
+        count++;
+    }
+    schedule_header_t hdr = {
+        .total_entries = sched_count,
+        .first = first,
+        .count = count,
+        .entry_size = sizeof(schedule_entry_t),
+        .anchor_id = anchor_id,
+        .anchor_source = anchor_source,
+        .cycle_period_us = cycle_period_us,
+        .cycles_seen = cycles_seen,
+    };
+    memcpy(out, &hdr, sizeof(hdr));
+    return w;
+}
+
+uint16_t schedule_entry_count(void)
+{
+    return sched_count;
+}
+
+bool schedule_get(uint16_t index, schedule_entry_t *out)
+{
+    if (index >= sched_count) {
+        return false;
+    }
+    *out = sched_entries[index].pub;
+    return true;
+}
+
+bool schedule_lookup(uint16_t frame_id, schedule_entry_t *out)
+{
+    uint16_t idx = sched_index[frame_id & 0x7FFu];
+    if (idx == SCHEDULE_NONE) {
+        return false;
+    }
+    *out = sched_entries[idx].pub;
+    return true;
+}
+
+bool schedule_get_anchor(uint16_t *frame_id, uint8_t *source)
+{
+    *frame_id = anchor_id;
+    *source = anchor_source;
+    return anchor_id != SCHEDULE_NO_ANCHOR;
+}
@@ -0,0 +1,71 @@
+#ifndef FLEXRAY_SCHEDULE_H
+#define FLEXRAY_SCHEDULE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Static schedule learner. Watches frame IDs, cycle counts, directions and
+// frame-end times in the core0 parse loop and derives, per frame ID (= slot
+// number in the static segment): cycle base/repetition, payload length,
+// sending side and the time offset within the cycle.
+//
+// Offsets are measured from the end of an anchor frame: the lowest frame ID
+// seen in all 64 cycles. The anchor is picked automatically (and offsets are
+// relearned when a lower one qualifies); its interval is the cycle period.
+// An ID whose offset stays within SCHEDULE_STATIC_JITTER_US is flagged
+// static; anything else (dynamic segment, event-driven) is not.
+//
+// Read (FLEXRAY_READ_SCHEDULE, wValue = first entry index):
+//   schedule_header_t, count x schedule_entry_t
+
+#define SCHEDULE_ENTRIES          256u
+#define SCHEDULE_STATIC_JITTER_US 20
+#define SCHEDULE_MIN_SAMPLES      16u
+
+#define SCHEDULE_SOURCE_ECU      0x01
+#define SCHEDULE_SOURCE_VEHICLE  0x02
+#define SCHEDULE_LEN_VARIES      0xFF
+#define SCHEDULE_FLAG_STATIC     0x01
+#define SCHEDULE_FLAG_OFFSET     0x02 // offset_min/max hold samples
+#define SCHEDULE_NO_ANCHOR       0xFFFF
+
+typedef struct __attribute__((packed)) {
+    uint16_t total_entries;
+    uint16_t first;
+    uint16_t count;
+    uint8_t entry_size;
+    uint8_t reserved;
+    uint16_t anchor_id;           // SCHEDULE_NO_ANCHOR while still learning
+    uint8_t anchor_source;
+    uint8_t reserved2;
+    uint32_t cycle_period_us;     // averaged anchor interval, 0 while unknown
+    uint32_t cycles_seen;         // anchor occurrences
+} schedule_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t frame_id;
+    uint8_t sources;              // SCHEDULE_SOURCE_* seen sending it
+    uint8_t payload_words;        // SCHEDULE_LEN_VARIES if it changed
+    uint8_t cycle_base;
+    uint8_t cycle_rep;            // 1..64, 0 = not a single base/repetition (see cycle_mask)
+    uint8_t flags;                // SCHEDULE_FLAG_*
+    uint8_t reserved;
+    int32_t offset_min_us;        // frame end - anchor end, same cycle
+    int32_t offset_max_us;
+    uint32_t samples;             // timed occurrences behind the offsets
+    uint64_t cycle_mask;
+} schedule_entry_t;
+
+void schedule_reset(void);
+void schedule_update(uint16_t frame_id, uint8_t cycle_count, uint8_t source, uint8_t payload_words,
+                     bool timed, uint32_t end_us);
+uint16_t schedule_read(uint16_t first, uint8_t *out, uint16_t cap);
+
+// Core0 accessors for other learners (trigger tuner)
+uint16_t schedule_entry_count(void);
+bool schedule_get(uint16_t index, schedule_entry_t *out);
+bool schedule_lookup(uint16_t frame_id, schedule_entry_t *out);
+// False while no anchor has been chosen
+bool schedule_get_anchor(uint16_t *frame_id, uint8_t *source);
+
+#endif // FLEXRAY_SCHEDULE_H
@@ -0,0 +1,152 @@
+#include "flexray_signals.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "hardware/timer.h"
+#include "flexray_injector_rules.h"
+
+typedef struct {
+    signal_desc_t desc[SIGNALS_MAX];
+    uint32_t value[SIGNALS_MAX];
+    uint32_t active;              // bit per signal
+    uint32_t updated_us;          // last commit, for the hold time
+    uint16_t hold_ms;
+} signals_bank_t;
+
+// Core0 edits `staged` and publishes it into `shared` under a sequence
+// count. Core1 copies `shared` into the spare `snap` only when the count
+// moved and was stable across the copy; otherwise it keeps packing the last
+// consistent snapshot, so one 0x9E op never lands half-applied.
+static signals_bank_t staged;
+static signals_bank_t shared;
+static volatile uint32_t shared_seq = 0;
+
+static signals_bank_t snap[2];    // core1 only
+static uint8_t snap_idx = 0;
+static uint32_t snap_seq = 0;
+
+static uint8_t loaded = 0;        // core0: highest loaded id + 1
+static uint32_t pairs = 0;
+static uint32_t rejected = 0;
+static volatile uint32_t injections = 0; // core1 writes
+
+bool signals_load_descriptors(uint8_t first, uint8_t n, const uint8_t *descs, uint16_t hold_ms)
+{
+    if ((uint32_t)first + n > SIGNALS_MAX) {
+        return false;
+    }
+    signal_desc_t d[SIGNALS_MAX];
+    memcpy(d, descs, (size_t)n * sizeof(signal_desc_t));
+    for (uint8_t i = 0; i < n; i++) {
+        if (d[i].field.bits != 0 && (d[i].rule >= NUM_TRIGGER_RULES || !gateway_field_valid(&d[i].field))) {
+            return false;
+        }
+    }
+    for (uint8_t i = 0; i < n; i++) {
+        staged.desc[first + i] = d[i];
+        staged.active &= ~(1u << (first + i));
+        if (d[i].field.bits != 0 && first + i + 1u > loaded) {
+            loaded = (uint8_t)(first + i + 1u);
+        }
+    }
+    staged.hold_ms = hold_ms;
+    signals_commit();
+    return true;
+}
+
+bool signals_set(uint8_t signal_id, uint32_t raw_value)
+{
+    uint8_t id = signal_id & (uint8_t)~SIGNAL_RELEASE;
+    if (id >= SIGNALS_MAX || staged.desc[id].field.bits == 0) {
+        rejected++;
+        return false;
+    }
+    pairs++;
+    if (signal_id & SIGNAL_RELEASE) {
+        staged.active &= ~(1u << id);
+    } else {
+        staged.value[id] = raw_value;
+        staged.active |= 1u << id;
+    }
+    return true;
+}
+
+void signals_commit(void)
+{
+    staged.updated_us = time_us_32();
+    uint32_t seq = shared_seq;
+    __atomic_store_n(&shared_seq, seq + 1u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    shared = staged;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&shared_seq, seq + 2u, __ATOMIC_RELAXED);
+}
+
+static const signals_bank_t *__time_critical_func(current)(void)
+{
+    uint32_t s1 = __atomic_load_n(&shared_seq, __ATOMIC_ACQUIRE);
+    if (s1 != snap_seq && !(s1 & 1u)) {
+        signals_bank_t *spare = &snap[snap_idx ^ 1u];
+        *spare = shared;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shared_seq, __ATOMIC_RELAXED) == s1) {
+            snap_idx ^= 1u;
+            snap_seq = s1;
+        }
+    }
+    return &snap[snap_idx];
+}
+
+bool __time_critical_func(signals_apply)(uint8_t rule, uint8_t *payload, uint16_t payload_len)
+{
+    if (shared_seq == 0) {
+        return false; // nothing ever loaded
+    }
+    const signals_bank_t *b = current();
+    if (b->active == 0 ||
+        (b->hold_ms && (uint32_t)(time_us_32() - b->updated_us) > (uint32_t)b->hold_ms * 1000u)) {
+        return false;
+    }
+    bool wrote = false;
+    for (uint32_t mask = b->active, i = 0; mask; i++, mask >>= 1) {
+        if ((mask & 1u) && b->desc[i].rule == rule &&
+            gateway_field_store(&b->desc[i].field, payload, payload_len, b->value[i])) {
+            wrote = true;
+        }
+    }
+    if (wrote) {
+        injections++;
+    }
+    return wrote;
+}
+
+uint16_t signals_read(uint8_t *out, uint16_t cap)
+{
+    if (cap < sizeof(signals_header_t)) {
+        return 0;
+    }
+    bool expired = staged.hold_ms &&
+                   (uint32_t)(time_us_32() - staged.updated_us) > (uint32_t)staged.hold_ms * 1000u;
+    uint16_t w = sizeof(signals_header_t);
+    uint8_t count = 0;
+    for (uint32_t i = 0; i < loaded && (uint32_t)w + sizeof(signal_state_t) <= cap; i++) {
+        signal_state_t st = {
+            .signal_id = (uint8_t)i,
+            .rule = staged.desc[i].rule,
+            .active = (uint8_t)(!expired && ((staged.active >> i) & 1u)),
+            .raw_value = staged.value[i],
+        };
+        memcpy(&out[w], &st, sizeof(st));
+        w = (uint16_t)(w + sizeof(st));
+        count++;
+    }
+    signals_header_t hdr = {
+        .count = count,
+        .entry_size = sizeof(signal_state_t),
+        .hold_ms = staged.hold_ms,
+        .pairs = pairs,
+        .rejected = rejected,
+        .injections = injections,
+    };
+    memcpy(out, &hdr, sizeof(hdr));
+    return w;
+}
@@ -0,0 +1,61 @@
+#ifndef FLEXRAY_SIGNALS_H
+#define FLEXRAY_SIGNALS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flexray_gateway.h"
+
+// Signal-level overrides. flexray_dbc_signals.py compiles DBC signals into
+// bit-field descriptors (op 0x9D); the host then sends (signal_id, raw value)
+// pairs (op 0x9E) and fire_rule packs every active signal of a rule into its
+// template at injection time, before the E2E and frame CRC refresh. The host
+// never packs bytes or computes a CRC, and values are kept: only changes
+// need to be sent.
+//
+// A rule with active signals injects on every trigger, like a host that
+// resends the same slice each cycle. Signals stay active until released or,
+// with a hold time, until no 0x9E op arrived for that long (an empty 0x9E op
+// is a keepalive). Order in fire_rule: host slice, signals, gateway routes.
+// Signals do not apply to timed rules.
+//
+// Read (FLEXRAY_READ_SIGNALS): signals_header_t, then signal_state_t per
+// loaded descriptor.
+
+#define SIGNALS_MAX 32u
+#define SIGNAL_RELEASE 0x80       // in a 0x9E pair: stop overriding this signal
+
+typedef struct __attribute__((packed)) {
+    uint8_t rule;                 // injection rule whose target carries the signal
+    gateway_field_t field;        // bits 0 = unused descriptor
+} signal_desc_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t count;                // descriptors loaded
+    uint8_t entry_size;
+    uint16_t hold_ms;             // 0 = signals stay active until released
+    uint32_t pairs;               // values received
+    uint32_t rejected;            // pairs for unknown signals
+    uint32_t injections;          // frames injected because of signals
+} signals_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t signal_id;
+    uint8_t rule;
+    uint8_t active;
+    uint8_t reserved;
+    uint32_t raw_value;
+} signal_state_t;
+
+// Core0 (USB). load_descriptors replaces ids [first, first + n) and
+// releases them; false (nothing changed) if one is invalid.
+bool signals_load_descriptors(uint8_t first, uint8_t n, const uint8_t *descs, uint16_t hold_ms);
+// False if signal_id (without SIGNAL_RELEASE) has no descriptor.
+bool signals_set(uint8_t signal_id, uint32_t raw_value);
+void signals_commit(void);        // publish everything set since the last commit
+
+// Core1, from fire_rule. True if the rule has active signals (and they were written).
+bool signals_apply(uint8_t rule, uint8_t *payload, uint16_t payload_len);
+
+uint16_t signals_read(uint8_t *out, uint16_t cap);
+
+#endif // FLEXRAY_SIGNALS_H
@@ -0,0 +1,473 @@
+#include "flexray_splice.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "flexray_forwarder_with_injector.pio.h"
+#include "flexray_bss_streamer.h"
+#include "flexray_e2e.h"
+#include "flexray_frame.h"
+#include "flexray_injector_rules.h"
+
+#define SPLICE_BLOCK_WORDS 8u     // one frame byte: 16 instructions
+#define SPLICE_TRAILER_BYTES 3u
+#define SPLICE_TRAILER_WORDS (SPLICE_TRAILER_BYTES * SPLICE_BLOCK_WORDS + 1u)
+#define SPLICE_HEADER_BYTES 5u
+#define SPLICE_IDLE 0xFFu
+#define FLEXRAY_CRC24_POLY 0x5D6DCBu
+
+// One frame byte is 16 instructions, 100 cycles. Each costs 3 + delay
+// cycles (out exec, the instruction, jmp splice_loop). E is the cycle the
+// BSS falling edge is seen; output runs half a bit behind the input, so a
+// bit is sampled in the middle of the input bit while it is driven.
+//   0  wait 0 pin 0 [2]                       E
+//   1  set pins, 0 [4]   BSS low              E+5
+//   2  nop
+//   3  bit 7 [7]                              E+15
+//   4  bit 6 [4], 5 nop                       E+25
+//   6  bit 5 [7]                              E+35
+//   7  bit 4 [4], 8 nop                       E+45
+//   9  bit 3 [7], 10 bit 2 [4], 11 nop        E+55, E+65
+//   12 bit 1 [7], 13 bit 0 [4]                E+75, E+85
+//   14 nop, or irq after the window           E+92
+//   15 set pins, 1       next BSS high        E+95, then the wait from E+98
+// The frame's last byte drives the FES low bit in slot 15 ([4]) and one more
+// word jumps to accept_fes, which follows the input again from E+105.
+// Slots 1-6 and 7-13 share a layout, so a nibble is always 3 plan words.
+enum { NIBBLE_DRIVE = 0, NIBBLE_PASS = 1 };
+
+typedef struct {
+    uint8_t payload_len;          // 0 = no layout
+    uint8_t offset;
+    uint8_t len;
+    uint32_t contrib[SPLICE_MAX_BYTES][32]; // CRC delta of (driven ^ live), per low/high nibble
+} splice_layout_t;
+
+// Double-buffered per rule with flexray_e2e.c's reload guard; built on
+// core0. A layout stays in use from splice_begin until the frame ends
+// (`reading`), so core0 refuses a rebuild while core1 may still hold the
+// copy it would overwrite.
+typedef struct {
+    splice_layout_t l[2];
+    volatile uint32_t gen;        // core0, active copy gen & 1
+    volatile uint32_t seen;       // core1: last gen it pinned
+    volatile uint8_t reading;     // core1: a layout is pinned
+    volatile uint8_t enabled;
+} splice_slot_t;
+
+// Core1
+typedef struct {
+    const splice_layout_t *layout; // pinned by splice_begin
+    uint8_t prev[SPLICE_MAX_BYTES];   // window before the template was edited: last cycle's bytes
+    uint8_t driven[SPLICE_MAX_BYTES];
+    uint32_t delta;                   // trailer mask in the plan
+    uint32_t window[SPLICE_MAX_BYTES * SPLICE_BLOCK_WORDS];
+    uint32_t trailer[SPLICE_TRAILER_WORDS];
+    uint32_t blocks[5][4];            // control blocks: data channel al1 registers
+    volatile uint32_t splices;
+    volatile uint32_t corrected;
+    volatile uint32_t late;
+    volatile uint32_t aborted;
+    volatile uint32_t unready;
+} splice_plan_t;
+
+typedef struct {
+    uint sm;
+    int data_chan;
+    int ctrl_chan;
+    uint32_t ctrl_ring;           // data channel CTRL replaying the copy block
+    uint32_t ctrl_linear;
+    volatile uint8_t rule;        // splice planned for the next frame, SPLICE_IDLE if none
+} splice_dir_t;
+
+static splice_slot_t slots[NUM_TRIGGER_RULES];
+static splice_plan_t plans[NUM_TRIGGER_RULES];
+static splice_dir_t dirs[2] = {   // INJECT_DIRECTION_*
+    { .data_chan = -1, .ctrl_chan = -1, .rule = SPLICE_IDLE },
+    { .data_chan = -1, .ctrl_chan = -1, .rule = SPLICE_IDLE },
+};
+
+// Core0 configuration
+static uint8_t cfg_offset[NUM_TRIGGER_RULES];
+static uint8_t cfg_len[NUM_TRIGGER_RULES];
+static uint16_t seen_len[NUM_TRIGGER_RULES];
+
+static PIO splice_pio;
+static uint entry_pc;
+static uint loop_pc;
+static uint16_t insn_wait, insn_bss_low, insn_bss_high, insn_nop, insn_irq, insn_fes_low, insn_exit;
+static uint32_t nibble_words[2][16][3];
+static uint32_t copy_block[SPLICE_BLOCK_WORDS] __attribute__((aligned(32)));
+
+static uint32_t crc24_zero_byte(uint32_t c)
+{
+    for (int b = 0; b < 8; b++) {
+        c = (c & 0x800000u) ? (c << 1) ^ FLEXRAY_CRC24_POLY : c << 1;
+    }
+    return c & 0xFFFFFFu;
+}
+
+// False if core1 may still hold the copy it would overwrite
+static bool build_layout(uint8_t rule, uint8_t offset, uint8_t len, uint16_t payload_len)
+{
+    splice_slot_t *slot = &slots[rule];
+    uint32_t gen = slot->gen;
+    if (__atomic_load_n(&slot->seen, __ATOMIC_SEQ_CST) != gen &&
+        __atomic_load_n(&slot->reading, __ATOMIC_SEQ_CST)) {
+        return false;
+    }
+    splice_layout_t *next = &slot->l[(gen + 1u) & 1u];
+    next->offset = offset;
+    next->len = len;
+    next->payload_len = 0;
+    if (payload_len != 0 && (uint32_t)next->offset + next->len + SPLICE_MIN_TAIL_BYTES <= payload_len) {
+        // A one bit in the last window byte, followed by the zero bytes up
+        // to the CRC; each earlier byte is one more zero byte away.
+        uint32_t basis[8];
+        uint32_t tail = (uint32_t)payload_len - next->offset - next->len;
+        for (uint32_t b = 0; b < 8; b++) {
+            basis[b] = crc24_zero_byte((1u << b) << 16);
+            for (uint32_t k = 0; k < tail; k++) {
+                basis[b] = crc24_zero_byte(basis[b]);
+            }
+        }
+        for (int i = next->len - 1; i >= 0; i--) {
+            for (uint32_t v = 0; v < 16; v++) {
+                uint32_t lo = 0, hi = 0;
+                for (uint32_t b = 0; b < 4; b++) {
+                    if ((v >> b) & 1u) {
+                        lo ^= basis[b];
+                        hi ^= basis[b + 4];
+                    }
+                }
+                next->contrib[i][v] = lo;
+                next->contrib[i][16 + v] = hi;
+            }
+            for (uint32_t b = 0; b < 8; b++) {
+                basis[b] = crc24_zero_byte(basis[b]);
+            }
+        }
+        next->payload_len = (uint8_t)payload_len;
+    }
+    __atomic_store_n(&slot->gen, gen + 1u, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+splice_config_result_t splice_configure(uint8_t rule, bool enabled, uint8_t offset, uint8_t len)
+{
+    if (rule >= NUM_TRIGGER_RULES) {
+        return SPLICE_CONFIG_INVALID;
+    }
+    if (!enabled) {
+        slots[rule].enabled = 0;
+        return SPLICE_CONFIG_OK;
+    }
+    if (len == 0) {
+        // Taken from the E2E configuration active now (op 0xA0)
+        const trigger_rule_t *r = &INJECT_TRIGGERS[rule];
+        uint32_t lo = r->replace_offset;
+        uint32_t hi = (uint32_t)r->replace_offset + r->replace_len;
+        uint32_t e2e_offset, e2e_len;
+        e2e_area(rule, &e2e_offset, &e2e_len);
+        if (e2e_len != 0) {
+            if (r->replace_len == 0 || e2e_offset < lo) {
+                lo = e2e_offset;
+            }
+            if (r->replace_len == 0 || e2e_offset + e2e_len > hi) {
+                hi = e2e_offset + e2e_len;
+            }
+        }
+        if (hi - lo > SPLICE_MAX_BYTES) {
+            return SPLICE_CONFIG_INVALID;
+        }
+        offset = (uint8_t)lo;
+        len = (uint8_t)(hi - lo);
+    }
+    if (len == 0 || len > SPLICE_MAX_BYTES ||
+        (uint32_t)offset + len + SPLICE_MIN_TAIL_BYTES > MAX_FRAME_PAYLOAD_BYTES) {
+        return SPLICE_CONFIG_INVALID;
+    }
+    if (!build_layout(rule, offset, len, seen_len[rule])) {
+        return SPLICE_CONFIG_BUSY;
+    }
+    cfg_offset[rule] = offset;
+    cfg_len[rule] = len;
+    __atomic_store_n(&slots[rule].enabled, (uint8_t)1, __ATOMIC_RELEASE);
+    return SPLICE_CONFIG_OK;
+}
+
+void splice_prepare(uint8_t rule, uint16_t payload_len)
+{
+    if (rule >= NUM_TRIGGER_RULES || seen_len[rule] == payload_len) {
+        return;
+    }
+    // Busy: the length stays unseen and the next capture tries again
+    if (slots[rule].enabled && !build_layout(rule, cfg_offset[rule], cfg_len[rule], payload_len)) {
+        return;
+    }
+    seen_len[rule] = payload_len;
+}
+
+uint16_t splice_read(uint8_t *out, uint16_t cap)
+{
+    uint16_t w = 0;
+    for (uint32_t i = 0; i < NUM_TRIGGER_RULES && (uint32_t)w + sizeof(splice_state_t) <= cap; i++) {
+        const splice_slot_t *slot = &slots[i];
+        const splice_plan_t *p = &plans[i];
+        splice_state_t st = {
+            .enabled = slot->enabled,
+            .offset = cfg_offset[i],
+            .len = cfg_len[i],
+            .payload_len = slot->l[slot->gen & 1u].payload_len,
+            .splices = p->splices,
+            .corrected = p->corrected,
+            .late = p->late,
+            .aborted = p->aborted,
+            .unready = p->unready,
+        };
+        memcpy(&out[w], &st, sizeof(st));
+        w = (uint16_t)(w + sizeof(st));
+    }
+    return w;
+}
+
+static inline void __time_critical_func(plan_byte)(uint32_t *block, uint32_t kind, uint8_t v, uint16_t last)
+{
+    const uint32_t *hi = nibble_words[kind][v >> 4];
+    const uint32_t *lo = nibble_words[kind][v & 0x0Fu];
+    block[0] = ((uint32_t)insn_wait << 16) | insn_bss_low;
+    block[1] = hi[0];
+    block[2] = hi[1];
+    block[3] = hi[2];
+    block[4] = lo[0];
+    block[5] = lo[1];
+    block[6] = lo[2];
+    block[7] = ((uint32_t)insn_nop << 16) | last;
+}
+
+// Trailer bits pass through, inverted where the delta has a one
+static void __time_critical_func(plan_trailer)(splice_plan_t *p, uint32_t delta)
+{
+    for (uint32_t b = 0; b < SPLICE_TRAILER_BYTES; b++) {
+        uint16_t last = b == SPLICE_TRAILER_BYTES - 1u ? insn_fes_low : insn_bss_high;
+        plan_byte(&p->trailer[b * SPLICE_BLOCK_WORDS], NIBBLE_PASS, (uint8_t)(delta >> (16u - 8u * b)), last);
+    }
+    p->trailer[SPLICE_TRAILER_WORDS - 1u] = ((uint32_t)insn_exit << 16) | insn_nop;
+}
+
+static inline void set_block(uint32_t *block, uint32_t ctrl, const void *read, uint32_t write, uint32_t words)
+{
+    block[0] = ctrl;
+    block[1] = (uint32_t)(uintptr_t)read;
+    block[2] = write;
+    block[3] = words;             // transfer_count_trig
+}
+
+bool __time_critical_func(splice_begin)(uint8_t rule, const uint8_t *payload, uint16_t payload_len)
+{
+    splice_slot_t *slot = &slots[rule];
+    splice_plan_t *p = &plans[rule];
+    const splice_dir_t *d = &dirs[INJECT_TRIGGERS[rule].direction];
+    bool enabled = slot->enabled;
+    if (d->rule == rule) {
+        // This rule's last frame is still on the air with its layout
+        if (enabled) {
+            p->unready++;
+        }
+        return false;
+    }
+    // Otherwise a layout still pinned belongs to a plan that was dropped
+    __atomic_store_n(&slot->reading, (uint8_t)1, __ATOMIC_SEQ_CST);
+    uint32_t gen = __atomic_load_n(&slot->gen, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&slot->seen, gen, __ATOMIC_RELEASE);
+    const splice_layout_t *l = &slot->l[gen & 1u];
+    if (!enabled || l->payload_len != payload_len || d->rule != SPLICE_IDLE || d->data_chan < 0) {
+        if (enabled) {
+            p->unready++;
+        }
+        __atomic_store_n(&slot->reading, (uint8_t)0, __ATOMIC_RELEASE);
+        return false;
+    }
+    p->layout = l;
+    memcpy(p->prev, payload + l->offset, l->len);
+    return true;
+}
+
+void __time_critical_func(splice_fire)(uint8_t rule, const uint8_t *frame)
+{
+    splice_plan_t *p = &plans[rule];
+    const splice_layout_t *l = p->layout;
+    splice_dir_t *d = &dirs[INJECT_TRIGGERS[rule].direction];
+    const uint8_t *window = frame + SPLICE_HEADER_BYTES + l->offset;
+
+    // Delta planned as if the live window still held last cycle's bytes
+    uint32_t delta = 0;
+    for (uint32_t i = 0; i < l->len; i++) {
+        uint8_t v = window[i];
+        uint8_t diff = (uint8_t)(v ^ p->prev[i]);
+        p->driven[i] = v;
+        delta ^= l->contrib[i][diff & 0x0Fu] ^ l->contrib[i][16u + (diff >> 4)];
+        plan_byte(&p->window[i * SPLICE_BLOCK_WORDS], NIBBLE_DRIVE, v, insn_bss_high);
+    }
+    p->window[(l->len - 1u) * SPLICE_BLOCK_WORDS + 7u] = ((uint32_t)insn_irq << 16) | insn_bss_high;
+    p->delta = delta;
+    plan_trailer(p, delta);
+
+    uint32_t txf = (uint32_t)(uintptr_t)&splice_pio->txf[d->sm];
+    uint32_t before = SPLICE_HEADER_BYTES + l->offset;
+    uint32_t after = (uint32_t)l->payload_len - l->offset - l->len;
+    set_block(p->blocks[0], d->ctrl_ring, copy_block, txf, before * SPLICE_BLOCK_WORDS);
+    set_block(p->blocks[1], d->ctrl_linear, p->window, txf, l->len * SPLICE_BLOCK_WORDS);
+    set_block(p->blocks[2], d->ctrl_ring, copy_block, txf, after * SPLICE_BLOCK_WORDS);
+    set_block(p->blocks[3], d->ctrl_linear, p->trailer, txf, SPLICE_TRAILER_WORDS);
+    memset(p->blocks[4], 0, sizeof(p->blocks[4])); // null trigger ends the chain
+
+    d->rule = rule;
+    p->splices++;
+    pio_sm_put(splice_pio, d->sm, 0); // count 0: splice plan
+    dma_channel_set_read_addr((uint)d->ctrl_chan, p->blocks, true);
+}
+
+static void __time_critical_func(correct_trailer)(splice_dir_t *d, splice_plan_t *p, bool is_vehicle)
+{
+    const splice_layout_t *l = p->layout;
+    volatile uint8_t *ring = is_vehicle ? vehicle_ring_buffer : ecu_ring_buffer;
+    uint32_t mask = is_vehicle ? VEH_RING_MASK : ECU_RING_MASK;
+    uint32_t first = streamer_frame_start_idx(is_vehicle) + SPLICE_HEADER_BYTES + l->offset;
+    // The streamer's DMA may still be storing the window's last byte
+    for (uint32_t spin = 0; spin < 64u && ((streamer_write_idx(is_vehicle) - first) & mask) < l->len; spin++) {
+    }
+    uint32_t delta = 0;
+    for (uint32_t i = 0; i < l->len; i++) {
+        uint8_t diff = (uint8_t)(ring[(first + i) & mask] ^ p->driven[i]);
+        delta ^= l->contrib[i][diff & 0x0Fu] ^ l->contrib[i][16u + (diff >> 4)];
+    }
+    if (delta == p->delta) {
+        return;
+    }
+    plan_trailer(p, delta);
+    p->delta = delta;
+    p->corrected++;
+    __dmb();
+    uint32_t read = dma_channel_hw_addr((uint)d->data_chan)->read_addr - (uint32_t)(uintptr_t)p->trailer;
+    if (read != 0 && read <= sizeof(p->trailer)) {
+        p->late++;
+    }
+}
+
+static void __time_critical_func(splice_irq_handler)(void)
+{
+    for (uint32_t i = 0; i < 2; i++) {
+        splice_dir_t *d = &dirs[i];
+        // irq 0 rel: flag number = SM number
+        if (d->data_chan < 0 || !pio_interrupt_get(splice_pio, d->sm)) {
+            continue;
+        }
+        pio_interrupt_clear(splice_pio, d->sm);
+        uint8_t rule = d->rule;
+        if (rule != SPLICE_IDLE) {
+            correct_trailer(d, &plans[rule], i == INJECT_DIRECTION_TO_ECU);
+        }
+    }
+}
+
+void __time_critical_func(splice_frame_end)(bool is_vehicle)
+{
+    // The forwarder to the ECU repeats the vehicle's frames and vice versa
+    splice_dir_t *d = &dirs[is_vehicle ? INJECT_DIRECTION_TO_ECU : INJECT_DIRECTION_TO_VEHICLE];
+    uint8_t rule = d->rule;
+    if (rule == SPLICE_IDLE) {
+        return;
+    }
+    uint pc = pio_sm_get_pc(splice_pio, d->sm);
+    if (dma_channel_is_busy((uint)d->data_chan) || dma_channel_is_busy((uint)d->ctrl_chan) ||
+        pc == loop_pc || pc == loop_pc + 1u) {
+        // Frame shorter than the plan: the SM waits for a BSS that never comes
+        dma_channel_abort((uint)d->ctrl_chan);
+        dma_channel_abort((uint)d->data_chan);
+        pio_sm_set_enabled(splice_pio, d->sm, false);
+        pio_sm_clear_fifos(splice_pio, d->sm);
+        pio_sm_restart(splice_pio, d->sm);
+        pio_sm_exec(splice_pio, d->sm, pio_encode_jmp(entry_pc));
+        pio_sm_set_enabled(splice_pio, d->sm, true);
+        plans[rule].aborted++;
+    }
+    d->rule = SPLICE_IDLE;
+    __atomic_store_n(&slots[rule].reading, (uint8_t)0, __ATOMIC_RELEASE);
+}
+
+static void build_instructions(uint program_offset)
+{
+    insn_wait = (uint16_t)(pio_encode_wait_pin(false, 0) | pio_encode_delay(2));
+    insn_bss_low = (uint16_t)(pio_encode_set(pio_pins, 0) | pio_encode_delay(4));
+    insn_bss_high = (uint16_t)pio_encode_set(pio_pins, 1);
+    insn_nop = (uint16_t)pio_encode_nop();
+    insn_irq = (uint16_t)pio_encode_irq_set(true, 0);
+    insn_fes_low = (uint16_t)(pio_encode_set(pio_pins, 0) | pio_encode_delay(4));
+    insn_exit = (uint16_t)pio_encode_jmp(program_offset + flexray_forwarder_with_injector_offset_accept_fes);
+
+    for (uint32_t v = 0; v < 16; v++) {
+        uint16_t bit[2][4];
+        for (uint32_t k = 0; k < 4; k++) {
+            uint32_t one = (v >> (3u - k)) & 1u;
+            uint32_t delay = (k & 1u) ? 4u : 7u;
+            bit[NIBBLE_DRIVE][k] = (uint16_t)(pio_encode_set(pio_pins, one) | pio_encode_delay(delay));
+            bit[NIBBLE_PASS][k] = (uint16_t)((one ? pio_encode_mov_not(pio_pins, pio_pins)
+                                                  : pio_encode_mov(pio_pins, pio_pins)) | pio_encode_delay(delay));
+        }
+        for (uint32_t kind = 0; kind < 2; kind++) {
+            nibble_words[kind][v][0] = ((uint32_t)insn_nop << 16) | bit[kind][0];
+            nibble_words[kind][v][1] = ((uint32_t)bit[kind][1] << 16) | insn_nop;
+            nibble_words[kind][v][2] = ((uint32_t)bit[kind][2] << 16) | bit[kind][3];
+        }
+    }
+    plan_byte(copy_block, NIBBLE_PASS, 0, insn_bss_high);
+}
+
+void splice_setup(PIO pio, uint sm_to_vehicle, uint sm_to_ecu, uint program_offset)
+{
+    splice_pio = pio;
+    entry_pc = program_offset + flexray_forwarder_with_injector_offset_entry_point;
+    loop_pc = program_offset + flexray_forwarder_with_injector_offset_splice_loop;
+    build_instructions(program_offset);
+    dirs[INJECT_DIRECTION_TO_VEHICLE].sm = sm_to_vehicle;
+    dirs[INJECT_DIRECTION_TO_ECU].sm = sm_to_ecu;
+
+    for (uint32_t i = 0; i < 2; i++) {
+        splice_dir_t *d = &dirs[i];
+        uint data = dma_claim_unused_channel(true);
+        uint ctrl = dma_claim_unused_channel(true);
+
+        dma_channel_config c = dma_channel_get_default_config(data);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, pio_get_dreq(pio, d->sm, true));
+        channel_config_set_chain_to(&c, ctrl);
+        d->ctrl_linear = channel_config_get_ctrl_value(&c);
+        channel_config_set_ring(&c, false, 5); // 32-byte copy block
+        d->ctrl_ring = channel_config_get_ctrl_value(&c);
+
+        // Each control block rewrites al1_ctrl..al1_transfer_count_trig
+        dma_channel_config cc = dma_channel_get_default_config(ctrl);
+        channel_config_set_transfer_data_size(&cc, DMA_SIZE_32);
+        channel_config_set_read_increment(&cc, true);
+        channel_config_set_write_increment(&cc, true);
+        channel_config_set_ring(&cc, true, 4);
+        dma_channel_configure(ctrl, &cc, &dma_channel_hw_addr(data)->al1_ctrl, NULL, 4, false);
+
+        pio_set_irq0_source_enabled(pio, (enum pio_interrupt_source)(pis_interrupt0 + d->sm), true);
+        d->ctrl_chan = (int)ctrl;
+        __atomic_store_n(&d->data_chan, (int)data, __ATOMIC_RELEASE);
+    }
+}
+
+void splice_irq_init(PIO pio)
+{
+    uint irq = pio_get_irq_num(pio, 0);
+    irq_set_exclusive_handler(irq, splice_irq_handler);
+    // Ahead of the streamer ISR: the trailer has a few microseconds
+    irq_set_priority(irq, PICO_HIGHEST_IRQ_PRIORITY);
+    irq_set_enabled(irq, true);
+}
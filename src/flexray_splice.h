@@ -0,0 +1,76 @@
+#ifndef FLEXRAY_SPLICE_H
+#define FLEXRAY_SPLICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/pio.h"
+
+// Streaming byte substitution. A rule in splice mode does not replace its
+// target frame with the cached template: the forwarder passes the frame
+// through bit by bit and drives only a window of payload bytes from the
+// composed template (host slice, signals, routes, E2E), so every byte
+// outside the window is the ECU's current one instead of last cycle's.
+//
+// fire_rule hands the forwarder a plan of PIO instructions (see the splice
+// path in flexray_forwarder_with_injector.pio). Live bytes all share one
+// 8-word copy block that the DMA replays from a read ring; only the window
+// and the 3 frame-CRC bytes have their own plan words. The CRC is linear, so
+// the corrected trailer is the transmitter's own trailer XOR the CRC of
+// (driven ^ live) over the window: the trailer bits are passed through with
+// mov pins, ~pins where that delta has a one. The delta is planned with last
+// cycle's window bytes, and a PIO IRQ right after the window lets core1
+// recompute it from the live bytes in the streamer ring and rewrite the
+// trailer words before the DMA reaches them (SPLICE_MIN_TAIL_BYTES of
+// payload, about 1 us each, are left for that). Per-byte delta tables are
+// built on core0 when the template's length is first seen.
+//
+// Bytes of the template outside the window (e.g. a signal placed elsewhere)
+// are not sent; the window should cover the rule's E2E area. A rule without
+// a layout for the frame's length falls back to whole-frame injection.
+//
+// Op 0xA1 configures a rule; FLEXRAY_READ_SPLICE reads splice_state_t per rule.
+
+#define SPLICE_MAX_BYTES 16u
+#define SPLICE_MIN_TAIL_BYTES 4u   // payload bytes between the window and the frame CRC
+
+typedef struct __attribute__((packed)) {
+    uint8_t enabled;
+    uint8_t offset;               // window, payload bytes
+    uint8_t len;
+    uint8_t payload_len;          // layout built for this target length, 0 = none
+    uint32_t splices;             // frames sent with a spliced window
+    uint32_t corrected;           // trailer rewritten: live window bytes differed from last cycle
+    uint32_t late;                // ...after the DMA had read it, so that frame had a bad CRC
+    uint32_t aborted;             // frame ended before the plan (shorter than the template)
+    uint32_t unready;             // triggers that fell back to whole-frame injection
+} splice_state_t;
+
+typedef enum {
+    SPLICE_CONFIG_OK = 0,
+    SPLICE_CONFIG_INVALID,
+    SPLICE_CONFIG_BUSY,           // core1 may still use the layout a rebuild would overwrite
+} splice_config_result_t;
+
+// Core0 (USB). len 0 selects the rule's host slice and its E2E area as
+// configured at this point (send 0xA1 again after changing it); disabling
+// ignores the window. Unless SPLICE_CONFIG_OK the rule keeps its old
+// configuration.
+splice_config_result_t splice_configure(uint8_t rule, bool enabled, uint8_t offset, uint8_t len);
+// Core0, when a rule's template is cached: (re)builds the layout for its
+// length, or leaves it for the next capture while core1 still holds it.
+void splice_prepare(uint8_t rule, uint16_t payload_len);
+uint16_t splice_read(uint8_t *out, uint16_t cap);
+
+void splice_setup(PIO pio, uint sm_to_vehicle, uint sm_to_ecu, uint program_offset);
+// Must run on core1, next to the streamer IRQ
+void splice_irq_init(PIO pio);
+
+// Core1, from fire_rule. begin saves the window before the template is
+// edited and is false if this trigger cannot be spliced; fire then plans
+// and starts the splice instead of inject_frame.
+bool splice_begin(uint8_t rule, const uint8_t *payload, uint16_t payload_len);
+void splice_fire(uint8_t rule, const uint8_t *frame);
+// Core1, streamer ISR: a frame from this source ended
+void splice_frame_end(bool is_vehicle);
+
+#endif // FLEXRAY_SPLICE_H
@@ -0,0 +1,318 @@
+#include "flexray_stream_codec.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+
+// Payload history lives in an open-addressed table keyed by
+// (source, frame_id, cycle_count & mux). Only core0 encodes (main loop and
+// TinyUSB callbacks), so no locking is needed.
+
+#define CODEC_TABLE_SIZE   2048u // power of two
+#define CODEC_TABLE_MASK   (CODEC_TABLE_SIZE - 1u)
+#define CODEC_MAX_PROBE    16u
+#define CODEC_KEY_EMPTY    0u
+#define CODEC_REF_NONE     0xFFFFu
+
+typedef struct {
+    uint32_t key;         // CODEC_KEY_EMPTY or make_key() result
+    uint32_t hash;        // hash of the last payload sent (FULL or DELTA)
+    uint16_t since_full;  // occurrences since the last FULL record
+    uint16_t ref;         // codec_ref_payload index or CODEC_REF_NONE
+    uint8_t ref_cycle;    // cycle count of the last payload sent
+    uint8_t ref_words;    // its payload_length_words
+    uint8_t ref_indicators;
+    uint8_t ref_valid;    // ref holds that payload
+} codec_slot_t;
+
+static codec_slot_t codec_table[CODEC_TABLE_SIZE];
+// Last payload sent per slot, handed out on first use in STREAM_MODE_DELTA
+static uint8_t codec_ref_payload[STREAM_DELTA_REF_COUNT][STREAM_DELTA_MAX_PAYLOAD];
+static uint16_t codec_ref_used = 0;
+static stream_mode_t codec_mode = STREAM_MODE_FULL;
+static uint8_t codec_flags = STREAM_FLAG_EMIT_UNCHANGED;
+static uint16_t codec_keyframe_interval = 64;
+static uint8_t codec_cycle_mux_mask = 0x03;
+static stream_codec_stats_t codec_stats;
+
+static inline uint32_t make_key(const flexray_frame_t *frame)
+{
+    // +1 keeps every valid key distinct from CODEC_KEY_EMPTY
+    return 1u + (((uint32_t)(frame->source & 1u) << 17) |
+                 ((uint32_t)(frame->frame_id & 0x7FFu) << 6) |
+                 (uint32_t)(frame->cycle_count & codec_cycle_mux_mask));
+}
+
+static inline uint32_t key_bucket(uint32_t key)
+{
+    return (key * 2654435761u) >> (32u - 11u); // log2(CODEC_TABLE_SIZE)
+}
+
+// FNV-1a over everything an UNCHANGED record asks the host to reuse
+static uint32_t __not_in_flash_func(frame_content_hash)(const flexray_frame_t *frame)
+{
+    uint32_t h = 2166136261u;
+    h = (h ^ frame->indicators) * 16777619u;
+    h = (h ^ frame->payload_length_words) * 16777619u;
+    uint16_t n = (uint16_t)(frame->payload_length_words * 2u);
+    for (uint16_t i = 0; i < n; i++) {
+        h = (h ^ frame->payload[i]) * 16777619u;
+    }
+    return h;
+}
+
+static int16_t __not_in_flash_func(find_slot)(uint32_t key)
+{
+    uint32_t b = key_bucket(key);
+    for (uint32_t p = 0; p < CODEC_MAX_PROBE; p++) {
+        uint32_t idx = (b + p) & CODEC_TABLE_MASK;
+        uint32_t k = codec_table[idx].key;
+        if (k == key || k == CODEC_KEY_EMPTY) {
+            return (int16_t)idx;
+        }
+    }
+    return -1;
+}
+
+static uint16_t __not_in_flash_func(encode_full)(const flexray_frame_t *frame, uint8_t *out)
+{
+    uint16_t payload_len_bytes = (uint16_t)(frame->payload_length_words * 2u);
+    uint16_t body_len = (uint16_t)(1u /*source*/ + 5u /*header*/ + payload_len_bytes + 3u /*crc*/);
+    uint16_t w = 0;
+    out[w++] = (uint8_t)(body_len & 0xFF);
+    out[w++] = (uint8_t)((body_len >> 8) & 0xFF);
+    out[w++] = frame->source;
+
+    // Reconstruct 5-byte header
+    out[w++] = (uint8_t)((frame->indicators << 3) | ((frame->frame_id >> 8) & 0x07));
+    out[w++] = (uint8_t)(frame->frame_id & 0xFF);
+    out[w++] = (uint8_t)((frame->payload_length_words << 1) | ((frame->header_crc >> 10) & 0x01));
+    out[w++] = (uint8_t)((frame->header_crc >> 2) & 0xFF);
+    out[w++] = (uint8_t)(((frame->header_crc & 0x03) << 6) | (frame->cycle_count & 0x3F));
+
+    // Payload (only used portion)
+    if (payload_len_bytes > 0) {
+        memcpy(&out[w], frame->payload, payload_len_bytes);
+        w = (uint16_t)(w + payload_len_bytes);
+    }
+
+    // 24-bit CRC big-endian
+    out[w++] = (uint8_t)((frame->frame_crc >> 16) & 0xFF);
+    out[w++] = (uint8_t)((frame->frame_crc >> 8) & 0xFF);
+    out[w++] = (uint8_t)(frame->frame_crc & 0xFF);
+    return w;
+}
+
+static uint16_t __not_in_flash_func(encode_unchanged)(const flexray_frame_t *frame, uint8_t ref_cycle, uint8_t *out)
+{
+    out[0] = (uint8_t)STREAM_UNCHANGED_BODY_LEN;
+    out[1] = 0;
+    out[2] = (uint8_t)((STREAM_RECORD_UNCHANGED << STREAM_RECORD_KIND_SHIFT) | (frame->source & STREAM_RECORD_SOURCE_MASK));
+    out[3] = (uint8_t)(frame->frame_id & 0xFF);
+    out[4] = (uint8_t)((frame->frame_id >> 8) & 0x07);
+    out[5] = (uint8_t)(frame->cycle_count & 0x3F);
+    out[6] = ref_cycle;
+    out[7] = (uint8_t)((frame->frame_crc >> 16) & 0xFF);
+    out[8] = (uint8_t)((frame->frame_crc >> 8) & 0xFF);
+    out[9] = (uint8_t)(frame->frame_crc & 0xFF);
+    return (uint16_t)(2u + STREAM_UNCHANGED_BODY_LEN);
+}
+
+// Returns 0 when the DELTA record would not be smaller than full_len
+static uint16_t __not_in_flash_func(encode_delta)(const flexray_frame_t *frame, const codec_slot_t *s,
+                                                  uint16_t full_len, uint8_t *out)
+{
+    const uint8_t *ref = codec_ref_payload[s->ref];
+    uint16_t n = (uint16_t)(frame->payload_length_words * 2u);
+    uint16_t mask_len = (uint16_t)((n + 7u) / 8u);
+    uint16_t w = (uint16_t)(2u + STREAM_DELTA_FIXED_BODY_LEN);
+    uint16_t data = (uint16_t)(w + mask_len);
+    if (data >= full_len) {
+        return 0;
+    }
+
+    memset(&out[w], 0, mask_len);
+    for (uint16_t i = 0; i < n; i++) {
+        uint8_t x = (uint8_t)(frame->payload[i] ^ ref[i]);
+        if (x != 0) {
+            out[w + (i >> 3)] |= (uint8_t)(1u << (i & 7u));
+            out[data++] = x;
+            if (data >= full_len) {
+                return 0;
+            }
+        }
+    }
+
+    uint16_t body_len = (uint16_t)(data - 2u);
+    out[0] = (uint8_t)(body_len & 0xFF);
+    out[1] = (uint8_t)((body_len >> 8) & 0xFF);
+    out[2] = (uint8_t)((STREAM_RECORD_DELTA << STREAM_RECORD_KIND_SHIFT) | (frame->source & STREAM_RECORD_SOURCE_MASK));
+    out[3] = (uint8_t)(frame->frame_id & 0xFF);
+    out[4] = (uint8_t)((frame->frame_id >> 8) & 0x07);
+    out[5] = (uint8_t)(frame->cycle_count & 0x3F);
+    out[6] = s->ref_cycle;
+    out[7] = (uint8_t)((frame->frame_crc >> 16) & 0xFF);
+    out[8] = (uint8_t)((frame->frame_crc >> 8) & 0xFF);
+    out[9] = (uint8_t)(frame->frame_crc & 0xFF);
+    return data;
+}
+
+void stream_codec_reset_history(void)
+{
+    memset(codec_table, 0, sizeof(codec_table));
+    for (uint32_t i = 0; i < CODEC_TABLE_SIZE; i++) {
+        codec_table[i].ref = CODEC_REF_NONE;
+    }
+    codec_ref_used = 0;
+}
+
+void stream_codec_init(void)
+{
+    stream_codec_reset_history();
+    memset(&codec_stats, 0, sizeof(codec_stats));
+}
+
+void stream_codec_set_mode(stream_mode_t mode, uint8_t flags, uint16_t keyframe_interval, uint8_t cycle_mux_mask)
+{
+    codec_mode = (mode == STREAM_MODE_CHANGES_ONLY || mode == STREAM_MODE_DELTA) ? mode : STREAM_MODE_FULL;
+    codec_flags = flags;
+    codec_keyframe_interval = keyframe_interval;
+    codec_cycle_mux_mask = (uint8_t)(cycle_mux_mask & 0x3F);
+    // Keys depend on the mux mask and the host restarts its history too
+    stream_codec_init();
+}
+
+uint16_t __not_in_flash_func(stream_codec_encode)(const flexray_frame_t *frame, uint8_t *out, stream_codec_pending_t *pending)
+{
+    pending->slot = -1;
+    pending->kind = STREAM_RECORD_FULL;
+    pending->cycle = frame->cycle_count;
+    pending->saved = 0;
+    pending->key = CODEC_KEY_EMPTY;
+    pending->hash = 0;
+    pending->frame = frame;
+
+    if (codec_mode == STREAM_MODE_FULL) {
+        return encode_full(frame, out);
+    }
+
+    uint32_t key = make_key(frame);
+    int16_t slot = find_slot(key);
+    if (slot < 0) {
+        codec_stats.table_full++;
+        return encode_full(frame, out);
+    }
+
+    const codec_slot_t *s = &codec_table[slot];
+    uint32_t hash = frame_content_hash(frame);
+    pending->slot = slot;
+    pending->key = key;
+    pending->hash = hash;
+
+    bool same_slot = (s->key == key);
+    bool ref_usable = same_slot && s->ref_valid &&
+                      s->ref_words == frame->payload_length_words &&
+                      s->ref_indicators == frame->indicators;
+    bool known = same_slot && (s->hash == hash);
+    if (known && s->ref_valid) {
+        // Exact check where we have the bytes, so a hash collision cannot
+        // desync the host's DELTA reference
+        known = ref_usable && memcmp(codec_ref_payload[s->ref], frame->payload,
+                                     (size_t)frame->payload_length_words * 2u) == 0;
+    }
+    bool keyframe_due = (codec_keyframe_interval != 0) && ((uint16_t)(s->since_full + 1u) >= codec_keyframe_interval);
+
+    if (keyframe_due) {
+        if (known) {
+            codec_stats.keyframes++;
+        }
+        return encode_full(frame, out);
+    }
+    if (!known) {
+        uint16_t full_len = encode_full(frame, out);
+        if (codec_mode == STREAM_MODE_DELTA && ref_usable) {
+            // Scratch buffer, so the FULL record stays intact if DELTA does
+            // not pay off
+            uint8_t delta[2u + STREAM_DELTA_FIXED_BODY_LEN + STREAM_DELTA_MAX_PAYLOAD / 8u + STREAM_DELTA_MAX_PAYLOAD];
+            uint16_t delta_len = encode_delta(frame, s, full_len, delta);
+            if (delta_len > 0) {
+                memcpy(out, delta, delta_len);
+                pending->kind = STREAM_RECORD_DELTA;
+                pending->saved = (uint16_t)(full_len - delta_len);
+                return delta_len;
+            }
+        }
+        return full_len;
+    }
+
+    pending->kind = STREAM_RECORD_UNCHANGED;
+    if (!(codec_flags & STREAM_FLAG_EMIT_UNCHANGED)) {
+        return 0;
+    }
+    return encode_unchanged(frame, s->ref_cycle, out);
+}
+
+static void __not_in_flash_func(store_reference)(codec_slot_t *s, const flexray_frame_t *frame)
+{
+    uint16_t n = (uint16_t)(frame->payload_length_words * 2u);
+    s->ref_valid = 0;
+    if (codec_mode != STREAM_MODE_DELTA || n > STREAM_DELTA_MAX_PAYLOAD) {
+        return;
+    }
+    if (s->ref == CODEC_REF_NONE) {
+        if (codec_ref_used >= STREAM_DELTA_REF_COUNT) {
+            codec_stats.ref_pool_full++;
+            return;
+        }
+        s->ref = codec_ref_used++;
+    }
+    memcpy(codec_ref_payload[s->ref], frame->payload, n);
+    s->ref_valid = 1;
+}
+
+void __not_in_flash_func(stream_codec_commit)(const stream_codec_pending_t *pending)
+{
+    switch (pending->kind) {
+    case STREAM_RECORD_UNCHANGED:
+        if (codec_flags & STREAM_FLAG_EMIT_UNCHANGED) {
+            codec_stats.unchanged_records++;
+        } else {
+            codec_stats.suppressed++;
+        }
+        break;
+    case STREAM_RECORD_DELTA:
+        codec_stats.delta_records++;
+        codec_stats.delta_bytes_saved += pending->saved;
+        break;
+    default:
+        codec_stats.full_records++;
+        break;
+    }
+
+    if (pending->slot < 0) {
+        return;
+    }
+    codec_slot_t *s = &codec_table[pending->slot];
+    if (pending->kind == STREAM_RECORD_UNCHANGED) {
+        if (s->since_full < UINT16_MAX) {
+            s->since_full++;
+        }
+        return;
+    }
+
+    const flexray_frame_t *frame = pending->frame;
+    s->key = pending->key;
+    s->hash = pending->hash;
+    s->ref_cycle = pending->cycle;
+    s->ref_words = frame->payload_length_words;
+    s->ref_indicators = frame->indicators;
+    store_reference(s, frame);
+    if (pending->kind == STREAM_RECORD_FULL) {
+        s->since_full = 0;
+    } else if (s->since_full < UINT16_MAX) {
+        s->since_full++;
+    }
+}
+
+void stream_codec_get_stats(stream_codec_stats_t *out)
+{
+    *out = codec_stats;
+}
@@ -0,0 +1,90 @@
+#ifndef FLEXRAY_STREAM_CODEC_H
+#define FLEXRAY_STREAM_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flexray_frame.h"
+
+// Encodes FIFO frames into bulk IN records: [u16 body_len][body].
+// Body byte 0 carries the frame source in bits 0..5 and the record kind in
+// bits 6..7, so legacy full-frame records (kind 0) are unchanged on the wire.
+//
+//  kind 0 FULL:      [src][5B header][payload][3B crc]
+//  kind 1 UNCHANGED: [src|0x40][u16 id][u8 cycle][u8 ref_cycle][3B crc]
+//    payload, length and indicators equal the last FULL/DELTA record of
+//    (src, id, ref_cycle); crc is this frame's own CRC.
+//  kind 2 DELTA:     [src|0x80][u16 id][u8 cycle][u8 ref_cycle][3B crc][mask][xor bytes]
+//    header fields as the reference frame (src, id, ref_cycle); mask has one
+//    bit per payload byte (LSB first, ceil(len/8) bytes) and each set bit is
+//    followed, in order, by that byte XORed with the reference payload.
+//  kind 3 CYCLE_SNAPSHOT: one cycle of static slots, see flexray_cycle_snapshot.h
+
+#define STREAM_RECORD_KIND_SHIFT     6
+#define STREAM_RECORD_SOURCE_MASK    0x3F
+#define STREAM_RECORD_FULL           0x00
+#define STREAM_RECORD_UNCHANGED      0x01
+#define STREAM_RECORD_DELTA          0x02
+#define STREAM_RECORD_CYCLE_SNAPSHOT 0x03
+
+#define STREAM_UNCHANGED_BODY_LEN    8u
+#define STREAM_DELTA_FIXED_BODY_LEN  8u
+
+// Payloads up to this size keep a copy of the last sent bytes for DELTA
+// records; larger ones only get FULL/UNCHANGED.
+#define STREAM_DELTA_MAX_PAYLOAD     64u
+#define STREAM_DELTA_REF_COUNT       512u
+
+// Largest record: len field + source + header + payload + crc
+#define STREAM_RECORD_MAX_BYTES      (2u + 1u + 5u + MAX_FRAME_PAYLOAD_BYTES + 3u)
+// Smallest record the encoder can produce
+#define STREAM_RECORD_MIN_BYTES      (2u + STREAM_UNCHANGED_BODY_LEN)
+
+typedef enum {
+    STREAM_MODE_FULL = 0,        // every frame as a FULL record (default)
+    STREAM_MODE_CHANGES_ONLY = 1,
+    STREAM_MODE_DELTA = 2,       // changes only, changed payloads as DELTA when smaller
+} stream_mode_t;
+
+// Mode flags
+#define STREAM_FLAG_EMIT_UNCHANGED 0x01 // send UNCHANGED ticks instead of dropping repeats
+#define STREAM_FLAG_CONTAINER_V2   0x02 // batch records in container v2 (flexray_telemetry.h)
+
+typedef struct {
+    uint32_t full_records;
+    uint32_t keyframes;          // FULL records forced by the keyframe interval
+    uint32_t unchanged_records;
+    uint32_t delta_records;
+    uint32_t delta_bytes_saved;  // FULL size minus DELTA size, summed
+    uint32_t suppressed;         // repeats dropped without a tick
+    uint32_t table_full;         // frames sent FULL because no slot was free
+    uint32_t ref_pool_full;      // slots left without a DELTA reference
+} stream_codec_stats_t;
+
+// Encoder decision for one frame, applied by stream_codec_commit() only once
+// the record has been queued to USB.
+typedef struct {
+    int16_t slot;
+    uint8_t kind;
+    uint8_t cycle;
+    uint16_t saved;
+    uint32_t key;
+    uint32_t hash;
+    const flexray_frame_t *frame; // must stay valid until commit
+} stream_codec_pending_t;
+
+void stream_codec_init(void);
+// keyframe_interval: a (src, id, cycle-mux) slot is sent FULL at least every
+// N occurrences (0 = only on change). cycle_mux_mask selects which cycle
+// count bits keep separate payload histories for the same ID.
+void stream_codec_set_mode(stream_mode_t mode, uint8_t flags, uint16_t keyframe_interval, uint8_t cycle_mux_mask);
+// Forget all payload history; the next frame of every slot goes out FULL.
+void stream_codec_reset_history(void);
+
+// Build the record for frame into out (STREAM_RECORD_MAX_BYTES). Returns the
+// record length, or 0 when the frame needs no record at all.
+uint16_t stream_codec_encode(const flexray_frame_t *frame, uint8_t *out, stream_codec_pending_t *pending);
+void stream_codec_commit(const stream_codec_pending_t *pending);
+
+void stream_codec_get_stats(stream_codec_stats_t *out);
+
+#endif // FLEXRAY_STREAM_CODEC_H
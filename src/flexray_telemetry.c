@@ -0,0 +1,99 @@
+#include "flexray_telemetry.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+
+// Same bounded MPSC scheme as flexray_log.c: reserve with a CAS on head,
+// publish with a per-slot seq store, single consumer on core0.
+
+#define TELEMETRY_RING_SIZE 64u // power of two
+#define TELEMETRY_RING_MASK (TELEMETRY_RING_SIZE - 1u)
+
+typedef struct {
+    volatile uint32_t seq;
+    uint8_t type;
+    uint8_t len;
+    uint8_t value[TELEMETRY_MAX_VALUE];
+} telemetry_slot_t;
+
+static telemetry_slot_t telemetry_ring[TELEMETRY_RING_SIZE];
+static volatile uint32_t telemetry_head = 0;
+static volatile uint32_t telemetry_tail = 0;
+static volatile uint32_t telemetry_drops = 0;
+static volatile bool telemetry_enabled = false;
+
+void telemetry_init(void)
+{
+    memset(telemetry_ring, 0, sizeof(telemetry_ring));
+    telemetry_head = 0;
+    telemetry_tail = 0;
+    telemetry_drops = 0;
+}
+
+void telemetry_set_enabled(bool enabled)
+{
+    telemetry_enabled = enabled;
+}
+
+bool __not_in_flash_func(telemetry_post)(uint8_t type, const void *value, uint8_t len)
+{
+    if (!telemetry_enabled) {
+        return false;
+    }
+    if (len > TELEMETRY_MAX_VALUE) {
+        len = TELEMETRY_MAX_VALUE;
+    }
+    uint32_t head = __atomic_load_n(&telemetry_head, __ATOMIC_RELAXED);
+    do {
+        if ((uint32_t)(head - __atomic_load_n(&telemetry_tail, __ATOMIC_ACQUIRE)) >= TELEMETRY_RING_SIZE) {
+            __atomic_fetch_add(&telemetry_drops, 1u, __ATOMIC_RELAXED);
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&telemetry_head, &head, head + 1u, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    telemetry_slot_t *slot = &telemetry_ring[head & TELEMETRY_RING_MASK];
+    slot->type = type;
+    slot->len = len;
+    memcpy(slot->value, value, len);
+    __atomic_store_n(&slot->seq, head + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint8_t telemetry_peek_len(void)
+{
+    uint32_t tail = telemetry_tail;
+    const telemetry_slot_t *slot = &telemetry_ring[tail & TELEMETRY_RING_MASK];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != tail + 1u) {
+        return 0;
+    }
+    return slot->len;
+}
+
+bool telemetry_pop(uint8_t *type, uint8_t *value, uint8_t *len)
+{
+    uint32_t tail = telemetry_tail;
+    telemetry_slot_t *slot = &telemetry_ring[tail & TELEMETRY_RING_MASK];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != tail + 1u) {
+        return false; // empty, or the producer has not published yet
+    }
+    *type = slot->type;
+    *len = slot->len;
+    memcpy(value, slot->value, slot->len);
+    __atomic_store_n(&telemetry_tail, tail + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t telemetry_dropped(void)
+{
+    return telemetry_drops;
+}
+
+void telemetry_discard(void)
+{
+    uint8_t type;
+    uint8_t len;
+    uint8_t value[TELEMETRY_MAX_VALUE];
+    while (telemetry_pop(&type, value, &len)) {
+    }
+    __atomic_store_n(&telemetry_drops, 0u, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,112 @@
+#ifndef FLEXRAY_TELEMETRY_H
+#define FLEXRAY_TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Bulk IN container v2 (enabled with STREAM_FLAG_CONTAINER_V2, op 0x95).
+// Every batch written to the vendor IN endpoint starts with a fixed header
+// and carries TLV records up to header.batch_len:
+//
+//   [stream_batch_header_t][u8 type][u16 len][len bytes value]...
+//
+// Batches are never split across writes, so the host only needs to resync
+// at batch boundaries (scan for STREAM_BATCH_MAGIC), and a gap in seq or a
+// change in the drop counters makes loss visible. All fields little-endian.
+
+#define STREAM_BATCH_MAGIC   0xF5
+#define STREAM_BATCH_VERSION 2
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic;
+    uint8_t version;
+    uint16_t batch_len;          // bytes including this header
+    uint32_t seq;                // +1 per batch, reset by op 0x95
+    uint32_t timestamp_us;       // time_us_32() when the batch was built
+    uint32_t fifo_dropped;       // frames lost to a full USB FIFO (cumulative)
+    uint32_t notify_dropped;     // frames lost between core1 and core0 (cumulative)
+    uint32_t event_dropped;      // telemetry events lost (cumulative)
+} stream_batch_header_t;
+
+#define STREAM_TLV_HEADER_BYTES 3u
+
+// TLV types
+#define STREAM_TLV_FRAME     0x01 // value = record body from flexray_stream_codec.h
+#define STREAM_TLV_INJECTION 0x02 // telemetry_injection_t
+#define STREAM_TLV_ERROR     0x03 // telemetry_error_t
+#define STREAM_TLV_STATS     0x04 // telemetry_stats_t
+#define STREAM_TLV_OVERRIDE_ACK 0x05 // injector_ack_t (flexray_forwarder_with_injector.h)
+#define STREAM_TLV_TIMEBASE  0x06 // telemetry_timebase_t, while the cycle timebase is locked
+
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp_us;
+    uint16_t target_id;
+    uint8_t cycle_count;
+    uint8_t direction;
+    uint16_t trigger_id;
+    uint16_t frame_len;
+} telemetry_injection_t;
+
+typedef enum {
+    TELEMETRY_ERR_PARSE_FAIL = 1,        // arg0 = frame id from the raw header, arg1 = source
+    TELEMETRY_ERR_FRAME_OVERFLOW = 2,    // arg0 = captured length, arg1 = source
+    TELEMETRY_ERR_OVERRIDE_REJECTED = 3, // arg0 = target id, arg1 = cycle base
+    TELEMETRY_ERR_PREDICATE_REJECTED = 4, // arg0 = rule, arg1 = index of the bad instruction, 0xFF = busy
+    TELEMETRY_ERR_ROUTE_REJECTED = 5,    // arg0 = gateway route index, arg1 = injection rule or TELEMETRY_ARG_BUSY
+    TELEMETRY_ERR_SIGNAL_REJECTED = 6,   // arg0 = signal id, arg1 = 0 descriptor / 1 value
+    TELEMETRY_ERR_E2E_REJECTED = 7,      // arg0 = rule, arg1 = profile or TELEMETRY_ARG_BUSY
+    TELEMETRY_ERR_SPLICE_REJECTED = 8,   // arg0 = rule, arg1 = window length or TELEMETRY_ARG_BUSY
+    TELEMETRY_ERR_BLOCK_REJECTED = 9,    // arg0 = direction, arg1 = first bitmap byte
+    TELEMETRY_ERR_EARLY_REJECTED = 10,   // arg0 = rule, arg1 = enable
+} telemetry_error_code_t;
+
+// arg1 of a *_REJECTED error when core1 still used the copy a reload would
+// overwrite: nothing was wrong with the request, resend it
+#define TELEMETRY_ARG_BUSY 0x100u
+
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp_us;
+    uint16_t code;
+    uint16_t reserved;
+    uint32_t arg0;
+    uint32_t arg1;
+} telemetry_error_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp_us;
+    uint32_t frames_total;
+    uint32_t frames_valid;
+    uint32_t parse_fail;
+    uint32_t filtered;
+    uint32_t fifo_count;
+} telemetry_stats_t;
+
+// Maps device time to FlexRay global time: at timestamp_us the bus was at
+// macrotick `macrotick` of cycle `cycle_index` (see flexray_timebase.h)
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp_us;
+    uint32_t cycle_index;
+    uint32_t macrotick;
+    uint32_t macrotick_ps;
+    uint32_t cycle_macroticks;
+} telemetry_timebase_t;
+
+#define TELEMETRY_MAX_VALUE 24u
+
+// Boot only: resets the ring under any producer that is mid-post
+void telemetry_init(void);
+
+// Queue an event for the next container batch. Safe from either core and
+// from interrupt context; never blocks. Returns false without queueing while
+// container v2 is off, and counts a drop when the ring is full.
+bool telemetry_post(uint8_t type, const void *value, uint8_t len);
+void telemetry_set_enabled(bool enabled);
+
+// Consumer side (core0 USB send path)
+uint8_t telemetry_peek_len(void); // value length of the oldest event, 0 if none
+bool telemetry_pop(uint8_t *type, uint8_t *value, uint8_t *len);
+uint32_t telemetry_dropped(void);
+// Drop every published event; safe while producers are live
+void telemetry_discard(void);
+
+#endif // FLEXRAY_TELEMETRY_H
@@ -0,0 +1,306 @@
+#include "flexray_timebase.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "hardware/timer.h"
+#include "flexray_frame.h"
+#include "flexray_schedule.h"
+
+// Times are kept in ns on a 64-bit extension of time_us_32()
+static bool have_ref = false;    // ref_ns/ref_index hold an anchor
+static bool have_period = false;
+static uint64_t ref_ns = 0;      // model anchor end of cycle ref_index
+static uint32_t ref_index = 0;   // cycle counter extended past 64, low 6 bits = cycle_count
+static bool have_index = false;  // ref_index has been anchored once; it never goes back
+static uint32_t period_q8 = 0;   // ns << 8 (cycles up to 16.7 ms)
+static uint32_t good_cycles = 0;
+static uint32_t last_us = 0;
+static uint64_t ext_us = 0;      // unwrapped time of last_us
+static uint32_t nominal_mt_ns = TIMEBASE_NOMINAL_MT_NS;
+
+static timebase_status_t status = { .anchor_id = SCHEDULE_NO_ANCHOR };
+static timebase_model_t model;
+
+static inline uint64_t unwrap(uint32_t now_us)
+{
+    ext_us += (uint32_t)(now_us - last_us);
+    last_us = now_us;
+    return ext_us;
+}
+
+static void start_acquisition(void)
+{
+    have_ref = false;
+    have_period = false;
+    good_cycles = 0;
+    status.locked = 0;
+    memset(&model, 0, sizeof(model));
+    model.nominal_macrotick_ns = nominal_mt_ns;
+}
+
+void timebase_reset(void)
+{
+    start_acquisition();
+    memset(&status, 0, sizeof(status));
+    status.anchor_id = SCHEDULE_NO_ANCHOR;
+}
+
+void timebase_set_nominal_macrotick(uint32_t ns)
+{
+    nominal_mt_ns = ns ? ns : TIMEBASE_NOMINAL_MT_NS;
+    timebase_reset();
+}
+
+static inline uint32_t abs32(int32_t v)
+{
+    return v < 0 ? (uint32_t)-v : (uint32_t)v;
+}
+
+// Macrotick from the locked period: the cycle is a whole number of them
+static void update_macrotick(void)
+{
+    uint32_t period_ns = period_q8 >> 8;
+    uint32_t cycle_mt = (period_ns + nominal_mt_ns / 2u) / nominal_mt_ns;
+    if (cycle_mt == 0) {
+        return;
+    }
+    model.cycle_macroticks = cycle_mt;
+    model.macrotick_ps = (uint32_t)(((uint64_t)period_q8 * 1000u) / ((uint64_t)cycle_mt << 8));
+    uint64_t nominal_q8 = ((uint64_t)cycle_mt * nominal_mt_ns) << 8;
+    status.drift_ppb = (int32_t)(((int64_t)period_q8 - (int64_t)nominal_q8) * 1000000000 / (int64_t)nominal_q8);
+    if (model.flags & TIMEBASE_MODEL_SLOTS) {
+        model.slot_macroticks = (uint16_t)(((uint64_t)model.slot_ns * 1000u + model.macrotick_ps / 2u) / model.macrotick_ps);
+    }
+}
+
+typedef struct {
+    int64_t n, sx, sy, sxx, sxy;
+} fit_sums_t;
+
+static inline void fit_add(fit_sums_t *f, int64_t x, int64_t y)
+{
+    f->n++;
+    f->sx += x;
+    f->sy += y;
+    f->sxx += x * x;
+    f->sxy += x * y;
+}
+
+// Frame start of a learned static slot relative to the anchor end, in ns
+static bool slot_point(const schedule_entry_t *e, int64_t *y)
+{
+    if (!(e->flags & SCHEDULE_FLAG_STATIC) || !(e->flags & SCHEDULE_FLAG_OFFSET) ||
+        e->payload_words == SCHEDULE_LEN_VARIES || e->samples < SCHEDULE_MIN_SAMPLES) {
+        return false;
+    }
+    int64_t end_ns = ((int64_t)e->offset_min_us + e->offset_max_us) * 500;
+    *y = end_ns - (int64_t)flexray_frame_duration_us(e->payload_words) * 1000;
+    return true;
+}
+
+// Least squares, then again without points further than TIMEBASE_FIT_OUTLIER_NS
+// (dynamic-segment frames that happen to look static)
+static void fit_slots(void)
+{
+    int64_t slope = 0, icept = 0;
+    schedule_entry_t e;
+    for (int pass = 0; pass < 2; pass++) {
+        fit_sums_t f = {0};
+        uint16_t last_slot = 0;
+        uint32_t worst = 0;
+        for (uint16_t k = 0; schedule_get(k, &e); k++) {
+            int64_t y;
+            if (!slot_point(&e, &y)) {
+                continue;
+            }
+            if (pass == 1) {
+                int64_t res = y - (icept + slope * e.frame_id);
+                uint32_t ares = (uint32_t)(res < 0 ? -res : res);
+                if (ares > TIMEBASE_FIT_OUTLIER_NS) {
+                    continue;
+                }
+                if (ares > worst) worst = ares;
+            }
+            fit_add(&f, e.frame_id, y);
+            if (e.frame_id > last_slot) last_slot = e.frame_id;
+        }
+        int64_t den = f.n * f.sxx - f.sx * f.sx;
+        if (f.n < TIMEBASE_FIT_MIN_POINTS || den == 0) {
+            model.flags &= (uint8_t)~TIMEBASE_MODEL_SLOTS;
+            return;
+        }
+        slope = (f.n * f.sxy - f.sx * f.sy) / den;
+        icept = (f.sy - slope * f.sx) / f.n;
+        if (slope <= 0) {
+            model.flags &= (uint8_t)~TIMEBASE_MODEL_SLOTS;
+            return;
+        }
+        model.fit_points = (uint16_t)f.n;
+        model.static_slots = last_slot;
+        model.fit_residual_ns = worst;
+    }
+    model.slot_ns = (uint32_t)slope;
+    model.cycle_start_ns = (int32_t)(icept + slope); // slot 1
+    model.flags |= TIMEBASE_MODEL_SLOTS;
+}
+
+// (Re)anchor at cycle_count. ref_index keeps counting across acquisitions:
+// the cycles elapsed since the old anchor are estimated from the last
+// measured period (from the cycle_count step alone before there is one) and
+// only the low 6 bits are re-phased, so TIMEBASE time never goes backwards.
+static void reanchor(uint64_t now_ns, uint8_t cycle_count)
+{
+    if (have_index) {
+        uint32_t est = ref_index;
+        uint32_t period_ns = period_q8 >> 8;
+        if (period_ns != 0 && now_ns > ref_ns) {
+            est += (uint32_t)((now_ns - ref_ns + period_ns / 2u) / period_ns);
+        }
+        // Nearest index with the observed cycle_count, not before the old one
+        int32_t step = (int32_t)((cycle_count - est) & 0x3Fu);
+        if (step >= 32) {
+            step -= 64;
+        }
+        uint32_t idx = est + (uint32_t)step;
+        if ((int32_t)(idx - ref_index) < 0) {
+            idx += 64u;
+        }
+        ref_index = idx;
+    } else {
+        ref_index = cycle_count;
+        have_index = true;
+    }
+    ref_ns = now_ns;
+    have_ref = true;
+}
+
+bool __not_in_flash_func(timebase_observe)(uint16_t frame_id, uint8_t cycle_count, uint8_t source,
+                                           bool timed, uint32_t end_us)
+{
+    uint16_t anchor_id;
+    uint8_t anchor_source;
+    if (!timed || !schedule_get_anchor(&anchor_id, &anchor_source) ||
+        frame_id != anchor_id || source != anchor_source) {
+        return false;
+    }
+    if (anchor_id != status.anchor_id || anchor_source != status.anchor_source) {
+        status.anchor_id = anchor_id;
+        status.anchor_source = anchor_source;
+        start_acquisition();
+    }
+
+    uint64_t now_ns = unwrap(end_us) * 1000u;
+    uint8_t cycles = (uint8_t)((cycle_count - ref_index) & 0x3Fu);
+    if (!have_ref || cycles == 0) {
+        reanchor(now_ns, cycle_count);
+        return true;
+    }
+    if (!have_period) {
+        if (cycles == 1) {
+            period_q8 = (uint32_t)(now_ns - ref_ns) << 8;
+            have_period = true;
+        }
+        ref_ns = now_ns;
+        ref_index += cycles;
+        return true;
+    }
+
+    uint64_t pred_ns = ref_ns + (((uint64_t)cycles * period_q8) >> 8);
+    int32_t err = (int32_t)(int64_t)(now_ns - pred_ns);
+    if (abs32(err) > TIMEBASE_UNLOCK_US * 1000u) {
+        start_acquisition();
+        reanchor(now_ns, cycle_count);
+        return true;
+    }
+    // Wide loop to acquire, narrow once locked so ISR jitter does not walk the period
+    int32_t kp = status.locked ? TIMEBASE_KP_LOCKED : TIMEBASE_KP_ACQUIRE;
+    int32_t ki = status.locked ? TIMEBASE_KI_LOCKED : TIMEBASE_KI_ACQUIRE;
+    ref_ns = pred_ns + (err / kp);
+    ref_index += cycles;
+    period_q8 = (uint32_t)((int32_t)period_q8 + (err * 256) / (ki * (int32_t)cycles));
+
+    status.phase_err_ns = err;
+    status.jitter_avg_ns = (uint32_t)((int32_t)status.jitter_avg_ns + ((int32_t)abs32(err) - (int32_t)status.jitter_avg_ns) / 16);
+    if (status.locked) {
+        status.cycles++;
+        if (abs32(err) > status.jitter_max_ns) status.jitter_max_ns = abs32(err);
+    } else if (abs32(err) <= TIMEBASE_LOCK_WINDOW_US * 1000u) {
+        if (++good_cycles >= TIMEBASE_LOCK_CYCLES) {
+            status.locked = 1;
+            status.locks++;
+            status.jitter_max_ns = abs32(err);
+        }
+    } else {
+        good_cycles = 0;
+    }
+    status.period_ns = period_q8 >> 8;
+    if (status.locked && cycle_count == 0) {
+        fit_slots();
+    }
+    update_macrotick();
+    return true;
+}
+
+bool timebase_locked(void)
+{
+    return status.locked != 0;
+}
+
+bool timebase_predict(uint8_t cycles_ahead, int32_t offset_us, uint8_t *anchor_cycle, uint32_t *at_us)
+{
+    if (!status.locked) {
+        return false;
+    }
+    uint64_t t_ns = ref_ns + (((uint64_t)cycles_ahead * period_q8) >> 8);
+    // Back to time_us_32() terms: ext_us and last_us describe the same instant
+    *at_us = last_us + (uint32_t)(t_ns / 1000u - ext_us) + (uint32_t)offset_us;
+    *anchor_cycle = (uint8_t)(ref_index & 0x3Fu);
+    return true;
+}
+
+bool timebase_position(uint32_t at_us, timebase_position_t *out)
+{
+    if (!status.locked || model.macrotick_ps == 0) {
+        return false;
+    }
+    // ns since the start of cycle ref_index (its anchor end until slots are fitted)
+    int64_t t = ((int64_t)ext_us + (int32_t)(at_us - last_us)) * 1000 - (int64_t)ref_ns;
+    if (model.flags & TIMEBASE_MODEL_SLOTS) {
+        t -= model.cycle_start_ns;
+    }
+    int64_t period = (int64_t)(period_q8 >> 8);
+    int64_t k = t / period;
+    if (t < 0 && k * period != t) {
+        k--; // floor
+    }
+    uint32_t mt = (uint32_t)(((t - k * period) * 1000) / model.macrotick_ps);
+    out->cycle_index = ref_index + (uint32_t)k;
+    out->cycle_count = (uint8_t)(out->cycle_index & 0x3Fu);
+    out->macrotick = mt;
+    out->slot = 0;
+    out->slot_macrotick = 0;
+    if ((model.flags & TIMEBASE_MODEL_SLOTS) && model.slot_macroticks &&
+        mt < (uint32_t)model.static_slots * model.slot_macroticks) {
+        out->slot = (uint16_t)(mt / model.slot_macroticks + 1u);
+        out->slot_macrotick = (uint16_t)(mt % model.slot_macroticks);
+    }
+    return true;
+}
+
+void timebase_get_status(timebase_status_t *out)
+{
+    *out = status;
+}
+
+void timebase_get_model(timebase_model_t *out)
+{
+    model.flags = (uint8_t)((model.flags & ~TIMEBASE_MODEL_LOCKED) | (status.locked ? TIMEBASE_MODEL_LOCKED : 0));
+    *out = model;
+    out->now_us = time_us_32();
+    timebase_position_t pos;
+    if (timebase_position(out->now_us, &pos)) {
+        out->now_cycle_index = pos.cycle_index;
+        out->now_macrotick = pos.macrotick;
+        out->now_slot = pos.slot;
+        out->now_slot_macrotick = pos.slot_macrotick;
+    }
+}
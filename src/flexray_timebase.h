@@ -0,0 +1,102 @@
+#ifndef FLEXRAY_TIMEBASE_H
+#define FLEXRAY_TIMEBASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Cycle timebase. A small PLL locks a local model of the FlexRay cycle (phase
+// and length, in Pico time) to the end times of the schedule anchor frame
+// (flexray_schedule.h). Each anchor corrects the phase by 1/KP and the
+// period by 1/KI of the error, with a wider loop until lock.
+// TIMEBASE_LOCK_CYCLES anchors in a row within TIMEBASE_LOCK_WINDOW_US
+// declare lock, one error beyond TIMEBASE_UNLOCK_US (or a new anchor)
+// starts acquisition again. Core0 only.
+//
+// Once per 64 cycles the learned static slots are fitted to a line
+// (frame start vs slot number = frame ID): the slope is the static slot
+// length, slot 1 is the cycle start. Slot boundaries are placed at the action
+// point (frame start); the real ones are gdActionPointOffset earlier. The
+// cycle is a whole number of macroticks of the configured nominal length
+// (1 us unless set), which gives the macrotick measured in Pico time.
+//
+// Read (FLEXRAY_READ_TIMEBASE): timebase_status_t, timebase_model_t.
+// Write (FLEXRAY_SET_TIMEBASE): wValue = nominal macrotick in ns (0 = 1000),
+// restarts acquisition.
+
+#define TIMEBASE_LOCK_WINDOW_US 8
+#define TIMEBASE_LOCK_CYCLES    8u
+#define TIMEBASE_UNLOCK_US      50
+#define TIMEBASE_KP_ACQUIRE     4
+#define TIMEBASE_KI_ACQUIRE     64
+#define TIMEBASE_KP_LOCKED      16
+#define TIMEBASE_KI_LOCKED      1024
+#define TIMEBASE_NOMINAL_MT_NS  1000u
+#define TIMEBASE_FIT_MIN_POINTS 3u
+#define TIMEBASE_FIT_OUTLIER_NS 3000  // dropped from the second fit pass
+
+#define TIMEBASE_MODEL_LOCKED   0x01
+#define TIMEBASE_MODEL_SLOTS    0x02  // static slot grid fitted
+
+typedef struct __attribute__((packed)) {
+    uint8_t locked;
+    uint8_t anchor_source;
+    uint16_t anchor_id;
+    uint32_t period_ns;           // cycle length measured with the Pico crystal
+    int32_t drift_ppb;            // bus clock vs Pico crystal (measured vs nominal macrotick)
+    int32_t phase_err_ns;         // last anchor, observed - predicted
+    uint32_t jitter_avg_ns;       // mean |phase error| (1/16 EMA)
+    uint32_t jitter_max_ns;       // largest |phase error| since lock
+    uint32_t locks;               // lock acquisitions
+    uint32_t cycles;              // anchors seen while locked
+} timebase_status_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t flags;                // TIMEBASE_MODEL_*
+    uint8_t reserved;
+    uint16_t static_slots;        // highest static slot in the fit
+    uint32_t nominal_macrotick_ns;
+    uint32_t macrotick_ps;        // measured, in Pico time
+    uint32_t cycle_macroticks;    // gdCycle
+    uint16_t slot_macroticks;     // gdStaticSlot
+    uint16_t fit_points;
+    uint32_t slot_ns;             // fitted static slot length
+    int32_t cycle_start_ns;       // cycle start relative to the anchor frame end
+    uint32_t fit_residual_ns;     // largest residual of the fit
+    // Position at read time: maps time_us_32() to global time
+    uint32_t now_us;
+    uint32_t now_cycle_index;     // cycles since first lock, never goes back; low 6 bits = cycle_count
+    uint32_t now_macrotick;       // macrotick within the cycle
+    uint16_t now_slot;            // static slot, 0 outside the static segment
+    uint16_t now_slot_macrotick;  // macrotick within the slot
+} timebase_model_t;
+
+typedef struct {
+    uint32_t cycle_index;
+    uint8_t cycle_count;
+    uint32_t macrotick;
+    uint16_t slot;
+    uint16_t slot_macrotick;
+} timebase_position_t;
+
+void timebase_reset(void);
+void timebase_set_nominal_macrotick(uint32_t ns);
+
+// Core0 parse loop, after schedule_update(). True when the frame was the
+// anchor and the model was updated (a good moment to plan timed work).
+bool timebase_observe(uint16_t frame_id, uint8_t cycle_count, uint8_t source, bool timed, uint32_t end_us);
+
+bool timebase_locked(void);
+
+// Cycle count of the last anchor and the predicted anchor end time
+// cycles_ahead cycles later, plus offset_us. False unless locked.
+bool timebase_predict(uint8_t cycles_ahead, int32_t offset_us, uint8_t *anchor_cycle, uint32_t *at_us);
+
+void timebase_get_status(timebase_status_t *out);
+
+// Where in the FlexRay cycle at_us (time_us_32() terms) is. False unless locked;
+// slot is 0 until the static slot grid has been fitted.
+bool timebase_position(uint32_t at_us, timebase_position_t *out);
+
+void timebase_get_model(timebase_model_t *out);
+
+#endif // FLEXRAY_TIMEBASE_H
@@ -0,0 +1,105 @@
+#include "flexray_timed_injection.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "hardware/timer.h"
+#include "flexray_frame.h"
+#include "flexray_schedule.h"
+#include "flexray_injector_rules.h"
+#include "flexray_forwarder_with_injector.h"
+
+typedef struct {
+    int32_t target_offset_us;
+    uint32_t planned;
+    uint32_t unplanned;
+} timed_rule_t;
+
+static timed_rule_t timed_rules[NUM_TRIGGER_RULES];
+
+void timed_injection_configure(uint8_t rule, uint16_t lead_us)
+{
+    if (rule >= NUM_TRIGGER_RULES) {
+        return;
+    }
+    injector_set_timed(rule, lead_us);
+    memset(&timed_rules[rule], 0, sizeof(timed_rules[rule]));
+}
+
+// Target slot start relative to the anchor end, same cycle
+static bool target_offset(const trigger_rule_t *r, int32_t *offset_us)
+{
+    schedule_entry_t e;
+    if (!schedule_lookup(r->target_id, &e) || !(e.flags & SCHEDULE_FLAG_STATIC) ||
+        e.payload_words == SCHEDULE_LEN_VARIES) {
+        return false;
+    }
+    *offset_us = e.offset_min_us - (int32_t)flexray_frame_duration_us(e.payload_words);
+    return true;
+}
+
+void __not_in_flash_func(timed_injection_plan)(void)
+{
+    for (uint32_t i = 0; i < NUM_TRIGGER_RULES; i++) {
+        uint16_t lead_us = injector_get_timed((uint8_t)i);
+        if (lead_us == 0) {
+            continue;
+        }
+        const trigger_rule_t *r = &INJECT_TRIGGERS[i];
+        timed_rule_t *t = &timed_rules[i];
+        uint8_t cycle;
+        uint32_t at_us;
+        // The anchor opens the cycle, so its target comes later in the same cycle
+        if (!timebase_predict(0, 0, &cycle, &at_us) ||
+            (uint8_t)(cycle & r->cycle_mask) != r->cycle_base) {
+            continue;
+        }
+        if (!target_offset(r, &t->target_offset_us)) {
+            t->unplanned++;
+            continue;
+        }
+        at_us += (uint32_t)(t->target_offset_us - (int32_t)lead_us);
+        if ((int32_t)(at_us - time_us_32()) < TIMED_MIN_SETUP_US ||
+            !injector_arm_timed((uint8_t)i, cycle, at_us)) {
+            t->unplanned++;
+            continue;
+        }
+        t->planned++;
+    }
+}
+
+uint16_t timed_injection_read(uint8_t *out, uint16_t cap)
+{
+    uint16_t w = sizeof(timebase_status_t) + sizeof(timed_injection_header_t);
+    if (cap < w) {
+        return 0;
+    }
+    timebase_status_t tb;
+    timebase_get_status(&tb);
+    memcpy(out, &tb, sizeof(tb));
+
+    uint8_t count = 0;
+    for (uint32_t i = 0; i < NUM_TRIGGER_RULES && (uint32_t)w + sizeof(timed_injection_entry_t) <= cap; i++) {
+        injector_timed_stats_t st;
+        injector_get_timed_stats((uint8_t)i, &st);
+        timed_injection_entry_t entry = {
+            .rule = (uint8_t)i,
+            .lead_us = injector_get_timed((uint8_t)i),
+            .target_offset_us = timed_rules[i].target_offset_us,
+            .planned = timed_rules[i].planned,
+            .unplanned = timed_rules[i].unplanned,
+            .injected = st.injected,
+            .idle = st.idle,
+            .late = st.late,
+            .lateness_avg_us = st.fired ? st.lateness_sum_us / st.fired : 0,
+            .lateness_max_us = st.lateness_max_us,
+        };
+        memcpy(&out[w], &entry, sizeof(entry));
+        w = (uint16_t)(w + sizeof(entry));
+        count++;
+    }
+    timed_injection_header_t hdr = {
+        .count = count,
+        .entry_size = sizeof(timed_injection_entry_t),
+    };
+    memcpy(&out[sizeof(tb)], &hdr, sizeof(hdr));
+    return w;
+}
@@ -0,0 +1,49 @@
+#ifndef FLEXRAY_TIMED_INJECTION_H
+#define FLEXRAY_TIMED_INJECTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flexray_timebase.h"
+
+// Time-triggered injection planner (core0). For targets without a usable
+// predecessor frame: each time the timebase sees the anchor of a cycle the
+// rule fires in, the target slot start is predicted from the locked cycle
+// model plus the target's offset in the learned schedule, and the injector
+// alarm is armed lead_us before it. The lead must be shorter than the gap to
+// the previous frame on the forwarder input, or that frame is replaced.
+//
+// Read (FLEXRAY_READ_TIMED_INJECTION): timebase_status_t, timed_injection_header_t,
+// count x timed_injection_entry_t. Write (FLEXRAY_SET_TIMED_INJECTION):
+// wValue = rule, wIndex = lead_us (0 = back to its trigger frame).
+
+// Planned alarms closer than this to now are not armed
+#define TIMED_MIN_SETUP_US 20
+
+typedef struct __attribute__((packed)) {
+    uint8_t count;
+    uint8_t entry_size;
+    uint16_t reserved;
+} timed_injection_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t rule;
+    uint8_t reserved;
+    uint16_t lead_us;              // 0 = frame-triggered
+    int32_t target_offset_us;      // target slot start after anchor end, from the schedule
+    uint32_t planned;              // alarms armed
+    uint32_t unplanned;            // firing cycles skipped: no lock, no schedule, too close, busy
+    uint32_t injected;             // alarms that loaded a frame
+    uint32_t idle;                 // alarms with nothing to inject
+    uint32_t late;                 // alarms too late to arm before the slot
+    uint32_t lateness_avg_us;      // alarm callback behind its planned time
+    uint32_t lateness_max_us;
+} timed_injection_entry_t;
+
+void timed_injection_configure(uint8_t rule, uint16_t lead_us);
+
+// Core0, whenever timebase_observe() returns true
+void timed_injection_plan(void);
+
+uint16_t timed_injection_read(uint8_t *out, uint16_t cap);
+
+#endif // FLEXRAY_TIMED_INJECTION_H
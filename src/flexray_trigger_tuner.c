@@ -0,0 +1,264 @@
+#include "flexray_trigger_tuner.h"
+#include <string.h>
+#include "pico/platform/sections.h"
+#include "flexray_frame.h"
+#include "flexray_schedule.h"
+#include "flexray_injector_rules.h"
+#include "flexray_forwarder_with_injector.h"
+#include "flexray_qos.h"
+
+// Core0 only. Frame starts are derived from frame ends with
+// flexray_frame_duration_us(), so slack is never overestimated.
+
+typedef struct {
+    bool trigger_valid;            // trigger_end_us/trigger_cycle hold the last active trigger
+    uint8_t trigger_cycle;
+    uint32_t trigger_end_us;
+    int32_t slack_min_us;
+    int32_t slack_max_us;
+    uint32_t slack_samples;
+    uint8_t status;
+    uint16_t recommended;
+    int32_t recommended_slack_us;
+    uint16_t switches;
+    uint16_t promoted;             // trigger auto mode raised to CONTROL, 0 = none
+    uint8_t promoted_class;        // its class before that
+} tuner_rule_t;
+
+static tuner_rule_t tuner_rules[NUM_TRIGGER_RULES];
+static uint8_t tuner_mode = TUNER_MODE_MEASURE;
+static uint8_t tuner_margin_us = TUNER_DEFAULT_MARGIN_US;
+
+static inline bool rule_fires(const trigger_rule_t *r, uint8_t cycle_count)
+{
+    return (uint8_t)(cycle_count & r->cycle_mask) == r->cycle_base;
+}
+
+static uint64_t rule_cycle_mask(const trigger_rule_t *r)
+{
+    uint64_t mask = 0;
+    for (uint8_t c = 0; c < 64; c++) {
+        if (rule_fires(r, c)) {
+            mask |= 1ull << c;
+        }
+    }
+    return mask;
+}
+
+// The target is read on the forwarder input of the rule's direction
+static inline uint8_t target_source(const trigger_rule_t *r)
+{
+    return r->direction == INJECT_DIRECTION_TO_ECU ? FROM_VEHICLE : FROM_ECU;
+}
+
+// Undo rule i's CONTROL promotion unless another rule still uses that trigger
+static void demote(uint32_t i)
+{
+    uint16_t id = tuner_rules[i].promoted;
+    if (id == 0) {
+        return;
+    }
+    tuner_rules[i].promoted = 0;
+    for (uint32_t j = 0; j < NUM_TRIGGER_RULES; j++) {
+        if (tuner_rules[j].promoted == id) {
+            return;
+        }
+    }
+    qos_set_class(id, (qos_class_t)tuner_rules[i].promoted_class);
+}
+
+static void promote(uint32_t i, uint16_t id)
+{
+    demote(i);
+    uint8_t cls = (uint8_t)qos_get_class(id);
+    for (uint32_t j = 0; j < NUM_TRIGGER_RULES; j++) {
+        if (tuner_rules[j].promoted == id) {
+            cls = tuner_rules[j].promoted_class; // already raised by rule j
+        }
+    }
+    tuner_rules[i].promoted = id;
+    tuner_rules[i].promoted_class = cls;
+    qos_set_class(id, QOS_CLASS_CONTROL);
+}
+
+static void clear_measurements(void)
+{
+    for (uint32_t i = 0; i < NUM_TRIGGER_RULES; i++) {
+        tuner_rules[i].trigger_valid = false;
+        tuner_rules[i].slack_min_us = 0;
+        tuner_rules[i].slack_max_us = 0;
+        tuner_rules[i].slack_samples = 0;
+    }
+    injector_reset_latency();
+}
+
+void trigger_tuner_configure(uint8_t mode, uint8_t margin_us)
+{
+    tuner_mode = (mode == TUNER_MODE_AUTO) ? TUNER_MODE_AUTO : TUNER_MODE_MEASURE;
+    tuner_margin_us = margin_us ? margin_us : TUNER_DEFAULT_MARGIN_US;
+    for (uint32_t i = 0; i < NUM_TRIGGER_RULES; i++) {
+        if (tuner_mode == TUNER_MODE_MEASURE) {
+            injector_set_trigger((uint8_t)i, 0);
+            demote(i);
+        }
+        tuner_rules[i].status = TUNER_STATUS_LEARNING;
+        tuner_rules[i].recommended = TUNER_NO_TRIGGER;
+        tuner_rules[i].recommended_slack_us = 0;
+    }
+    clear_measurements();
+}
+
+void __not_in_flash_func(trigger_tuner_observe)(uint16_t frame_id, uint8_t cycle_count, uint8_t source,
+                                                uint8_t payload_words, bool timed, uint32_t end_us)
+{
+    if (!timed) {
+        return;
+    }
+    for (uint32_t i = 0; i < NUM_TRIGGER_RULES; i++) {
+        const trigger_rule_t *r = &INJECT_TRIGGERS[i];
+        tuner_rule_t *t = &tuner_rules[i];
+        if (!rule_fires(r, cycle_count)) {
+            continue;
+        }
+        if (frame_id == injector_get_trigger((uint8_t)i)) {
+            t->trigger_valid = true;
+            t->trigger_cycle = cycle_count;
+            t->trigger_end_us = end_us;
+        } else if (frame_id == r->target_id && source == target_source(r)) {
+            if (!t->trigger_valid || t->trigger_cycle != cycle_count) {
+                continue;
+            }
+            t->trigger_valid = false;
+            int32_t slack = (int32_t)(end_us - flexray_frame_duration_us(payload_words) - t->trigger_end_us);
+            if (t->slack_samples == 0 || slack < t->slack_min_us) t->slack_min_us = slack;
+            if (t->slack_samples == 0 || slack > t->slack_max_us) t->slack_max_us = slack;
+            t->slack_samples++;
+        }
+    }
+}
+
+static inline bool usable(const schedule_entry_t *e)
+{
+    return (e->flags & SCHEDULE_FLAG_STATIC) && (e->flags & SCHEDULE_FLAG_OFFSET) &&
+           e->payload_words != SCHEDULE_LEN_VARIES;
+}
+
+static void recommend(uint32_t i)
+{
+    const trigger_rule_t *r = &INJECT_TRIGGERS[i];
+    tuner_rule_t *t = &tuner_rules[i];
+    t->recommended = TUNER_NO_TRIGGER;
+    t->recommended_slack_us = 0;
+
+    schedule_entry_t target;
+    if (!schedule_lookup(r->target_id, &target) || !usable(&target)) {
+        t->status = TUNER_STATUS_LEARNING;
+        return;
+    }
+    injector_latency_t lat;
+    injector_get_latency((uint8_t)i, &lat);
+    uint32_t latency_us = lat.samples ? lat.max_us : TUNER_ASSUMED_LATENCY_US;
+    int32_t target_start = target.offset_min_us - (int32_t)flexray_frame_duration_us(target.payload_words);
+    int32_t need = (int32_t)(latency_us + tuner_margin_us);
+    uint64_t fires = rule_cycle_mask(r);
+
+    // Latest frame that ends early enough in every cycle the rule fires in
+    schedule_entry_t e;
+    int32_t best_end = 0;
+    for (uint16_t k = 0; schedule_get(k, &e); k++) {
+        if (e.frame_id == r->target_id || !usable(&e) || (e.cycle_mask & fires) != fires) {
+            continue;
+        }
+        if (target_start - e.offset_max_us < need) {
+            continue;
+        }
+        if (t->recommended == TUNER_NO_TRIGGER || e.offset_max_us > best_end) {
+            t->recommended = e.frame_id;
+            best_end = e.offset_max_us;
+        }
+    }
+    if (t->recommended == TUNER_NO_TRIGGER) {
+        t->status = TUNER_STATUS_NO_CANDIDATE;
+        return;
+    }
+
+    // Once armed the forwarder replaces the next frame on its input, so no
+    // other frame may start there between the trigger end and the target
+    uint8_t path = target_source(r) == FROM_VEHICLE ? SCHEDULE_SOURCE_VEHICLE : SCHEDULE_SOURCE_ECU;
+    for (uint16_t k = 0; schedule_get(k, &e); k++) {
+        if (e.frame_id == r->target_id || !(e.sources & path) || !(e.flags & SCHEDULE_FLAG_OFFSET) ||
+            !(e.cycle_mask & fires)) {
+            continue;
+        }
+        uint8_t words = e.payload_words == SCHEDULE_LEN_VARIES ? 0 : e.payload_words;
+        int32_t latest_start = e.offset_max_us - (int32_t)flexray_frame_duration_us(words);
+        if (latest_start > best_end && e.offset_min_us - (int32_t)flexray_frame_duration_us(words) < target_start) {
+            t->recommended = TUNER_NO_TRIGGER;
+            t->status = TUNER_STATUS_PATH_BUSY;
+            return;
+        }
+    }
+    t->recommended_slack_us = target_start - best_end;
+    t->status = TUNER_STATUS_OK;
+}
+
+void trigger_tuner_task(void)
+{
+    for (uint32_t i = 0; i < NUM_TRIGGER_RULES; i++) {
+        recommend(i);
+        tuner_rule_t *t = &tuner_rules[i];
+        if (tuner_mode != TUNER_MODE_AUTO || t->status != TUNER_STATUS_OK ||
+            t->recommended == injector_get_trigger((uint8_t)i)) {
+            continue;
+        }
+        injector_set_trigger((uint8_t)i, t->recommended);
+        promote(i, t->recommended);
+        t->trigger_valid = false;
+        t->slack_min_us = 0;
+        t->slack_max_us = 0;
+        t->slack_samples = 0;
+        t->switches++;
+    }
+}
+
+uint16_t trigger_tuner_read(uint8_t *out, uint16_t cap)
+{
+    if (cap < sizeof(trigger_tuning_header_t)) {
+        return 0;
+    }
+    uint8_t count = 0;
+    uint16_t w = sizeof(trigger_tuning_header_t);
+    for (uint32_t i = 0; i < NUM_TRIGGER_RULES && (uint32_t)w + sizeof(trigger_tuning_entry_t) <= cap; i++) {
+        const tuner_rule_t *t = &tuner_rules[i];
+        injector_latency_t lat;
+        injector_get_latency((uint8_t)i, &lat);
+        trigger_tuning_entry_t entry = {
+            .rule = (uint8_t)i,
+            .status = t->status,
+            .target_id = INJECT_TRIGGERS[i].target_id,
+            .configured_trigger = INJECT_TRIGGERS[i].trigger_id,
+            .active_trigger = injector_get_trigger((uint8_t)i),
+            .recommended_trigger = t->recommended,
+            .switches = t->switches,
+            .recommended_slack_us = t->recommended_slack_us,
+            .slack_min_us = t->slack_min_us,
+            .slack_max_us = t->slack_max_us,
+            .slack_samples = t->slack_samples,
+            .latency_min_us = lat.min_us,
+            .latency_max_us = lat.max_us,
+            .latency_avg_us = lat.samples ? lat.sum_us / lat.samples : 0,
+            .latency_samples = lat.samples,
+        };
+        memcpy(&out[w], &entry, sizeof(entry));
+        w = (uint16_t)(w + sizeof(entry));
+        count++;
+    }
+    trigger_tuning_header_t hdr = {
+        .count = count,
+        .entry_size = sizeof(trigger_tuning_entry_t),
+        .mode = tuner_mode,
+        .margin_us = tuner_margin_us,
+    };
+    memcpy(out, &hdr, sizeof(hdr));
+    return w;
+}
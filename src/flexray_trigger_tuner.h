@@ -0,0 +1,72 @@
+#ifndef FLEXRAY_TRIGGER_TUNER_H
+#define FLEXRAY_TRIGGER_TUNER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Trigger tuner. An injection only works if the injector is armed (DMA
+// started) after its trigger frame ended and before the target slot starts;
+// the forwarder then replaces the next frame it sees. Per rule this measures
+//   slack   = target frame start - trigger frame end (same cycle, core0)
+//   latency = trigger frame end (streamer ISR entry) -> injector DMA start
+// and picks, from the learned schedule (flexray_schedule.h), the latest
+// static frame that ends at least latency_max + margin before the target
+// starts, is sent in every cycle the rule fires in, and leaves no other
+// frame starting on the forwarder's input in between.
+//
+// Read (FLEXRAY_READ_TRIGGER_TUNING): trigger_tuning_header_t, count x
+// trigger_tuning_entry_t. Write (FLEXRAY_SET_TRIGGER_TUNING): wValue = mode,
+// wIndex = margin_us (0 = default, at most 255); also clears the measurements.
+
+#define TUNER_MODE_MEASURE 0 // recommend only, rules keep their compiled-in trigger
+#define TUNER_MODE_AUTO    1 // move each rule's trigger to the recommendation (QoS CONTROL
+                             // while in use, then back to its previous class)
+
+#define TUNER_DEFAULT_MARGIN_US   10u
+#define TUNER_ASSUMED_LATENCY_US  10u // until the rule has injected at least once
+#define TUNER_NO_TRIGGER          0xFFFFu
+
+typedef enum {
+    TUNER_STATUS_LEARNING = 0,     // target has no static offset in the schedule yet
+    TUNER_STATUS_OK = 1,           // recommended_trigger is valid
+    TUNER_STATUS_NO_CANDIDATE = 2, // no frame ends early enough in every firing cycle
+    TUNER_STATUS_PATH_BUSY = 3,    // another frame starts on the forwarder input in between
+} tuner_status_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t count;
+    uint8_t entry_size;
+    uint8_t mode;                  // TUNER_MODE_*
+    uint8_t margin_us;
+} trigger_tuning_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t rule;                  // index into INJECT_TRIGGERS
+    uint8_t status;                // tuner_status_t
+    uint16_t target_id;
+    uint16_t configured_trigger;   // INJECT_TRIGGERS[rule].trigger_id
+    uint16_t active_trigger;       // what try_inject_frame matches now
+    uint16_t recommended_trigger;  // TUNER_NO_TRIGGER unless status is OK
+    uint16_t switches;             // auto-mode trigger changes
+    int32_t recommended_slack_us;  // from the schedule, recommended trigger
+    int32_t slack_min_us;          // observed, active trigger
+    int32_t slack_max_us;
+    uint32_t slack_samples;
+    uint32_t latency_min_us;
+    uint32_t latency_max_us;
+    uint32_t latency_avg_us;
+    uint32_t latency_samples;
+} trigger_tuning_entry_t;
+
+void trigger_tuner_configure(uint8_t mode, uint8_t margin_us);
+
+// Core0 parse loop, next to schedule_update()
+void trigger_tuner_observe(uint16_t frame_id, uint8_t cycle_count, uint8_t source, uint8_t payload_words,
+                           bool timed, uint32_t end_us);
+
+// Core0, periodically: recompute recommendations, apply them in auto mode
+void trigger_tuner_task(void);
+
+uint16_t trigger_tuner_read(uint8_t *out, uint16_t cap);
+
+#endif // FLEXRAY_TRIGGER_TUNER_H
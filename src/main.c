@@ -22,6 +22,22 @@
 #include "panda_usb.h"
 #include "flexray_bss_streamer.h"
 #include "flexray_forwarder_with_injector.h"
+#include "flexray_profile.h"
+#include "flexray_log.h"
+#include "flexray_filter.h"
+#include "flexray_stream_codec.h"
+#include "flexray_telemetry.h"
+#include "flexray_qos.h"
+#include "flexray_cycle_snapshot.h"
+#include "panda_usb_intr.h"
+#include "flexray_frame_table.h"
+#include "flexray_id_stats.h"
+#include "flexray_schedule.h"
+#include "flexray_trigger_tuner.h"
+#include "flexray_timebase.h"
+#include "flexray_timed_injection.h"
+#include "flexray_splice.h"
+#include "flexray_frame_id_matcher.h"
 
 #define SRAM __attribute__((section(".data")))
 #define FLASH __attribute__((section(".rodata")))
@@ -49,11 +65,7 @@ static void print_ram_usage(void) {
 	size_t gap_heap_to_sp = sp - (uintptr_t)heap_end;   // remaining space between heap and sp
 	size_t stack_free = sp - stack_limit;               // remaining space in stack
 
-	printf("RAM usage: heap_used=%lu B, stack_used=%lu B, gap(heap->sp)=%lu B, stack_free=%lu B\n",
-	       (unsigned long)heap_used,
-	       (unsigned long)stack_used,
-	       (unsigned long)gap_heap_to_sp,
-	       (unsigned long)stack_free);
+	FLOG4(LOG_RAM_USAGE, heap_used, stack_used, gap_heap_to_sp, stack_free);
 }
 
 
@@ -97,28 +109,118 @@ typedef struct {
     uint32_t source_veh;
     uint32_t overflow_len;
     uint32_t zero_len;
+    uint32_t filtered;
+    uint32_t invalid;
 } stream_stats_t;
 
-uint8_t FRAME_CACHE[262][10];
-
 static void stats_print(const stream_stats_t *s, uint32_t prev_total, uint32_t prev_valid)
 {
     // Use number of parsed frames (len_ok) to represent total frames per second
     uint32_t total_fps = (s->len_ok - prev_total) / 5; // 5s interval
     uint32_t valid_fps = (s->valid - prev_valid) / 5;       // 5s interval
 
-    printf("Ring Stats: total=%lu seq_gap=%lu src[ECU=%lu,VEH=%lu] len_ok=%lu len_mis=%lu overflow=%lu zero=%lu parse_fail=%lu valid=%lu | fps[frames=%lu/s,valid=%lu/s]\n",
-           s->total_notif, s->seq_gap, s->source_ecu, s->source_veh,
-           s->len_ok, s->len_mismatch, s->overflow_len, s->zero_len,
-           s->parse_fail, s->valid, total_fps, valid_fps);
-    printf("Notify dropped=%lu\n", notify_queue_dropped());
+    // Deferred: the records are formatted later by the UART pump or the host
+    FLOG6(LOG_RING_STATS, s->total_notif, s->seq_gap, s->source_ecu, s->source_veh,
+          s->len_ok, s->len_mismatch);
+    FLOG6(LOG_RING_STATS_2, s->overflow_len, s->zero_len, s->parse_fail, s->valid,
+          total_fps, valid_fps);
+    FLOG1(LOG_NOTIFY_DROPPED, notify_queue_dropped());
+    FLOG1(LOG_INVALID_FRAMES, s->invalid);
+
+    stream_filter_stats_t fs;
+    stream_filter_get_stats(&fs);
+    FLOG5(LOG_FILTER_STATS, s->filtered, fs.dropped_id, fs.dropped_cycle,
+          fs.dropped_decimated, fs.dropped_null);
+    stream_codec_stats_t cs;
+    stream_codec_get_stats(&cs);
+    FLOG5(LOG_CODEC_STATS, cs.full_records, cs.keyframes, cs.unchanged_records,
+          cs.suppressed, cs.table_full);
+    FLOG3(LOG_CODEC_DELTA_STATS, cs.delta_records, cs.delta_bytes_saved, cs.ref_pool_full);
+
+    // Same numbers in-band for container v2 hosts (no-op otherwise)
+    telemetry_stats_t ts = {
+        .timestamp_us = time_us_32(),
+        .frames_total = s->len_ok,
+        .frames_valid = s->valid,
+        .parse_fail = s->parse_fail,
+        .filtered = s->filtered,
+        .fifo_count = panda_flexray_fifo_count(),
+    };
+    telemetry_post(STREAM_TLV_STATS, &ts, sizeof(ts));
+
+    qos_stats_t qs;
+    qos_get_stats(&qs);
+    FLOG6(LOG_QOS_STATS, qs.enqueued[QOS_CLASS_CONTROL], qs.dropped[QOS_CLASS_CONTROL],
+          qs.enqueued[QOS_CLASS_NORMAL], qs.dropped[QOS_CLASS_NORMAL],
+          qs.enqueued[QOS_CLASS_BULK], qs.dropped[QOS_CLASS_BULK]);
+
+    cycle_snapshot_stats_t ss;
+    cycle_snapshot_get_stats(&ss);
+    FLOG4(LOG_SNAPSHOT_STATS, ss.snapshots, ss.replaced, ss.overflow, ss.out_of_order);
+
+    frame_table_stats_t fts;
+    frame_table_get_stats(&fts);
+    FLOG4(LOG_FRAME_TABLE_STATS, fts.entries, fts.updates, fts.changes, fts.table_full);
+
+    id_stats_summary_t ids;
+    id_stats_get_summary(&ids);
+    FLOG2(LOG_ID_STATS, ids.entries, ids.table_full);
+
+    static uint8_t tuning[sizeof(trigger_tuning_header_t) + sizeof(trigger_tuning_entry_t)];
+    if (trigger_tuner_read(tuning, sizeof(tuning)) == sizeof(tuning))
+    {
+        const trigger_tuning_entry_t *te = (const trigger_tuning_entry_t *)&tuning[sizeof(trigger_tuning_header_t)];
+        FLOG6(LOG_TRIGGER_TUNER, te->target_id, te->active_trigger, te->recommended_trigger,
+              te->slack_min_us, te->latency_max_us, te->status);
+    }
+
+    timebase_status_t tb;
+    timebase_get_status(&tb);
+    FLOG6(LOG_TIMEBASE, tb.locked, tb.period_ns, tb.drift_ppb, tb.jitter_avg_ns, tb.jitter_max_ns, tb.locks);
+    timebase_model_t tm;
+    timebase_get_model(&tm);
+    FLOG5(LOG_TIMEBASE_MODEL, tm.macrotick_ps, tm.cycle_macroticks, tm.slot_macroticks, tm.static_slots, tm.fit_points);
+    if (tb.locked)
+    {
+        telemetry_timebase_t tt = {
+            .timestamp_us = tm.now_us,
+            .cycle_index = tm.now_cycle_index,
+            .macrotick = tm.now_macrotick,
+            .macrotick_ps = tm.macrotick_ps,
+            .cycle_macroticks = tm.cycle_macroticks,
+        };
+        telemetry_post(STREAM_TLV_TIMEBASE, &tt, sizeof(tt));
+    }
+
+    intr_stats_t is;
+    panda_usb_intr_get_stats(&is);
+    FLOG5(LOG_INTR_STATS, is.rx_packets, is.tx_packets, is.msgs_sent, is.msgs_dropped, injector_ack_dropped());
+
+    usb_flush_stats_t us;
+    panda_usb_get_flush_stats(&us);
+    uint32_t window_us = time_us_32() - us.since_us;
+    FLOG6(LOG_FLUSH_STATS, us.mode, us.flushes, us.flush_threshold, us.flush_timer,
+          us.flush_full, us.bytes);
+    FLOG3(LOG_FLUSH_STATS_2,
+          us.flushes ? (uint32_t)(us.hold_us_total / us.flushes) : 0u,
+          us.hold_us_max,
+          window_us ? (uint32_t)(((uint64_t)us.bytes * 1000000u) / window_us) : 0u);
 }
 
 void core1_entry(void)
 {
+#if FLEXRAY_PROFILE
+    profile_init_core();
+#endif
     setup_stream(pio0,
                  RXD_FROM_ECU_PIN, TXEN_TO_VEHICLE_PIN,
                  RXD_FROM_VEHICLE_PIN, TXEN_TO_ECU_PIN);
+    // Timed injection alarm: its IRQ must run here, next to try_inject_frame
+    injector_timed_init();
+    // Splice trailer fix-up: same reason, and it must preempt the streamer IRQ
+    splice_irq_init(pio2);
+    // Early triggers from the frame ID matcher: same core and priority as the streamer IRQ
+    matcher_irq_init(pio2);
 
     while (1)
     {
@@ -166,12 +268,20 @@ int main(void)
 
     bool clock_configured = set_sys_clock_khz(100000, true);
     stdio_init_all();
+    flexray_log_init();
     printf("static_used=%lu B\n", (unsigned long)((uintptr_t)&__end__ - (uintptr_t)SRAM_BASE));
     print_ram_usage();
     // Initialize Panda USB interface
     panda_usb_init();
     // Initialize cross-core notification queue before starting streams
     notify_queue_init();
+    // Stream everything until the host configures a filter
+    stream_filter_reset(FILTER_DIR_ALL, 0);
+    frame_table_reset(0x03);
+    id_stats_reset();
+    schedule_reset();
+    trigger_tuner_configure(TUNER_MODE_MEASURE, 0);
+    timebase_reset();
     // --- Set system clock to 100MHz (RP2350) ---
     // make PIO clock div has no fraction, reduce jitter
     if (!clock_configured)
@@ -185,6 +295,12 @@ int main(void)
 
     print_pin_assignments();
 
+#if FLEXRAY_PROFILE
+    profile_reset();
+    profile_init_core();
+    printf("Hot-path profiling enabled (DWT cycle counter)\n");
+#endif
+
     printf("Actual system clock: %lu Hz\n", clock_get_hz(clk_sys));
     printf("\n--- FlexRay Continuous Streaming Bridge (Forwarder Mode) ---\n");
 
@@ -210,9 +326,11 @@ int main(void)
     while (true)
     {
         panda_usb_task();
+        replay_stream_task();
         if (time_reached(next_stats_print_time))
         {
             next_stats_print_time = make_timeout_time_ms(5000);
+            trigger_tuner_task();
             stats_print(&stats, prev_total, prev_valid);
             prev_total = stats.len_ok;
             prev_valid = stats.valid;
@@ -225,15 +343,29 @@ int main(void)
         static uint32_t last_seq = 0;
 
         uint32_t encoded;
-        if (!notify_queue_pop(&encoded))
+        uint32_t end_us;
+        if (!notify_queue_pop(&encoded, &end_us))
         {
-            // No pending notifications: keep USB serviced and wait
+            // No pending notifications: keep USB serviced, drain logs and wait
             panda_usb_task();
-            __wfe();
+            if (!flexray_log_uart_pump())
+            {
+                // Coalesced USB data must still go out on time when idle
+                absolute_time_t flush_deadline;
+                if (panda_usb_flush_deadline(&flush_deadline))
+                {
+                    best_effort_wfe_or_timeout(flush_deadline);
+                }
+                else
+                {
+                    __wfe();
+                }
+            }
             continue;
         }
         // Drain the queue including the first popped item
         do {
+            PROFILE_BEGIN(parse_start);
             notify_info_t info; notify_decode(encoded, &info);
 
             stats.total_notif++;
@@ -263,7 +395,15 @@ int main(void)
                     stats.zero_len++;
                 } else {
                     stats.overflow_len++;
+                    telemetry_error_t err = {
+                        .timestamp_us = time_us_32(),
+                        .code = TELEMETRY_ERR_FRAME_OVERFLOW,
+                        .arg0 = len,
+                        .arg1 = info.is_vehicle ? FROM_VEHICLE : FROM_ECU,
+                    };
+                    telemetry_post(STREAM_TLV_ERROR, &err, sizeof(err));
                 }
+                PROFILE_END(PROFILE_PARSE_LOOP, parse_start);
                 continue;
             }
 
@@ -279,6 +419,7 @@ int main(void)
             // The chunk may contain multiple complete frames (e.g., if some notifications were missed).
             // Iterate and parse frames sequentially within [0, len).
             uint16_t pos = 0;
+            bool parse_fail_reported = false;
             while ((uint16_t)(len - pos) >= 8)
             {
                 uint8_t *header = temp_buffer + pos;
@@ -295,20 +436,63 @@ int main(void)
 
                 stats.len_ok++;
 
+                uint8_t source = info.is_vehicle ? FROM_VEHICLE : FROM_ECU;
+                uint16_t hdr_frame_id = (uint16_t)(((header[0] & 0x07) << 8) | header[1]);
                 flexray_frame_t frame;
-                if (!parse_frame_from_slice(header, expected_len, info.is_vehicle ? FROM_VEHICLE : FROM_ECU, &frame))
+                if (!parse_frame_from_slice(header, expected_len, source, &frame))
                 {
                     stats.parse_fail++;
+                    if (!parse_fail_reported)
+                    {
+                        // Once per chunk: byte-wise resync would flood the ring
+                        telemetry_error_t err = {
+                            .timestamp_us = time_us_32(),
+                            .code = TELEMETRY_ERR_PARSE_FAIL,
+                            .arg0 = hdr_frame_id,
+                            .arg1 = source,
+                        };
+                        telemetry_post(STREAM_TLV_ERROR, &err, sizeof(err));
+                        parse_fail_reported = true;
+                    }
                     // Parse failed: resync by advancing 1 byte and retry
                     pos = (uint16_t)(pos + 1);
                     continue;
                 }
-                else if (is_valid_frame(&frame, header))
+                PROFILE_BEGIN(valid_start);
+                bool frame_valid = is_valid_frame(&frame, header);
+                PROFILE_END(PROFILE_IS_VALID_FRAME, valid_start);
+                if (frame_valid)
                 {
                     stats.valid++;
+                    // Learners only take validated frames: after a parse
+                    // failure the byte-wise resync walks through garbage.
+                    // end_us is the end of the chunk's last frame only.
+                    bool timed = (uint16_t)(pos + expected_len) == len;
+                    id_stats_update(frame.frame_id, frame.cycle_count, source, frame.payload_length_words, timed, end_us);
+                    schedule_update(frame.frame_id, frame.cycle_count, source, frame.payload_length_words, timed, end_us);
+                    trigger_tuner_observe(frame.frame_id, frame.cycle_count, source, frame.payload_length_words, timed, end_us);
+                    if (timebase_observe(frame.frame_id, frame.cycle_count, source, timed, end_us))
+                    {
+                        timed_injection_plan();
+                    }
                     // Cache validated frame (header + payload + CRC)
                     try_cache_last_target_frame(frame.frame_id, frame.cycle_count, expected_len, header);
-                    panda_flexray_fifo_push(&frame);
+                    frame_table_update(&frame);
+                    // The filter only gates the USB stream; the table, the
+                    // template cache and the learners see every valid frame
+                    if (!stream_filter_accept(frame.frame_id, frame.cycle_count, source, frame.indicators))
+                    {
+                        stats.filtered++;
+                    }
+                    else if (!cycle_snapshot_add(&frame, panda_flexray_fifo_pushed()))
+                    {
+                        panda_flexray_fifo_push(&frame);
+                    }
+                }
+                else
+                {
+                    stats.invalid++;
+                    id_stats_crc_fail(frame.frame_id, source);
                 }
 
                 // Parsed (even if invalid CRC): consume this frame length
@@ -320,7 +504,8 @@ int main(void)
             } else {
                 last_end_idx_ecu = info.end_idx;
             }
-        } while (notify_queue_pop(&encoded));
+            PROFILE_END(PROFILE_PARSE_LOOP, parse_start);
+        } while (notify_queue_pop(&encoded, &end_us));
     }
 
     return 0;
@@ -7,6 +7,28 @@
 #include "flexray_frame.h"
 #include "flexray_fifo.h"
 #include "flexray_forwarder_with_injector.h"
+#include "flexray_profile.h"
+#include "flexray_log.h"
+#include "flexray_filter.h"
+#include "flexray_stream_codec.h"
+#include "flexray_telemetry.h"
+#include "flexray_qos.h"
+#include "flexray_cycle_snapshot.h"
+#include "panda_usb_intr.h"
+#include "flexray_frame_table.h"
+#include "flexray_id_stats.h"
+#include "flexray_schedule.h"
+#include "flexray_trigger_tuner.h"
+#include "flexray_timed_injection.h"
+#include "flexray_timebase.h"
+#include "flexray_predicate.h"
+#include "flexray_gateway.h"
+#include "flexray_signals.h"
+#include "flexray_e2e.h"
+#include "flexray_splice.h"
+#include "flexray_frame_id_matcher.h"
+#include "replay_frame.h"
+#include "flexray_bss_streamer.h"
 #include <string.h>
 
 // Add near top after includes
@@ -14,6 +36,23 @@ static absolute_time_t last_usb_activity = 0;
 
 // FlexRay FIFO
 static flexray_fifo_t flexray_fifo;
+// Running push/pop totals; a cycle snapshot waits for its seal-time mark
+static uint32_t fifo_pushed = 0;
+static uint32_t fifo_popped = 0;
+
+// Container v2 batching (see flexray_telemetry.h)
+#define STREAM_BATCH_MAX_BYTES 4096u // fits a full cycle snapshot
+static bool container_v2 = false;
+static uint32_t batch_seq = 0;
+static uint8_t batch_buf[STREAM_BATCH_MAX_BYTES];
+
+// Bulk IN flush policy
+static flush_policy_mode_t flush_mode = FLUSH_POLICY_IMMEDIATE;
+static uint16_t flush_threshold_bytes = 512;
+static uint32_t flush_max_delay_us = 2000;
+static uint32_t unflushed_bytes = 0;
+static uint32_t unflushed_since_us = 0;
+static usb_flush_stats_t flush_stats;
 
 // For delayed reset/bootloader
 static bool pending_reset = false;
@@ -33,6 +72,11 @@ static bool handle_control_read(uint8_t rhport, tusb_control_request_t const *re
 static bool handle_control_write(uint8_t rhport, tusb_control_request_t const *request);
 static bool handle_control_data_stage(tusb_control_request_t const *request, uint8_t const *data, uint16_t len);
 static bool try_send_from_fifo(const char *context);
+static bool send_records_from_fifo(void);
+static bool send_container_from_fifo(void);
+static void note_written(uint32_t nbytes);
+static void flush_now(uint32_t *reason);
+static void flush_if_due(bool buffer_low);
 // ------------------------------------------------------------
 // Vendor OUT protocol (host -> device)
 //  op 0x90: Push override replacement slice
@@ -41,13 +85,93 @@ static bool try_send_from_fifo(const char *context);
 //    - len must equal rule.replace_len
 //  op 0x91: Set injector enable
 //    [0x91][u8 enabled]
+//  op 0x92: Reset stream filter
+//    [0x92][u8 default_dir_mask][u8 flags]
+//    - default_dir_mask: bit0 = ECU, bit1 = VEHICLE (0x03 streams everything, 0x00 = allowlist)
+//    - flags bit0: drop null frames
+//  op 0x93: Set per-ID stream filter rule
+//    [0x93][u16 id][u8 dir_mask][u8 cycle_mask][u8 cycle_base][u8 decimation]
+//  op 0x94: Load frame-ID bitmap into the stream filter
+//    [0x94][u8 dir_mask][u16 first_id][u16 nbytes][nbytes bitmap, LSB = first_id]
+//  op 0x95: Set stream mode (see flexray_stream_codec.h for record kinds)
+//    [0x95][u8 mode][u8 flags][u16 keyframe_interval][u8 cycle_mux_mask]
+//    - mode: 0 = every frame, 1 = changes only, 2 = changes only with DELTA records
+//    - flags bit0: send UNCHANGED ticks for repeated payloads
+//    - flags bit1: container v2 batches with TLV records and in-band events
+//  op 0x96: Set bulk IN flush policy
+//    [0x96][u8 mode][u16 threshold_bytes][u32 max_delay_us]
+//    - mode: 0 = flush immediately, 1 = coalesce until threshold or delay
+//  op 0x97: Set FIFO priority class of a frame ID
+//    [0x97][u16 id][u8 class]  (0 = bulk, 1 = normal, 2 = control; id 0xFFFF resets all)
+//  op 0x98: Set FIFO capacity reserved for higher classes
+//    [0x98][u16 reserve_normal][u16 reserve_control]
+//  op 0x99: Cycle snapshot mode (see flexray_cycle_snapshot.h)
+//    [0x99][u8 enable][u16 last_static_id]
+//  op 0x9A: Push override with a host sequence number (echoed in its acks)
+//    [0x9A][u32 seq][u16 id][u8 base][u16 len][len bytes slice]
+//  op 0x9B: Load a trigger content predicate (see flexray_predicate.h)
+//    [0x9B][u8 rule][u8 n][n x 4 bytes program]  (n = 0 removes it)
+//    - a rejected program is reported as TELEMETRY_ERR_PREDICATE_REJECTED;
+//      a reload that would overwrite the copy core1 is still evaluating is
+//      rejected as busy (arg1 0xFF): resend it
+//  op 0x9C: Set a signal gateway route (see flexray_gateway.h)
+//    [0x9C][u8 index][gateway_route_t, 32 bytes]  (source_dir_mask 0 disables it)
+//    - a rejected route is reported as TELEMETRY_ERR_ROUTE_REJECTED
+//      (arg1 TELEMETRY_ARG_BUSY while core1 uses the copy: resend it)
+//  op 0x9D: Load signal descriptors (see flexray_signals.h)
+//    [0x9D][u8 first_id][u8 n][u16 hold_ms][n x signal_desc_t, 5 bytes]
+//  op 0x9E: Set signal values, applied together
+//    [0x9E][u8 n][n x (u8 signal_id, u32 raw)]  (id | 0x80 releases; n = 0 is a keepalive)
+//    - rejected descriptors and unknown ids are reported as TELEMETRY_ERR_SIGNAL_REJECTED
+//  op 0xA0: Select the E2E profile of an injection rule (see flexray_e2e.h)
+//    [0xA0][u8 rule][e2e_config_t, 28 bytes]
+//    - a rejected configuration is reported as TELEMETRY_ERR_E2E_REJECTED
+//      (arg1 TELEMETRY_ARG_BUSY while core1 uses the copy: resend it)
+//  op 0xA1: Put an injection rule in splice mode (see flexray_splice.h)
+//    [0xA1][u8 rule][u8 enable][u8 offset][u8 len]  (len 0 = host slice and E2E area)
+//    - a rejected window is reported as TELEMETRY_ERR_SPLICE_REJECTED
+//  op 0xA2: Write part of a frame block bitmap (see flexray_frame_id_matcher.h)
+//    [0xA2][u8 direction][u8 first_byte][u8 n][n bytes]  (id = 8 * byte + bit)
+//    - a range outside the bitmap is reported as TELEMETRY_ERR_BLOCK_REJECTED
+//  op 0xA3: Put an injection rule in early trigger mode (see flexray_forwarder_with_injector.h)
+//    [0xA3][u8 rule][u8 enable]
+//    - an unknown rule is reported as TELEMETRY_ERR_EARLY_REJECTED
+//  op 0xA4: Queue wire-encoded replay words (see replay_frame.h)
+//    [0xA4][u8 n][n x u32 words]  (n <= 15, little-endian, MSB is sent first)
+//  op 0xA5: Queue a replay idle run
+//    [0xA5][u32 words]
+//  op 0xA6: Enter (1) or leave (0) replay stream mode
+//    [0xA6][u8 enable]
+//    - words that do not fit the ring are dropped and counted in overflow_words
+//  op 0x9F: Ping, answered with an INTR_MSG_PONG on the interrupt IN endpoint
+//    [0x9F][u32 token]
+//
+//  The interrupt OUT endpoint (panda_usb_intr.h) takes the same encoding but
+//  only ops 0x90, 0x91, 0x9A, 0x9E and 0x9F.
+//
+//  Every override (0x90/0x9A, either endpoint) is acknowledged with an
+//  injector_ack_t: once when it is queued or rejected, and again when it is
+//  applied or superseded. Acks go out as INTR_MSG_OVERRIDE_ACK on the
+//  interrupt IN endpoint and as STREAM_TLV_OVERRIDE_ACK in container v2.
 // ------------------------------------------------------------
-static void handle_vendor_out_payload(const uint8_t *data, uint16_t len)
+static void handle_vendor_out_payload(const uint8_t *data, uint16_t len, uint8_t path)
 {
     uint32_t off = 0;
     while ((uint16_t)(len - off) >= 1) {
         uint8_t op = data[off++];
-        if (op == 0x90) {
+        if (path == INTR_PATH_INTERRUPT && op != 0x90 && op != 0x9A && op != 0x91 && op != 0x9E && op != 0x9F && op != 0x00) {
+            break;
+        }
+        if (op == 0x90 || op == 0x9A) {
+            uint32_t seq = 0;
+            if (op == 0x9A) {
+                if ((uint16_t)(len - off) < 4) {
+                    break;
+                }
+                seq = (uint32_t)data[off] | ((uint32_t)data[off + 1] << 8) |
+                      ((uint32_t)data[off + 2] << 16) | ((uint32_t)data[off + 3] << 24);
+                off += 4;
+            }
             if ((uint16_t)(len - off) < 5) {
                 break;
             }
@@ -58,7 +182,15 @@ static void handle_vendor_out_payload(const uint8_t *data, uint16_t len)
             if ((uint16_t)(len - off) < flen) {
                 break;
             }
-            (void)injector_submit_override(id, base, flen, &data[off]);
+            if (injector_submit_override(id, base, flen, &data[off], seq) != OVERRIDE_QUEUED) {
+                telemetry_error_t err = {
+                    .timestamp_us = time_us_32(),
+                    .code = TELEMETRY_ERR_OVERRIDE_REJECTED,
+                    .arg0 = id,
+                    .arg1 = base,
+                };
+                telemetry_post(STREAM_TLV_ERROR, &err, sizeof(err));
+            }
             off += flen;
         } else if (op == 0x91) {
             if ((uint16_t)(len - off) < 1) {
@@ -66,6 +198,267 @@ static void handle_vendor_out_payload(const uint8_t *data, uint16_t len)
             }
             bool en = data[off++] != 0;
             injector_set_enabled(en);
+        } else if (op == 0x92) {
+            if ((uint16_t)(len - off) < 2) {
+                break;
+            }
+            stream_filter_reset(data[off], data[off + 1]);
+            off += 2;
+        } else if (op == 0x93) {
+            if ((uint16_t)(len - off) < 6) {
+                break;
+            }
+            uint16_t id = (uint16_t)(data[off] | ((uint16_t)data[off + 1] << 8));
+            stream_filter_rule_t rule = {
+                .dir_mask = data[off + 2],
+                .cycle_mask = data[off + 3],
+                .cycle_base = data[off + 4],
+                .decimation = data[off + 5],
+            };
+            (void)stream_filter_set_rule(id, &rule);
+            off += 6;
+        } else if (op == 0x94) {
+            if ((uint16_t)(len - off) < 5) {
+                break;
+            }
+            uint8_t dir_mask = data[off];
+            uint16_t first_id = (uint16_t)(data[off + 1] | ((uint16_t)data[off + 2] << 8));
+            uint16_t nbytes = (uint16_t)(data[off + 3] | ((uint16_t)data[off + 4] << 8));
+            off += 5;
+            if ((uint16_t)(len - off) < nbytes) {
+                break;
+            }
+            stream_filter_load_bitmap(first_id, &data[off], nbytes, dir_mask);
+            off += nbytes;
+        } else if (op == 0x95) {
+            if ((uint16_t)(len - off) < 5) {
+                break;
+            }
+            uint16_t interval = (uint16_t)(data[off + 2] | ((uint16_t)data[off + 3] << 8));
+            stream_codec_set_mode((stream_mode_t)data[off], data[off + 1], interval, data[off + 4]);
+            container_v2 = (data[off + 1] & STREAM_FLAG_CONTAINER_V2) != 0;
+            batch_seq = 0;
+            // Producers on core1 may be mid-post: drain, never re-init
+            telemetry_discard();
+            telemetry_set_enabled(container_v2);
+            off += 5;
+        } else if (op == 0x96) {
+            if ((uint16_t)(len - off) < 7) {
+                break;
+            }
+            uint16_t threshold = (uint16_t)(data[off + 1] | ((uint16_t)data[off + 2] << 8));
+            uint32_t delay_us = (uint32_t)data[off + 3] | ((uint32_t)data[off + 4] << 8) |
+                                ((uint32_t)data[off + 5] << 16) | ((uint32_t)data[off + 6] << 24);
+            panda_usb_set_flush_policy((flush_policy_mode_t)data[off], threshold, delay_us);
+            off += 7;
+        } else if (op == 0x97) {
+            if ((uint16_t)(len - off) < 3) {
+                break;
+            }
+            uint16_t id = (uint16_t)(data[off] | ((uint16_t)data[off + 1] << 8));
+            if (id == 0xFFFF) {
+                qos_reset();
+            } else {
+                (void)qos_set_class(id, (qos_class_t)data[off + 2]);
+            }
+            off += 3;
+        } else if (op == 0x98) {
+            if ((uint16_t)(len - off) < 4) {
+                break;
+            }
+            uint16_t reserve_normal = (uint16_t)(data[off] | ((uint16_t)data[off + 1] << 8));
+            uint16_t reserve_control = (uint16_t)(data[off + 2] | ((uint16_t)data[off + 3] << 8));
+            qos_set_reserve(reserve_normal, reserve_control);
+            off += 4;
+        } else if (op == 0x99) {
+            if ((uint16_t)(len - off) < 3) {
+                break;
+            }
+            uint16_t last_static_id = (uint16_t)(data[off + 1] | ((uint16_t)data[off + 2] << 8));
+            cycle_snapshot_configure(data[off] != 0, last_static_id);
+            off += 3;
+        } else if (op == 0x9B) {
+            if ((uint16_t)(len - off) < 2) {
+                break;
+            }
+            uint8_t rule = data[off];
+            uint8_t n = data[off + 1];
+            uint16_t plen = (uint16_t)(n * sizeof(predicate_insn_t));
+            if ((uint16_t)(len - off - 2) < plen) {
+                break;
+            }
+            int bad = predicate_load(rule, &data[off + 2], n);
+            if (bad >= 0) {
+                telemetry_error_t err = {
+                    .timestamp_us = time_us_32(),
+                    .code = TELEMETRY_ERR_PREDICATE_REJECTED,
+                    .arg0 = rule,
+                    .arg1 = (uint32_t)bad,
+                };
+                telemetry_post(STREAM_TLV_ERROR, &err, sizeof(err));
+            }
+            off += 2u + plen;
+        } else if (op == 0x9C) {
+            if ((uint16_t)(len - off) < 1u + sizeof(gateway_route_t)) {
+                break;
+            }
+            gateway_route_t route;
+            memcpy(&route, &data[off + 1], sizeof(route));
+            gateway_result_t res = gateway_set_route(data[off], &route);
+            if (res != GATEWAY_OK) {
+                telemetry_error_t err = {
+                    .timestamp_us = time_us_32(),
+                    .code = TELEMETRY_ERR_ROUTE_REJECTED,
+                    .arg0 = data[off],
+                    .arg1 = res == GATEWAY_BUSY ? TELEMETRY_ARG_BUSY : route.rule,
+                };
+                telemetry_post(STREAM_TLV_ERROR, &err, sizeof(err));
+            }
+            off += 1u + sizeof(gateway_route_t);
+        } else if (op == 0x9D) {
+            if ((uint16_t)(len - off) < 4) {
+                break;
+            }
+            uint8_t first = data[off];
+            uint8_t n = data[off + 1];
+            uint16_t hold_ms = (uint16_t)(data[off + 2] | ((uint16_t)data[off + 3] << 8));
+            uint16_t dlen = (uint16_t)(n * sizeof(signal_desc_t));
+            if ((uint16_t)(len - off - 4) < dlen) {
+                break;
+            }
+            if (!signals_load_descriptors(first, n, &data[off + 4], hold_ms)) {
+                telemetry_error_t err = {
+                    .timestamp_us = time_us_32(),
+                    .code = TELEMETRY_ERR_SIGNAL_REJECTED,
+                    .arg0 = first,
+                    .arg1 = 0,
+                };
+                telemetry_post(STREAM_TLV_ERROR, &err, sizeof(err));
+            }
+            off += 4u + dlen;
+        } else if (op == 0x9E) {
+            if ((uint16_t)(len - off) < 1) {
+                break;
+            }
+            uint8_t n = data[off];
+            if ((uint16_t)(len - off - 1) < (uint16_t)(n * 5u)) {
+                break;
+            }
+            const uint8_t *p = &data[off + 1];
+            for (uint8_t k = 0; k < n; k++, p += 5) {
+                uint32_t raw = (uint32_t)p[1] | ((uint32_t)p[2] << 8) | ((uint32_t)p[3] << 16) | ((uint32_t)p[4] << 24);
+                if (!signals_set(p[0], raw)) {
+                    telemetry_error_t err = {
+                        .timestamp_us = time_us_32(),
+                        .code = TELEMETRY_ERR_SIGNAL_REJECTED,
+                        .arg0 = p[0],
+                        .arg1 = 1,
+                    };
+                    telemetry_post(STREAM_TLV_ERROR, &err, sizeof(err));
+                }
+            }
+            signals_commit();
+            off += 1u + n * 5u;
+        } else if (op == 0xA0) {
+            if ((uint16_t)(len - off) < 1u + sizeof(e2e_config_t)) {
+                break;
+            }
+            e2e_config_t cfg;
+            memcpy(&cfg, &data[off + 1], sizeof(cfg));
+            e2e_config_result_t res = e2e_configure(data[off], &cfg);
+            if (res != E2E_CONFIG_OK) {
+                telemetry_error_t err = {
+                    .timestamp_us = time_us_32(),
+                    .code = TELEMETRY_ERR_E2E_REJECTED,
+                    .arg0 = data[off],
+                    .arg1 = res == E2E_CONFIG_BUSY ? TELEMETRY_ARG_BUSY : cfg.profile,
+                };
+                telemetry_post(STREAM_TLV_ERROR, &err, sizeof(err));
+            }
+            off += 1u + sizeof(e2e_config_t);
+        } else if (op == 0xA1) {
+            if ((uint16_t)(len - off) < 4) {
+                break;
+            }
+            splice_config_result_t res = splice_configure(data[off], data[off + 1] != 0, data[off + 2], data[off + 3]);
+            if (res != SPLICE_CONFIG_OK) {
+                telemetry_error_t err = {
+                    .timestamp_us = time_us_32(),
+                    .code = TELEMETRY_ERR_SPLICE_REJECTED,
+                    .arg0 = data[off],
+                    .arg1 = res == SPLICE_CONFIG_BUSY ? TELEMETRY_ARG_BUSY : data[off + 3],
+                };
+                telemetry_post(STREAM_TLV_ERROR, &err, sizeof(err));
+            }
+            off += 4;
+        } else if (op == 0xA2) {
+            if ((uint16_t)(len - off) < 3) {
+                break;
+            }
+            uint8_t n = data[off + 2];
+            if ((uint16_t)(len - off) < 3u + n) {
+                break;
+            }
+            if (!matcher_set_block(data[off], data[off + 1], n, &data[off + 3])) {
+                telemetry_error_t err = {
+                    .timestamp_us = time_us_32(),
+                    .code = TELEMETRY_ERR_BLOCK_REJECTED,
+                    .arg0 = data[off],
+                    .arg1 = data[off + 1],
+                };
+                telemetry_post(STREAM_TLV_ERROR, &err, sizeof(err));
+            }
+            off += 3u + n;
+        } else if (op == 0xA3) {
+            if ((uint16_t)(len - off) < 2) {
+                break;
+            }
+            if (!injector_set_early(data[off], data[off + 1] != 0)) {
+                telemetry_error_t err = {
+                    .timestamp_us = time_us_32(),
+                    .code = TELEMETRY_ERR_EARLY_REJECTED,
+                    .arg0 = data[off],
+                    .arg1 = data[off + 1],
+                };
+                telemetry_post(STREAM_TLV_ERROR, &err, sizeof(err));
+            }
+            off += 2;
+        } else if (op == 0xA4) {
+            if ((uint16_t)(len - off) < 1) {
+                break;
+            }
+            uint8_t n = data[off];
+            if ((uint16_t)(len - off) < 1u + 4u * n) {
+                break;
+            }
+            (void)replay_stream_write(&data[off + 1], n);
+            off += 1u + 4u * n;
+        } else if (op == 0xA5) {
+            if ((uint16_t)(len - off) < 4) {
+                break;
+            }
+            (void)replay_stream_idle((uint32_t)data[off] | ((uint32_t)data[off + 1] << 8) |
+                                     ((uint32_t)data[off + 2] << 16) | ((uint32_t)data[off + 3] << 24));
+            off += 4;
+        } else if (op == 0xA6) {
+            if ((uint16_t)(len - off) < 1) {
+                break;
+            }
+            (void)replay_stream_enable(data[off] != 0);
+            off += 1;
+        } else if (op == 0x9F) {
+            if ((uint16_t)(len - off) < 4) {
+                break;
+            }
+            intr_msg_t pong = {
+                .type = INTR_MSG_PONG,
+                .status = path,
+                .token = (uint32_t)data[off] | ((uint32_t)data[off + 1] << 8) |
+                         ((uint32_t)data[off + 2] << 16) | ((uint32_t)data[off + 3] << 24),
+                .timestamp_us = time_us_32(),
+            };
+            panda_usb_intr_post(&pong);
+            off += 4;
         } else if (op == 0x00) {
             continue;
         } else {
@@ -86,6 +479,10 @@ void panda_usb_init(void)
 
     // Initialize FlexRay FIFO
     flexray_fifo_init(&flexray_fifo);
+    stream_codec_init();
+    telemetry_init();
+    qos_reset();
+    panda_usb_set_flush_policy(FLUSH_POLICY_IMMEDIATE, flush_threshold_bytes, flush_max_delay_us);
 
     // Initialize panda state
     panda_state.hw_type = HW_TYPE_RED_PANDA;
@@ -97,9 +494,64 @@ void panda_usb_init(void)
     last_usb_activity = get_absolute_time();
 }
 
+static void forward_override_acks(void)
+{
+    injector_ack_t ack;
+    while (injector_pop_ack(&ack)) {
+        intr_msg_t msg = {
+            .type = INTR_MSG_OVERRIDE_ACK,
+            .status = ack.result,
+            .arg = ack.target_id,
+            .token = ack.seq,
+            .timestamp_us = ack.timestamp_us,
+            .aux = (uint32_t)ack.cycle_count | ((uint32_t)ack.rule << 8),
+        };
+        panda_usb_intr_post(&msg);
+        telemetry_post(STREAM_TLV_OVERRIDE_ACK, &ack, sizeof(ack));
+    }
+}
+
 void panda_usb_task(void)
 {
     tud_task();
+    forward_override_acks();
+    panda_usb_intr_task();
+    // Drain what the push path left behind (TX buffer was full, or a sealed
+    // cycle snapshot), so the last frame on a quiet bus is not stranded
+    try_send_from_fifo("task");
+    // Coalesced data whose max delay expired while the bus was quiet
+    flush_if_due(false);
+}
+
+void panda_usb_set_flush_policy(flush_policy_mode_t mode, uint16_t threshold_bytes, uint32_t max_delay_us)
+{
+    // Push out whatever the previous policy was holding
+    if (unflushed_bytes > 0)
+    {
+        flush_now(NULL);
+    }
+    flush_mode = (mode == FLUSH_POLICY_COALESCE) ? mode : FLUSH_POLICY_IMMEDIATE;
+    flush_threshold_bytes = threshold_bytes;
+    flush_max_delay_us = max_delay_us;
+    memset(&flush_stats, 0, sizeof(flush_stats));
+    flush_stats.mode = flush_mode;
+    flush_stats.since_us = time_us_32();
+}
+
+void panda_usb_get_flush_stats(usb_flush_stats_t *out)
+{
+    *out = flush_stats;
+}
+
+bool panda_usb_flush_deadline(absolute_time_t *deadline)
+{
+    if (unflushed_bytes == 0)
+    {
+        return false;
+    }
+    uint32_t elapsed = time_us_32() - unflushed_since_us;
+    *deadline = make_timeout_time_us(elapsed < flush_max_delay_us ? flush_max_delay_us - elapsed : 0);
+    return true;
 }
 
 // TinyUSB vendor control transfer callback - this overrides the weak default implementation
@@ -286,8 +738,170 @@ static bool handle_control_read(uint8_t rhport, tusb_control_request_t const *re
         // printf("Control Read: PANDA_UART_READ\n");
         break;
 
+    case FLEXRAY_READ_LOG:
+        {
+            // Header [u32 dropped][u16 count][u8 record_size][u8 reserved] + records
+            static uint8_t log_response[8 + 32 * sizeof(flexray_log_record_t)];
+            uint16_t cap = request->wLength < sizeof(log_response) ? request->wLength : (uint16_t)sizeof(log_response);
+            uint16_t count = 0;
+            uint16_t w = 8;
+            flexray_log_record_t rec;
+            while ((uint16_t)(w + sizeof(rec)) <= cap && flexray_log_pop(&rec)) {
+                memcpy(&log_response[w], &rec, sizeof(rec));
+                w = (uint16_t)(w + sizeof(rec));
+                count++;
+            }
+            uint32_t dropped = flexray_log_dropped();
+            memcpy(&log_response[0], &dropped, sizeof(dropped));
+            memcpy(&log_response[4], &count, sizeof(count));
+            log_response[6] = (uint8_t)sizeof(flexray_log_record_t);
+            log_response[7] = 0;
+            return tud_control_xfer(rhport, request, log_response, w);
+        }
+
+    case FLEXRAY_READ_FRAME_TABLE:
+        {
+            // wValue/wIndex: low/high half of since_seq, see flexray_frame_table.h
+            static uint8_t table_response[2048];
+            uint32_t since_seq = (uint32_t)request->wValue | ((uint32_t)request->wIndex << 16);
+            uint16_t cap = request->wLength < sizeof(table_response) ? request->wLength : (uint16_t)sizeof(table_response);
+            uint16_t n = frame_table_read(since_seq, table_response, cap);
+            return tud_control_xfer(rhport, request, table_response, n);
+        }
+
+    case FLEXRAY_READ_ID_STATS:
+        {
+            // wValue: first entry index, see flexray_id_stats.h
+            static uint8_t id_stats_response[2048];
+            uint16_t cap = request->wLength < sizeof(id_stats_response) ? request->wLength : (uint16_t)sizeof(id_stats_response);
+            uint16_t n = id_stats_read(request->wValue, id_stats_response, cap);
+            return tud_control_xfer(rhport, request, id_stats_response, n);
+        }
+
+    case FLEXRAY_READ_SCHEDULE:
+        {
+            // wValue: first entry index, see flexray_schedule.h
+            static uint8_t schedule_response[2048];
+            uint16_t cap = request->wLength < sizeof(schedule_response) ? request->wLength : (uint16_t)sizeof(schedule_response);
+            uint16_t n = schedule_read(request->wValue, schedule_response, cap);
+            return tud_control_xfer(rhport, request, schedule_response, n);
+        }
+
+    case FLEXRAY_READ_TRIGGER_TUNING:
+        {
+            // See flexray_trigger_tuner.h
+            static uint8_t tuning_response[512];
+            uint16_t cap = request->wLength < sizeof(tuning_response) ? request->wLength : (uint16_t)sizeof(tuning_response);
+            uint16_t n = trigger_tuner_read(tuning_response, cap);
+            return tud_control_xfer(rhport, request, tuning_response, n);
+        }
+
+    case FLEXRAY_READ_TIMED_INJECTION:
+        {
+            // See flexray_timed_injection.h
+            static uint8_t timed_response[512];
+            uint16_t cap = request->wLength < sizeof(timed_response) ? request->wLength : (uint16_t)sizeof(timed_response);
+            uint16_t n = timed_injection_read(timed_response, cap);
+            return tud_control_xfer(rhport, request, timed_response, n);
+        }
+
+    case FLEXRAY_READ_TIMEBASE:
+        {
+            // timebase_status_t then timebase_model_t, see flexray_timebase.h
+            static struct __attribute__((packed)) {
+                timebase_status_t status;
+                timebase_model_t model;
+            } timebase_response;
+            timebase_get_status(&timebase_response.status);
+            timebase_get_model(&timebase_response.model);
+            uint16_t n = request->wLength < sizeof(timebase_response) ? request->wLength : (uint16_t)sizeof(timebase_response);
+            return tud_control_xfer(rhport, request, &timebase_response, n);
+        }
+
+    case FLEXRAY_READ_PREDICATE_STATS:
+        {
+            // predicate_stats_t per rule, see flexray_predicate.h
+            static uint8_t predicate_response[256];
+            uint16_t cap = request->wLength < sizeof(predicate_response) ? request->wLength : (uint16_t)sizeof(predicate_response);
+            uint16_t n = predicate_read_stats(predicate_response, cap);
+            return tud_control_xfer(rhport, request, predicate_response, n);
+        }
+
+    case FLEXRAY_READ_GATEWAY:
+        {
+            // gateway_stats_t per route, see flexray_gateway.h
+            static uint8_t gateway_response[GATEWAY_MAX_ROUTES * sizeof(gateway_stats_t)];
+            uint16_t cap = request->wLength < sizeof(gateway_response) ? request->wLength : (uint16_t)sizeof(gateway_response);
+            uint16_t n = gateway_read_stats(gateway_response, cap);
+            return tud_control_xfer(rhport, request, gateway_response, n);
+        }
+
+    case FLEXRAY_READ_SIGNALS:
+        {
+            // signals_header_t then signal_state_t per signal, see flexray_signals.h
+            static uint8_t signals_response[sizeof(signals_header_t) + SIGNALS_MAX * sizeof(signal_state_t)];
+            uint16_t cap = request->wLength < sizeof(signals_response) ? request->wLength : (uint16_t)sizeof(signals_response);
+            uint16_t n = signals_read(signals_response, cap);
+            return tud_control_xfer(rhport, request, signals_response, n);
+        }
+
+    case FLEXRAY_READ_E2E:
+        {
+            // e2e_config_t per rule, see flexray_e2e.h
+            static uint8_t e2e_response[256];
+            uint16_t cap = request->wLength < sizeof(e2e_response) ? request->wLength : (uint16_t)sizeof(e2e_response);
+            uint16_t n = e2e_read(e2e_response, cap);
+            return tud_control_xfer(rhport, request, e2e_response, n);
+        }
+
+    case FLEXRAY_READ_SPLICE:
+        {
+            // splice_state_t per rule, see flexray_splice.h
+            static uint8_t splice_response[256];
+            uint16_t cap = request->wLength < sizeof(splice_response) ? request->wLength : (uint16_t)sizeof(splice_response);
+            uint16_t n = splice_read(splice_response, cap);
+            return tud_control_xfer(rhport, request, splice_response, n);
+        }
+
+    case FLEXRAY_READ_BLOCK:
+        {
+            // matcher_block_stats_t, then the TO_ECU and TO_VEHICLE bitmaps
+            static uint8_t block_response[sizeof(matcher_block_stats_t) + 2u * MATCHER_BITMAP_BYTES];
+            uint16_t cap = request->wLength < sizeof(block_response) ? request->wLength : (uint16_t)sizeof(block_response);
+            uint16_t n = matcher_block_read(block_response, cap);
+            return tud_control_xfer(rhport, request, block_response, n);
+        }
+
+    case FLEXRAY_READ_EARLY_TRIGGER:
+        {
+            // injector_early_stats_t per rule, see flexray_forwarder_with_injector.h
+            static uint8_t early_response[256];
+            uint16_t cap = request->wLength < sizeof(early_response) ? request->wLength : (uint16_t)sizeof(early_response);
+            uint16_t n = injector_early_read(early_response, cap);
+            return tud_control_xfer(rhport, request, early_response, n);
+        }
+
+    case FLEXRAY_READ_REPLAY:
+        {
+            // replay_stream_stats_t, see replay_frame.h
+            static uint8_t replay_response[sizeof(replay_stream_stats_t)];
+            uint16_t cap = request->wLength < sizeof(replay_response) ? request->wLength : (uint16_t)sizeof(replay_response);
+            uint16_t n = replay_stream_read(replay_response, cap);
+            return tud_control_xfer(rhport, request, replay_response, n);
+        }
+
+#if FLEXRAY_PROFILE
+    case FLEXRAY_GET_PROFILE_STATS:
+        {
+            // Larger than EP0, so it must outlive this call: use a static snapshot
+            static profile_stats_block_t profile_response;
+            profile_snapshot(&profile_response);
+            return tud_control_xfer(rhport, request, &profile_response, sizeof(profile_response));
+        }
+#endif
+
     default:
-        printf("Control Read: Unknown request 0x%02x\n", request->bRequest);
+        FLOG1(LOG_CTRL_READ_UNKNOWN, request->bRequest);
         return false;
     }
 
@@ -309,6 +923,9 @@ static bool handle_control_write(uint8_t rhport, tusb_control_request_t const *r
     case PANDA_RESET_CAN_COMMS:
         // printf("Control Write: RESET_CAN_COMMS (request=0x%02x)\n", request->bRequest);
         flexray_fifo_init(&flexray_fifo);
+        fifo_popped = fifo_pushed; // dropped frames no longer hold snapshots back
+        stream_codec_reset_history();
+        FLOG0(LOG_FIFO_RESET);
         handled = true;
         break;
 
@@ -379,8 +996,64 @@ static bool handle_control_write(uint8_t rhport, tusb_control_request_t const *r
         handled = true;
         break;
 
+    case FLEXRAY_SET_LOG_SINK:
+        // wValue: 0 = UART pump, 1 = host reads via FLEXRAY_READ_LOG
+        flexray_log_set_sink(request->wValue ? LOG_SINK_USB : LOG_SINK_UART);
+        handled = true;
+        break;
+
+    case FLEXRAY_RESET_FRAME_TABLE:
+        // wValue: cycle_count bits that are part of the key (0x3F = every cycle apart)
+        frame_table_reset((uint8_t)request->wValue);
+        handled = true;
+        break;
+
+    case FLEXRAY_RESET_ID_STATS:
+        id_stats_reset();
+        handled = true;
+        break;
+
+    case FLEXRAY_RESET_SCHEDULE:
+        schedule_reset();
+        handled = true;
+        break;
+
+    case FLEXRAY_SET_TRIGGER_TUNING:
+        // wValue: TUNER_MODE_*, wIndex: margin in us (0 = default, at most 255; stalls otherwise)
+        if (request->wIndex > UINT8_MAX)
+        {
+            break;
+        }
+        trigger_tuner_configure((uint8_t)request->wValue, (uint8_t)request->wIndex);
+        handled = true;
+        break;
+
+    case FLEXRAY_SET_TIMED_INJECTION:
+        // wValue: rule index, wIndex: lead in us before the slot (0 = frame-triggered)
+        timed_injection_configure((uint8_t)request->wValue, request->wIndex);
+        handled = true;
+        break;
+
+    case FLEXRAY_SET_TIMEBASE:
+        // wValue: nominal macrotick in ns (0 = 1000); restarts acquisition
+        timebase_set_nominal_macrotick(request->wValue);
+        handled = true;
+        break;
+
+    case FLEXRAY_RESET_PREDICATE_STATS:
+        predicate_reset_stats();
+        handled = true;
+        break;
+
+#if FLEXRAY_PROFILE
+    case FLEXRAY_RESET_PROFILE_STATS:
+        profile_reset();
+        handled = true;
+        break;
+#endif
+
     default:
-        printf("Control Write: Unknown request 0x%02x\n", request->bRequest);
+        FLOG1(LOG_CTRL_WRITE_UNKNOWN, request->bRequest);
         return false;
     }
 
@@ -398,7 +1071,7 @@ static bool handle_control_data_stage(tusb_control_request_t const *request, uin
     switch (request->bRequest)
     {
     case PANDA_SET_CAN_FD_AUTO_SWITCH:
-        printf("Control Data: SET_CAN_FD_AUTO_SWITCH -> %d\n", request->wValue);
+        FLOG1(LOG_CTRL_FD_AUTO_SWITCH, request->wValue);
         return true;
 
     case PANDA_SET_CAN_SPEED_KBPS:
@@ -409,16 +1082,16 @@ static bool handle_control_data_stage(tusb_control_request_t const *request, uin
 
             if (bus_id < 3) // We support up to 3 CAN buses
             {
-                printf("Control Data: SET_CAN_SPEED_KBPS bus=%d speed=%d kbps\n", bus_id, speed_kbps);
+                FLOG2(LOG_CTRL_CAN_SPEED, bus_id, speed_kbps);
             }
             else
             {
-                printf("Control Data: SET_CAN_SPEED_KBPS invalid bus_id=%d\n", bus_id);
+                FLOG1(LOG_CTRL_CAN_SPEED_BUS, bus_id);
             }
         }
         else
         {
-            printf("Control Data: SET_CAN_SPEED_KBPS insufficient data (got %d bytes)\n", len);
+            FLOG1(LOG_CTRL_CAN_SPEED_LEN, len);
         }
         return true;
 
@@ -430,21 +1103,21 @@ static bool handle_control_data_stage(tusb_control_request_t const *request, uin
 
             if (bus_id < 3) // We support up to 3 CAN buses
             {
-                printf("Control Data: SET_CAN_FD_DATA_BITRATE bus=%d data_speed=%d kbps\n", bus_id, data_speed_kbps);
+                FLOG2(LOG_CTRL_FD_BITRATE, bus_id, data_speed_kbps);
             }
             else
             {
-                printf("Control Data: SET_CAN_FD_DATA_BITRATE invalid bus_id=%d\n", bus_id);
+                FLOG1(LOG_CTRL_FD_BITRATE_BUS, bus_id);
             }
         }
         else
         {
-            printf("Control Data: SET_CAN_FD_DATA_BITRATE insufficient data (got %d bytes)\n", len);
+            FLOG1(LOG_CTRL_FD_BITRATE_LEN, len);
         }
         return true;
 
     default:
-        printf("Control Data: Unexpected request 0x%02x with %d bytes\n", request->bRequest, len);
+        FLOG2(LOG_CTRL_DATA_UNKNOWN, request->bRequest, len);
         return false;
     }
 }
@@ -456,33 +1129,34 @@ static bool handle_control_data_stage(tusb_control_request_t const *request, uin
 // Invoked when device is mounted
 void tud_mount_cb(void)
 {
-    printf("USB Device mounted\n");
+    FLOG0(LOG_USB_MOUNTED);
     last_usb_activity = get_absolute_time();
 }
 
 // Invoked when device is unmounted
 void tud_umount_cb(void)
 {
-    printf("USB Device unmounted - clearing application state\n");
-
     // Reset control transfer state - not strictly needed with new design but good practice
     // Reset application state but keep device configuration
     // Don't reset panda_state entirely as it may contain valid configuration
 
-    printf("USB unmount completed - ready for reconnection\n");
+    // Nothing held back can reach the host any more
+    unflushed_bytes = 0;
+
+    FLOG0(LOG_USB_UNMOUNTED);
 }
 
 // Invoked when usb bus is suspended
 void tud_suspend_cb(bool remote_wakeup_en)
 {
     (void)remote_wakeup_en;
-    printf("USB Device suspended\n");
+    FLOG0(LOG_USB_SUSPENDED);
 }
 
 // Invoked when usb bus is resumed
 void tud_resume_cb(void)
 {
-    printf("USB Device resumed\n");
+    FLOG0(LOG_USB_RESUMED);
 }
 
 //--------------------------------------------------------------------+
@@ -495,18 +1169,24 @@ void tud_vendor_rx_cb(uint8_t itf, uint8_t const *buffer, uint16_t bufsize)
     (void)itf;
     if (bufsize > 0)
     {
-        handle_vendor_out_payload(buffer, bufsize);
+        handle_vendor_out_payload(buffer, bufsize, INTR_PATH_BULK);
     }
     // Drain any additional data queued by USB core
     while (tud_vendor_available()) {
         uint8_t tmp[256];
         uint32_t n = tud_vendor_read(tmp, sizeof(tmp));
         if (n == 0) break;
-        handle_vendor_out_payload(tmp, (uint16_t)n);
+        handle_vendor_out_payload(tmp, (uint16_t)n, INTR_PATH_BULK);
     }
     last_usb_activity = get_absolute_time();
 }
 
+void panda_usb_handle_intr_out(const uint8_t *data, uint16_t len)
+{
+    handle_vendor_out_payload(data, len, INTR_PATH_INTERRUPT);
+    last_usb_activity = get_absolute_time();
+}
+
 // Invoked when a transfer on Bulk IN endpoint is complete
 void tud_vendor_tx_cb(uint8_t itf, uint32_t sent_bytes)
 {
@@ -519,33 +1199,87 @@ void tud_vendor_tx_cb(uint8_t itf, uint32_t sent_bytes)
 
 bool panda_flexray_fifo_push(const flexray_frame_t *frame)
 {
+    // Before the push to make room, after it so this frame goes out now
+    // rather than with the next one
     try_send_from_fifo("fifo_push");
-    return flexray_fifo_push(&flexray_fifo, frame);
+    bool queued = flexray_fifo_push_limited(&flexray_fifo, frame,
+                                            qos_fill_limit(frame->frame_id, FLEXRAY_FIFO_CAPACITY));
+    qos_account(frame->frame_id, queued);
+    if (queued)
+    {
+        fifo_pushed++;
+    }
+    try_send_from_fifo("fifo_push");
+    return queued;
+}
+
+uint32_t panda_flexray_fifo_count(void)
+{
+    return flexray_fifo_count(&flexray_fifo);
+}
+
+uint32_t panda_flexray_fifo_pushed(void)
+{
+    return fifo_pushed;
+}
+
+// Oldest sealed snapshot once every frame queued before it has been sent,
+// else 0 so the frames go out first
+static uint16_t snapshot_due(const uint8_t **record)
+{
+    uint32_t mark;
+    uint16_t len = cycle_snapshot_peek(record, &mark);
+    if (len != 0 && (int32_t)(fifo_popped - mark) < 0)
+    {
+        return 0;
+    }
+    return len;
 }
 
 // Centralized function to trigger USB transmission from FIFO
 static bool try_send_from_fifo(const char *context)
 {
     (void)context;
-    if (!tud_vendor_mounted() || flexray_fifo_is_empty(&flexray_fifo))
+    PROFILE_BEGIN(send_start);
+    bool sent = container_v2 ? send_container_from_fifo() : send_records_from_fifo();
+    PROFILE_END(PROFILE_TRY_SEND_FROM_FIFO, send_start);
+    return sent;
+}
+
+static bool send_records_from_fifo(void)
+{
+    const uint8_t *snapshot;
+    uint32_t mark;
+    if (!tud_vendor_mounted() || (flexray_fifo_is_empty(&flexray_fifo) && cycle_snapshot_peek(&snapshot, &mark) == 0))
     {
         return false;
     }
 
-    // Minimum record: 2-byte length + 1-byte source + 5-byte header + 0 payload + 3-byte CRC = 11 bytes
-    const uint32_t MIN_RECORD_SIZE = 11u;
-
     uint32_t available_space = tud_vendor_write_available();
-    if (available_space < MIN_RECORD_SIZE)
+    if (available_space < STREAM_RECORD_MIN_BYTES)
     {
         return false;
     }
 
-    uint32_t total_sent = 0;
     bool sent_something = false;
 
-    while (!flexray_fifo_is_empty(&flexray_fifo))
+    while (true)
     {
+        // Sealed cycle snapshots are already complete records
+        uint16_t snapshot_len = snapshot_due(&snapshot);
+        if (snapshot_len != 0)
+        {
+            if (available_space < snapshot_len || tud_vendor_write(snapshot, snapshot_len) != snapshot_len)
+            {
+                break;
+            }
+            cycle_snapshot_release();
+            sent_something = true;
+            note_written(snapshot_len);
+            available_space = tud_vendor_write_available();
+            continue;
+        }
+
         flexray_frame_t frame;
         // Peek first to preserve order in case we cannot send now
         if (!flexray_fifo_peek(&flexray_fifo, &frame))
@@ -553,71 +1287,213 @@ static bool try_send_from_fifo(const char *context)
             break;
         }
 
-        uint16_t payload_len_bytes = (uint16_t)(frame.payload_length_words * 2u);
-        uint16_t body_len = (uint16_t)(1u /*source*/ + 5u /*header*/ + payload_len_bytes + 3u /*crc*/);
-        uint16_t total_len = (uint16_t)(2u /*len field*/ + body_len);
+        // Build record into a small stack buffer and write once
+        uint8_t outbuf[STREAM_RECORD_MAX_BYTES];
+        stream_codec_pending_t pending;
+        PROFILE_BEGIN(encode_start);
+        uint16_t w = stream_codec_encode(&frame, outbuf, &pending);
+        PROFILE_END(PROFILE_STREAM_CODEC_ENCODE, encode_start);
 
-        if (available_space < total_len)
+        if (available_space < w)
         {
             // Not enough space for the head frame; stop and retry later
             break;
         }
 
-        // Build record into a small stack buffer and write once
-        uint8_t outbuf[2 + 1 + 5 + MAX_FRAME_PAYLOAD_BYTES + 3];
-        outbuf[0] = (uint8_t)(body_len & 0xFF);
-        outbuf[1] = (uint8_t)((body_len >> 8) & 0xFF);
-        size_t w = 2;
-        outbuf[w++] = frame.source;
-
-        // Reconstruct 5-byte header
-        uint8_t byte0 = (uint8_t)((frame.indicators << 3) | ((frame.frame_id >> 8) & 0x07));
-        uint8_t byte1 = (uint8_t)(frame.frame_id & 0xFF);
-        uint8_t byte2 = (uint8_t)((frame.payload_length_words << 1) | ((frame.header_crc >> 10) & 0x01));
-        uint8_t byte3 = (uint8_t)((frame.header_crc >> 2) & 0xFF);
-        uint8_t byte4 = (uint8_t)(((frame.header_crc & 0x03) << 6) | (frame.cycle_count & 0x3F));
-        outbuf[w++] = byte0;
-        outbuf[w++] = byte1;
-        outbuf[w++] = byte2;
-        outbuf[w++] = byte3;
-        outbuf[w++] = byte4;
-
-        // Payload (only used portion)
-        if (payload_len_bytes > 0)
-        {
-            memcpy(&outbuf[w], frame.payload, payload_len_bytes);
-            w += payload_len_bytes;
-        }
-
-        // 24-bit CRC big-endian
-        outbuf[w++] = (uint8_t)((frame.frame_crc >> 16) & 0xFF);
-        outbuf[w++] = (uint8_t)((frame.frame_crc >> 8) & 0xFF);
-        outbuf[w++] = (uint8_t)(frame.frame_crc & 0xFF);
-
-        // Write
-        uint32_t written = tud_vendor_write(outbuf, (uint32_t)w);
-        if (written != w)
-        {
-            // On partial write, stop loop; data will be retried next call
-            break;
+        if (w > 0)
+        {
+            uint32_t written = tud_vendor_write(outbuf, w);
+            if (written != w)
+            {
+                // On partial write, stop loop; data will be retried next call
+                break;
+            }
+            sent_something = true;
+            note_written(w);
+            available_space = tud_vendor_write_available();
         }
         // Now we can safely pop the frame since it has been fully queued to USB
         (void)flexray_fifo_pop(&flexray_fifo, &frame);
-        sent_something = true;
-        total_sent += written;
-        available_space = tud_vendor_write_available();
+        fifo_popped++;
+        stream_codec_commit(&pending);
 
         // If buffer space drops low, flush early to free FIFO in USB core
-        if (available_space < MIN_RECORD_SIZE)
+        if (available_space < STREAM_RECORD_MIN_BYTES)
         {
             break;
         }
     }
 
-    if (sent_something)
+    flush_if_due(available_space < STREAM_RECORD_MIN_BYTES);
+    return sent_something;
+}
+
+// Container v2: one header plus as many whole TLV records as fit in the
+// space TinyUSB can take right now. The batch is sized to that space, so the
+// single write below cannot be partial and records are committed as they are
+// added.
+static bool send_container_from_fifo(void)
+{
+    if (!tud_vendor_mounted())
     {
-        tud_vendor_write_flush();
-        return true;
+        return false;
     }
-    return false;
-}
\ No newline at end of file
+    const uint8_t *snapshot;
+    uint32_t mark;
+    if (flexray_fifo_is_empty(&flexray_fifo) && telemetry_peek_len() == 0 &&
+        cycle_snapshot_peek(&snapshot, &mark) == 0)
+    {
+        return false;
+    }
+
+    uint32_t cap = tud_vendor_write_available();
+    if (cap > sizeof(batch_buf))
+    {
+        cap = sizeof(batch_buf);
+    }
+    const uint32_t header_len = sizeof(stream_batch_header_t);
+    if (cap < header_len + STREAM_TLV_HEADER_BYTES + TELEMETRY_MAX_VALUE)
+    {
+        return false;
+    }
+
+    uint32_t w = header_len;
+
+    // Events first: they are rare and describe what happened to the frames
+    uint8_t ev_len;
+    while ((ev_len = telemetry_peek_len()) != 0 && w + STREAM_TLV_HEADER_BYTES + ev_len <= cap)
+    {
+        uint8_t ev_type;
+        if (!telemetry_pop(&ev_type, &batch_buf[w + STREAM_TLV_HEADER_BYTES], &ev_len))
+        {
+            break;
+        }
+        batch_buf[w] = ev_type;
+        batch_buf[w + 1] = ev_len;
+        batch_buf[w + 2] = 0;
+        w += STREAM_TLV_HEADER_BYTES + ev_len;
+    }
+
+    // A codec record is [u16 len][body], i.e. a TLV minus its type byte;
+    // cycle snapshots use the same record framing and go out in seal order
+    // among the frames
+    while (true)
+    {
+        uint16_t snapshot_len = snapshot_due(&snapshot);
+        if (snapshot_len != 0)
+        {
+            if (w + 1u + snapshot_len > cap)
+            {
+                break;
+            }
+            batch_buf[w++] = STREAM_TLV_FRAME;
+            memcpy(&batch_buf[w], snapshot, snapshot_len);
+            w += snapshot_len;
+            cycle_snapshot_release();
+            continue;
+        }
+
+        flexray_frame_t frame;
+        if (!flexray_fifo_peek(&flexray_fifo, &frame))
+        {
+            break;
+        }
+
+        uint8_t outbuf[STREAM_RECORD_MAX_BYTES];
+        stream_codec_pending_t pending;
+        PROFILE_BEGIN(encode_start);
+        uint16_t rec_len = stream_codec_encode(&frame, outbuf, &pending);
+        PROFILE_END(PROFILE_STREAM_CODEC_ENCODE, encode_start);
+
+        if (rec_len > 0)
+        {
+            if (w + 1u + rec_len > cap)
+            {
+                break;
+            }
+            batch_buf[w++] = STREAM_TLV_FRAME;
+            memcpy(&batch_buf[w], outbuf, rec_len);
+            w += rec_len;
+        }
+        (void)flexray_fifo_pop(&flexray_fifo, &frame);
+        fifo_popped++;
+        stream_codec_commit(&pending);
+    }
+
+    if (w == header_len)
+    {
+        return false;
+    }
+
+    fifo_stats_t fs;
+    flexray_fifo_get_stats(&flexray_fifo, &fs);
+    stream_batch_header_t hdr = {
+        .magic = STREAM_BATCH_MAGIC,
+        .version = STREAM_BATCH_VERSION,
+        .batch_len = (uint16_t)w,
+        .seq = batch_seq++,
+        .timestamp_us = time_us_32(),
+        .fifo_dropped = fs.frames_dropped,
+        .notify_dropped = notify_queue_dropped(),
+        .event_dropped = telemetry_dropped(),
+    };
+    memcpy(batch_buf, &hdr, header_len);
+
+    (void)tud_vendor_write(batch_buf, w);
+    note_written(w);
+    flush_if_due(tud_vendor_write_available() < sizeof(stream_batch_header_t) + STREAM_TLV_HEADER_BYTES + TELEMETRY_MAX_VALUE);
+    return true;
+}
+
+static void note_written(uint32_t nbytes)
+{
+    if (unflushed_bytes == 0)
+    {
+        unflushed_since_us = time_us_32();
+    }
+    unflushed_bytes += nbytes;
+}
+
+static void flush_now(uint32_t *reason)
+{
+    uint32_t hold_us = time_us_32() - unflushed_since_us;
+    tud_vendor_write_flush();
+    flush_stats.flushes++;
+    if (reason != NULL)
+    {
+        (*reason)++;
+    }
+    flush_stats.bytes += unflushed_bytes;
+    flush_stats.hold_us_total += hold_us;
+    if (hold_us > flush_stats.hold_us_max)
+    {
+        flush_stats.hold_us_max = hold_us;
+    }
+    unflushed_bytes = 0;
+}
+
+// Immediate mode flushes every send pass. Coalesce mode waits for the byte
+// threshold or the max delay, but never sits on a nearly full TX buffer.
+static void flush_if_due(bool buffer_low)
+{
+    if (unflushed_bytes == 0 || !tud_vendor_mounted())
+    {
+        return;
+    }
+    if (flush_mode == FLUSH_POLICY_IMMEDIATE)
+    {
+        flush_now(NULL);
+    }
+    else if (buffer_low)
+    {
+        flush_now(&flush_stats.flush_full);
+    }
+    else if (unflushed_bytes >= flush_threshold_bytes)
+    {
+        flush_now(&flush_stats.flush_threshold);
+    }
+    else if ((uint32_t)(time_us_32() - unflushed_since_us) >= flush_max_delay_us)
+    {
+        flush_now(&flush_stats.flush_timer);
+    }
+}
@@ -45,6 +45,33 @@
 #define PANDA_SET_CAN_FD_DATA_BITRATE   0xf9
 #define PANDA_SET_CAN_FD_NON_ISO_MODE   0xfc
 
+// pico-flexray vendor extensions (not part of the panda protocol)
+#define FLEXRAY_GET_PROFILE_STATS       0x60
+#define FLEXRAY_RESET_PROFILE_STATS     0x61
+#define FLEXRAY_READ_LOG                0x62
+#define FLEXRAY_SET_LOG_SINK            0x63
+#define FLEXRAY_READ_FRAME_TABLE        0x64
+#define FLEXRAY_RESET_FRAME_TABLE       0x65
+#define FLEXRAY_READ_ID_STATS           0x66
+#define FLEXRAY_RESET_ID_STATS          0x67
+#define FLEXRAY_READ_SCHEDULE           0x68
+#define FLEXRAY_RESET_SCHEDULE          0x69
+#define FLEXRAY_READ_TRIGGER_TUNING     0x6A
+#define FLEXRAY_SET_TRIGGER_TUNING      0x6B
+#define FLEXRAY_READ_TIMED_INJECTION    0x6C
+#define FLEXRAY_SET_TIMED_INJECTION     0x6D
+#define FLEXRAY_READ_TIMEBASE           0x6E
+#define FLEXRAY_SET_TIMEBASE            0x6F
+#define FLEXRAY_READ_PREDICATE_STATS    0x70
+#define FLEXRAY_RESET_PREDICATE_STATS   0x71
+#define FLEXRAY_READ_GATEWAY            0x72
+#define FLEXRAY_READ_SIGNALS            0x73
+#define FLEXRAY_READ_E2E                0x74
+#define FLEXRAY_READ_SPLICE             0x75
+#define FLEXRAY_READ_BLOCK              0x76
+#define FLEXRAY_READ_EARLY_TRIGGER      0x77
+#define FLEXRAY_READ_REPLAY             0x78
+
 // Hardware types
 #define HW_TYPE_UNKNOWN             0
 #define HW_TYPE_WHITE_PANDA         1
@@ -128,7 +155,36 @@ struct __attribute__((packed)) can_health_t {
 void panda_usb_init(void);
 void panda_usb_task(void);
 
+// Bulk IN flush policy (op 0x96)
+typedef enum {
+    FLUSH_POLICY_IMMEDIATE = 0, // flush after every send pass (lowest latency)
+    FLUSH_POLICY_COALESCE = 1,  // hold until threshold_bytes or max_delay_us
+} flush_policy_mode_t;
+
+typedef struct {
+    uint32_t mode;
+    uint32_t flushes;
+    uint32_t flush_threshold;   // coalesce: byte threshold reached
+    uint32_t flush_timer;       // coalesce: max delay expired
+    uint32_t flush_full;        // TinyUSB TX buffer nearly full
+    uint32_t bytes;
+    uint32_t hold_us_max;       // first unflushed byte -> flush
+    uint64_t hold_us_total;
+    uint32_t since_us;          // stats start, for throughput
+} usb_flush_stats_t;
+
+void panda_usb_set_flush_policy(flush_policy_mode_t mode, uint16_t threshold_bytes, uint32_t max_delay_us);
+void panda_usb_get_flush_stats(usb_flush_stats_t *out);
+// True while coalesced data is waiting; deadline is when it must go out
+bool panda_usb_flush_deadline(absolute_time_t *deadline);
+
+// Ops received on the interrupt OUT endpoint (panda_usb_intr.c)
+void panda_usb_handle_intr_out(const uint8_t *data, uint16_t len);
+
 // FIFO management - now exposed for external use (e.g., main.c)
 bool panda_flexray_fifo_push(const flexray_frame_t *frame);
+uint32_t panda_flexray_fifo_count(void);
+// Frames queued since boot; cycle snapshots seal against this mark
+uint32_t panda_flexray_fifo_pushed(void);
 
 #endif /* PANDA_USB_H_ */
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "panda_usb_intr.h"
+#include <string.h>
+#include "tusb.h"
+#include "device/usbd_pvt.h"
+#include "panda_usb.h"
+
+// Registered with TinyUSB as an application class driver. Drivers from
+// usbd_app_driver_get_cb() are offered each interface first; this one only
+// claims a vendor interface whose endpoints are interrupt, so the bulk
+// interface still goes to the built-in vendor driver.
+
+#define INTR_EP_SIZE      64u
+#define INTR_MSGS_PER_PKT (INTR_EP_SIZE / sizeof(intr_msg_t))
+#define INTR_QUEUE_SIZE   32u // power of two
+#define INTR_QUEUE_MASK   (INTR_QUEUE_SIZE - 1u)
+
+static uint8_t intr_rhport = 0;
+static uint8_t ep_out = 0;
+static uint8_t ep_in = 0;
+TU_ATTR_ALIGNED(4) static uint8_t out_buf[INTR_EP_SIZE];
+TU_ATTR_ALIGNED(4) static uint8_t in_buf[INTR_EP_SIZE];
+
+static intr_msg_t msg_queue[INTR_QUEUE_SIZE];
+static uint32_t msg_head = 0;
+static uint32_t msg_tail = 0;
+static intr_stats_t intr_stats;
+
+bool panda_usb_intr_post(const intr_msg_t *msg)
+{
+    if (ep_in == 0 || (uint32_t)(msg_head - msg_tail) >= INTR_QUEUE_SIZE) {
+        intr_stats.msgs_dropped++;
+        return false;
+    }
+    msg_queue[msg_head & INTR_QUEUE_MASK] = *msg;
+    msg_head++;
+    panda_usb_intr_task();
+    return true;
+}
+
+void panda_usb_intr_task(void)
+{
+    if (ep_in == 0 || msg_head == msg_tail) {
+        return;
+    }
+    if (!usbd_edpt_claim(intr_rhport, ep_in)) {
+        return; // previous packet still in flight; xfer_cb sends the rest
+    }
+    uint32_t n = 0;
+    while (n < INTR_MSGS_PER_PKT && msg_tail != msg_head) {
+        memcpy(&in_buf[n * sizeof(intr_msg_t)], &msg_queue[msg_tail & INTR_QUEUE_MASK], sizeof(intr_msg_t));
+        msg_tail++;
+        n++;
+    }
+    uint16_t nbytes = (uint16_t)(n * sizeof(intr_msg_t));
+    if (usbd_edpt_xfer(intr_rhport, ep_in, in_buf, nbytes)) {
+        intr_stats.tx_packets++;
+        intr_stats.msgs_sent += n;
+    } else {
+        usbd_edpt_release(intr_rhport, ep_in);
+        intr_stats.msgs_dropped += n;
+    }
+}
+
+void panda_usb_intr_get_stats(intr_stats_t *out)
+{
+    *out = intr_stats;
+}
+
+//--------------------------------------------------------------------+
+// Class driver callbacks
+//--------------------------------------------------------------------+
+
+static void intr_driver_init(void)
+{
+    memset(&intr_stats, 0, sizeof(intr_stats));
+}
+
+static void intr_driver_reset(uint8_t rhport)
+{
+    (void)rhport;
+    ep_out = 0;
+    ep_in = 0;
+    msg_head = 0;
+    msg_tail = 0;
+}
+
+static uint16_t intr_driver_open(uint8_t rhport, tusb_desc_interface_t const *desc_itf, uint16_t max_len)
+{
+    uint16_t const drv_len = (uint16_t)(sizeof(tusb_desc_interface_t) + 2u * sizeof(tusb_desc_endpoint_t));
+    TU_VERIFY(desc_itf->bInterfaceClass == TUSB_CLASS_VENDOR_SPECIFIC && desc_itf->bNumEndpoints == 2, 0);
+    TU_VERIFY(max_len >= drv_len, 0);
+
+    uint8_t const *p_desc = tu_desc_next(desc_itf);
+    TU_VERIFY(tu_desc_type(p_desc) == TUSB_DESC_ENDPOINT, 0);
+    TU_VERIFY(((tusb_desc_endpoint_t const *)p_desc)->bmAttributes.xfer == TUSB_XFER_INTERRUPT, 0);
+
+    TU_ASSERT(usbd_open_edpt_pair(rhport, p_desc, 2, TUSB_XFER_INTERRUPT, &ep_out, &ep_in), 0);
+    intr_rhport = rhport;
+    TU_ASSERT(usbd_edpt_xfer(rhport, ep_out, out_buf, sizeof(out_buf)), 0);
+    return drv_len;
+}
+
+static bool intr_driver_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request)
+{
+    (void)rhport;
+    (void)stage;
+    (void)request;
+    return false; // no class requests; vendor requests go to tud_vendor_control_xfer_cb
+}
+
+static bool intr_driver_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes)
+{
+    if (ep_addr == ep_out) {
+        if (result == XFER_RESULT_SUCCESS && xferred_bytes > 0) {
+            intr_stats.rx_packets++;
+            panda_usb_handle_intr_out(out_buf, (uint16_t)xferred_bytes);
+        }
+        TU_ASSERT(usbd_edpt_xfer(rhport, ep_out, out_buf, sizeof(out_buf)));
+    } else if (ep_addr == ep_in) {
+        panda_usb_intr_task();
+    }
+    return true;
+}
+
+static usbd_class_driver_t const intr_driver = {
+    .init = intr_driver_init,
+    .reset = intr_driver_reset,
+    .open = intr_driver_open,
+    .control_xfer_cb = intr_driver_control_xfer_cb,
+    .xfer_cb = intr_driver_xfer_cb,
+    .sof = NULL,
+};
+
+usbd_class_driver_t const *usbd_app_driver_get_cb(uint8_t *driver_count)
+{
+    *driver_count = 1;
+    return &intr_driver;
+}
@@ -0,0 +1,44 @@
+#ifndef PANDA_USB_INTR_H_
+#define PANDA_USB_INTR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Second vendor interface with an interrupt endpoint pair (bInterval 1 ms),
+// so overrides do not queue behind the bulk capture stream. Full-speed
+// interrupt transfers get reserved bus time; bulk only gets what is left.
+//
+//   OUT 0x04: same op encoding as the bulk OUT endpoint, but only the
+//             override/injector ops are accepted (0x90, 0x91, 0x9A, 0x9E, 0x9F)
+//   IN  0x84: up to four 16-byte intr_msg_t per packet
+
+#define INTR_MSG_OVERRIDE_ACK    0x01 // injector_ack_t: status = result, arg = target id, token = seq,
+                                      // aux = cycle_count | rule << 8
+#define INTR_MSG_PONG            0x02 // status = OUT path it came in on, token = host token
+
+#define INTR_PATH_BULK      0
+#define INTR_PATH_INTERRUPT 1
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t status;
+    uint16_t arg;
+    uint32_t token;
+    uint32_t timestamp_us;    // time_us_32() when the message was queued
+    uint32_t aux;
+} intr_msg_t;
+
+typedef struct {
+    uint32_t rx_packets;
+    uint32_t tx_packets;
+    uint32_t msgs_sent;
+    uint32_t msgs_dropped;    // queue full or endpoint not open
+} intr_stats_t;
+
+// Core0 only (TinyUSB task context). Returns false if the queue is full.
+bool panda_usb_intr_post(const intr_msg_t *msg);
+// Start an IN transfer if one is not in flight and messages are queued
+void panda_usb_intr_task(void);
+void panda_usb_intr_get_stats(intr_stats_t *out);
+
+#endif /* PANDA_USB_INTR_H_ */
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <limits.h>
+#include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/dma.h"
 #include "hardware/pio.h"
@@ -99,38 +100,189 @@ uint32_t replay_buffer[64] __attribute__((aligned(256))) = {
 };
 #endif
 
-void setup_replay(PIO pio, uint replay_pin)
-{
-    uint offset = pio_add_program(pio, &flexray_replay_q8_frame_program);
-    uint sm = pio_claim_unused_sm(pio, true);
-    flexray_replay_q8_frame_program_init(pio, sm, offset, replay_pin);
+#define REPLAY_IDLE_WORD 0xFFFFFFFFu
+#define REPLAY_RING_MASK (REPLAY_RING_WORDS - 1u)
+
+static PIO replay_pio;
+static uint replay_sm;
+static int replay_chan = -1;
 
-    uint dma_chan = dma_claim_unused_channel(true);
-    // uint dma_replay_rearm_chan = dma_claim_unused_channel(true);
-    dma_channel_config dma_c = dma_channel_get_default_config(dma_chan);
+static uint32_t replay_ring[REPLAY_RING_WORDS] __attribute__((aligned(REPLAY_RING_BYTES)));
+static uint32_t ring_write;       // next word the host fills
+static uint32_t checked_fill;     // fill and time of the last look at the DMA
+static uint32_t checked_us;
+static bool in_underrun;
+static bool below_low;
+static replay_stream_stats_t stream_stats;
+
+static void replay_dma_start(const uint32_t *buffer, uint32_t buffer_size_bytes)
+{
+    dma_channel_config dma_c = dma_channel_get_default_config((uint)replay_chan);
 
     channel_config_set_transfer_data_size(&dma_c, DMA_SIZE_32);
     channel_config_set_read_increment(&dma_c, true);
     channel_config_set_write_increment(&dma_c, false);
-    channel_config_set_dreq(&dma_c, pio_get_dreq(pio, sm, true));
+    channel_config_set_dreq(&dma_c, pio_get_dreq(replay_pio, replay_sm, true));
 
     // Keep circular read ring on the replay buffer
-    uint32_t buffer_words = (uint32_t)(sizeof(replay_buffer) / sizeof(uint32_t));
-    uint32_t buffer_size_bytes = sizeof(replay_buffer);
+    uint32_t buffer_words = buffer_size_bytes / sizeof(uint32_t);
     uint8_t ring_size_log2 = 0;
     if (buffer_size_bytes > 1) {
         ring_size_log2 = 32 - __builtin_clz(buffer_size_bytes - 1);
     }
     channel_config_set_ring(&dma_c, false, ring_size_log2); // false = wrap read address
-    // channel_config_set_chain_to(&dma_c, dma_replay_rearm_chan);
 
     buffer_words = buffer_words | 0x10000000; // rp2350's self trigger
     dma_channel_configure(
-        dma_chan,
+        (uint)replay_chan,
         &dma_c,
-        &pio->txf[sm],          // Write address: PIO TX FIFO
-        replay_buffer,          // Read address: start of our data
+        &replay_pio->txf[replay_sm], // Write address: PIO TX FIFO
+        buffer,                 // Read address: start of our data
         buffer_words,           // Transfer count: one full buffer
         true                    // Start immediately
     );
 }
+
+void setup_replay(PIO pio, uint replay_pin)
+{
+    uint offset = pio_add_program(pio, &flexray_replay_q8_frame_program);
+    uint sm = pio_claim_unused_sm(pio, true);
+    flexray_replay_q8_frame_program_init(pio, sm, offset, replay_pin);
+
+    replay_pio = pio;
+    replay_sm = sm;
+    replay_chan = (int)dma_claim_unused_channel(true);
+    replay_dma_start(replay_buffer, sizeof(replay_buffer));
+}
+
+static inline uint32_t ring_fill(void)
+{
+    uint32_t read = (dma_channel_hw_addr((uint)replay_chan)->read_addr - (uint32_t)(uintptr_t)replay_ring) / 4u;
+    return (ring_write - read) & REPLAY_RING_MASK;
+}
+
+static inline void note_fill(uint32_t fill)
+{
+    checked_fill = fill;
+    checked_us = time_us_32();
+}
+
+static uint32_t ring_put_idle(uint32_t fill, uint32_t n)
+{
+    uint32_t room = REPLAY_RING_MASK - fill;
+    if (n > room) n = room;
+    for (uint32_t i = 0; i < n; i++) {
+        replay_ring[(ring_write + i) & REPLAY_RING_MASK] = REPLAY_IDLE_WORD;
+    }
+    ring_write = (ring_write + n) & REPLAY_RING_MASK;
+    return n;
+}
+
+bool replay_stream_enable(bool enable)
+{
+    if (replay_chan < 0) {
+        return false;
+    }
+    dma_channel_abort((uint)replay_chan);
+    if (!enable) {
+        stream_stats.streaming = 0;
+        replay_dma_start(replay_buffer, sizeof(replay_buffer));
+        return true;
+    }
+    for (uint32_t i = 0; i < REPLAY_RING_WORDS; i++) {
+        replay_ring[i] = REPLAY_IDLE_WORD;
+    }
+    memset(&stream_stats, 0, sizeof(stream_stats));
+    stream_stats.streaming = 1;
+    in_underrun = false;
+    below_low = false;
+    // Host words go in behind one guard of idle
+    ring_write = REPLAY_GUARD_WORDS;
+    replay_dma_start(replay_ring, REPLAY_RING_BYTES);
+    note_fill(REPLAY_GUARD_WORDS);
+    return true;
+}
+
+uint16_t replay_stream_write(const uint8_t *words, uint16_t n)
+{
+    uint16_t queued = 0;
+    if (stream_stats.streaming) {
+        uint32_t fill = ring_fill();
+        uint32_t room = REPLAY_RING_MASK - fill;
+        queued = n > room ? (uint16_t)room : n;
+        for (uint16_t i = 0; i < queued; i++) {
+            const uint8_t *w = &words[i * 4u];
+            replay_ring[(ring_write + i) & REPLAY_RING_MASK] =
+                (uint32_t)w[0] | ((uint32_t)w[1] << 8) | ((uint32_t)w[2] << 16) | ((uint32_t)w[3] << 24);
+        }
+        ring_write = (ring_write + queued) & REPLAY_RING_MASK;
+        note_fill(fill + queued);
+        in_underrun = false;
+    }
+    stream_stats.received_words += queued;
+    stream_stats.overflow_words += (uint32_t)(n - queued);
+    return queued;
+}
+
+uint32_t replay_stream_idle(uint32_t n)
+{
+    uint32_t queued = 0;
+    if (stream_stats.streaming) {
+        uint32_t fill = ring_fill();
+        queued = ring_put_idle(fill, n);
+        note_fill(fill + queued);
+        in_underrun = false;
+    }
+    stream_stats.received_words += queued;
+    stream_stats.overflow_words += n - queued;
+    return queued;
+}
+
+void replay_stream_task(void)
+{
+    if (!stream_stats.streaming) {
+        return;
+    }
+    // The SM takes one bit per 100 ns: 5 words every 16 us
+    uint32_t consumed = (uint32_t)(((uint64_t)(time_us_32() - checked_us) * 5u) / 16u);
+    uint32_t fill;
+    if (consumed >= checked_fill) {
+        // The DMA may have run past ring_write: restart the queue at its position
+        stream_stats.stalls++;
+        ring_write = (ring_write - ring_fill()) & REPLAY_RING_MASK;
+        fill = 0;
+    } else {
+        fill = ring_fill();
+    }
+    if (fill < REPLAY_LOW_WATERMARK) {
+        if (!below_low) {
+            stream_stats.low_events++;
+        }
+        below_low = true;
+    } else {
+        below_low = false;
+    }
+    if (fill < REPLAY_GUARD_WORDS) {
+        uint32_t n = ring_put_idle(fill, REPLAY_GUARD_WORDS - fill);
+        stream_stats.underrun_words += n;
+        if (!in_underrun) {
+            stream_stats.underruns++;
+        }
+        in_underrun = true;
+        fill += n;
+    }
+    note_fill(fill);
+}
+
+uint16_t replay_stream_read(uint8_t *out, uint16_t cap)
+{
+    if (cap < sizeof(stream_stats)) {
+        return 0;
+    }
+    stream_stats.ring_words = REPLAY_RING_WORDS;
+    stream_stats.low_watermark = REPLAY_LOW_WATERMARK;
+    stream_stats.high_watermark = REPLAY_HIGH_WATERMARK;
+    stream_stats.fill_words = stream_stats.streaming ? ring_fill() : 0u;
+    memcpy(out, &stream_stats, sizeof(stream_stats));
+    return (uint16_t)sizeof(stream_stats);
+}
@@ -17,4 +17,45 @@ extern uint32_t replay_buffer[64];
  */
 void setup_replay(PIO pio, uint replay_pin);
 
+// Host-streamed replay. In stream mode the replay SM is fed from a 32 KB DMA
+// read ring (about 26 ms of wire time) that the host fills over bulk OUT
+// with wire-encoded words (op 0xA4) and idle runs (op 0xA5). The PIO clock
+// sets the timing, so gaps recorded in the stream are replayed as they were.
+// replay_stream_task keeps REPLAY_GUARD_WORDS queued ahead of the DMA: when
+// the host falls behind it appends idle, counted as underrun, so old ring
+// contents are never sent. The host keeps the fill between the watermarks
+// by reading FLEXRAY_READ_REPLAY (replay_stream_stats_t).
+//
+// Op 0xA6 enters (1) or leaves (0) stream mode; leaving restores the
+// replay_buffer loop. Everything here runs on core0.
+
+#define REPLAY_RING_BYTES (1u << 15)   // DMA ring wrap limit
+#define REPLAY_RING_WORDS (REPLAY_RING_BYTES / 4u)
+#define REPLAY_GUARD_WORDS 1024u       // about 3.3 ms
+#define REPLAY_LOW_WATERMARK (REPLAY_RING_WORDS / 4u)
+#define REPLAY_HIGH_WATERMARK (REPLAY_RING_WORDS * 3u / 4u)
+
+typedef struct __attribute__((packed)) {
+    uint8_t streaming;
+    uint8_t reserved[3];
+    uint32_t ring_words;
+    uint32_t low_watermark;
+    uint32_t high_watermark;
+    uint32_t fill_words;          // queued ahead of the DMA
+    uint32_t received_words;      // host words queued, idle runs included
+    uint32_t overflow_words;      // host words dropped: ring full or not streaming
+    uint32_t underrun_words;      // idle appended because the host fell behind
+    uint32_t underruns;           // ...separate episodes
+    uint32_t low_events;          // fill fell below the low watermark
+    uint32_t stalls;              // task ran too late: the DMA may have replayed old words
+} replay_stream_stats_t;
+
+bool replay_stream_enable(bool enable);
+// n little-endian wire words; returns how many were queued
+uint16_t replay_stream_write(const uint8_t *words, uint16_t n);
+uint32_t replay_stream_idle(uint32_t n);
+// Main loop: guard refill and watermark accounting
+void replay_stream_task(void);
+uint16_t replay_stream_read(uint8_t *out, uint16_t cap);
+
 #endif // REPLAY_FRAME_H
\ No newline at end of file
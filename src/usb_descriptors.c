@@ -8,16 +8,26 @@
 
 #define PICO_FLEXRAY_DONGLE_ID_PREFIX "picoflex"
 
-#define TUSB_DESC_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_VENDOR_DESC_LEN)
+// Vendor interface with an interrupt OUT/IN pair (claimed by panda_usb_intr.c)
+#define TUD_VENDOR_INTR_DESC_LEN (9 + 7 + 7)
+#define TUD_VENDOR_INTR_DESCRIPTOR(_itfnum, _stridx, _epout, _epin, _epsize, _interval) \
+    9, TUSB_DESC_INTERFACE, _itfnum, 0, 2, TUSB_CLASS_VENDOR_SPECIFIC, 0x00, 0x00, _stridx, \
+    7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(_epsize), _interval, \
+    7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(_epsize), _interval
+
+#define TUSB_DESC_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_VENDOR_DESC_LEN + TUD_VENDOR_INTR_DESC_LEN)
 
 enum {
     ITF_NUM_VENDOR,
+    ITF_NUM_OVERRIDE,
     ITF_NUM_TOTAL
 };
 
 enum {
     EPNUM_VENDOR_OUT = 0x03,  // Bulk OUT endpoint for CAN data from host to device
-    EPNUM_VENDOR_IN = 0x81    // Bulk IN endpoint for CAN data from device to host
+    EPNUM_VENDOR_IN = 0x81,   // Bulk IN endpoint for CAN data from device to host
+    EPNUM_OVERRIDE_OUT = 0x04, // Interrupt OUT endpoint for overrides
+    EPNUM_OVERRIDE_IN = 0x84   // Interrupt IN endpoint for acknowledgements
 };
 
 //--------------------------------------------------------------------+
@@ -48,7 +58,10 @@ uint8_t const desc_cfg[] = {
     TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, TUSB_DESC_TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
 
     // Interface number, string index, EP Out & In address, EP size
-    TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 4, EPNUM_VENDOR_OUT, EPNUM_VENDOR_IN, 64)
+    TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 4, EPNUM_VENDOR_OUT, EPNUM_VENDOR_IN, 64),
+
+    // Interface number, string index, EP Out & In address, EP size, polling interval in ms
+    TUD_VENDOR_INTR_DESCRIPTOR(ITF_NUM_OVERRIDE, 5, EPNUM_OVERRIDE_OUT, EPNUM_OVERRIDE_IN, 64, 1)
 };
 
 //--------------------------------------------------------------------+
@@ -60,6 +73,7 @@ enum {
     STRID_PRODUCT,
     STRID_SERIAL,
     STRID_INTERFACE,
+    STRID_OVERRIDE_INTERFACE,
 };
 
 char const* string_desc_arr[] = {
@@ -67,7 +81,8 @@ char const* string_desc_arr[] = {
     "comma.ai",              // 1: Manufacturer
     "panda",                 // 2: Product
     NULL,                    // 3: Serial, will be filled from board ID
-    "Panda Interface"        // 4: Interface
+    "Panda Interface",       // 4: Interface
+    "Override Interface"     // 5: Interrupt override interface
 };
 
 static uint16_t _desc_str[32];
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+Benchmark the bulk-stream record encodings on a recorded log.
+
+Replays a CSV written by flexray_stream_recorder.py through a reference model of
+the device encoder (src/flexray_stream_codec.c) in every stream mode, decodes
+the result with the recorder's parser to check it round-trips, and prints the
+bytes on the wire per mode.
+
+Device CPU cost is measured on the target instead: build with
+-DFLEXRAY_PROFILE=ON, select the mode, and read the stream_codec_encode probe
+with flexray_profile_reader.py.
+
+Usage:
+  python3 stream_codec_bench.py flexray_log_20250101_120000.csv
+  python3 stream_codec_bench.py log.csv --keyframe 32 --mux 0x07
+"""
+import argparse
+import csv
+import struct
+import sys
+import time
+
+from flexray_stream_recorder import parse_varlen_records
+
+MODE_FULL = 0
+MODE_CHANGES_ONLY = 1
+MODE_DELTA = 2
+MODE_NAMES = {MODE_FULL: "full", MODE_CHANGES_ONLY: "changes-only", MODE_DELTA: "delta"}
+
+# Must match flexray_stream_codec.h
+DELTA_MAX_PAYLOAD = 64
+DELTA_REF_COUNT = 512
+
+
+def load_csv(path):
+    frames = []
+    with open(path, newline='', encoding='utf-8') as f:
+        for row in csv.DictReader(f):
+            frames.append({
+                'source': int(row['source']),
+                'indicators': int(row['indicators'], 2),
+                'frame_id': int(row['frame_id']),
+                'payload_length_words': int(row['payload_length_words']),
+                'header_crc': int(row['header_crc'], 16),
+                'cycle_count': int(row['cycle_count']),
+                'payload': bytes.fromhex(row['payload']),
+                'frame_crc': int(row['frame_crc'], 16),
+            })
+    return frames
+
+
+def crc_bytes(frame):
+    c = frame['frame_crc']
+    return bytes([(c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF])
+
+
+def encode_full(frame):
+    fid = frame['frame_id']
+    hcrc = frame['header_crc']
+    words = frame['payload_length_words']
+    header = bytes([
+        ((frame['indicators'] << 3) | ((fid >> 8) & 0x07)) & 0xFF,
+        fid & 0xFF,
+        ((words << 1) | ((hcrc >> 10) & 0x01)) & 0xFF,
+        (hcrc >> 2) & 0xFF,
+        (((hcrc & 0x03) << 6) | (frame['cycle_count'] & 0x3F)) & 0xFF,
+    ])
+    body = bytes([frame['source']]) + header + frame['payload'][:words * 2] + crc_bytes(frame)
+    return struct.pack('<H', len(body)) + body
+
+
+def encode_ref_record(kind, frame, ref_cycle, tail=b''):
+    fid = frame['frame_id']
+    body = bytes([(kind << 6) | (frame['source'] & 0x3F), fid & 0xFF, (fid >> 8) & 0x07,
+                  frame['cycle_count'] & 0x3F, ref_cycle]) + crc_bytes(frame) + tail
+    return struct.pack('<H', len(body)) + body
+
+
+def encode_delta_tail(payload, ref):
+    mask = bytearray((len(payload) + 7) // 8)
+    data = bytearray()
+    for i, (a, b) in enumerate(zip(payload, ref)):
+        if a != b:
+            mask[i >> 3] |= 1 << (i & 7)
+            data.append(a ^ b)
+    return bytes(mask) + bytes(data)
+
+
+class ReferenceEncoder:
+    """Python model of stream_codec_encode/commit (minus the table probe limit)."""
+
+    def __init__(self, mode, keyframe_interval, mux_mask, emit_unchanged=True):
+        self.mode = mode
+        self.keyframe_interval = keyframe_interval
+        self.mux_mask = mux_mask & 0x3F
+        self.emit_unchanged = emit_unchanged
+        self.slots = {}
+        self.refs_used = 0
+        self.kinds = {'full': 0, 'keyframe': 0, 'unchanged': 0, 'suppressed': 0, 'delta': 0}
+
+    def encode(self, frame):
+        if self.mode == MODE_FULL:
+            self.kinds['full'] += 1
+            return encode_full(frame)
+
+        key = (frame['source'], frame['frame_id'], frame['cycle_count'] & self.mux_mask)
+        s = self.slots.get(key)
+        payload = frame['payload']
+        content = (frame['indicators'], frame['payload_length_words'], payload)
+        known = s is not None and s['content'] == content
+        keyframe_due = (self.keyframe_interval != 0 and s is not None
+                        and s['since_full'] + 1 >= self.keyframe_interval)
+
+        if keyframe_due or s is None or not known:
+            full = encode_full(frame)
+            record = full
+            kind = 'keyframe' if (keyframe_due and known) else 'full'
+            if (not keyframe_due and s is not None and self.mode == MODE_DELTA and s['has_ref']
+                    and s['content'][0] == frame['indicators']
+                    and s['content'][1] == frame['payload_length_words']):
+                delta = encode_ref_record(2, frame, s['ref_cycle'], encode_delta_tail(payload, s['content'][2]))
+                if len(delta) < len(full):
+                    record = delta
+                    kind = 'delta'
+            self._commit(key, s, frame, content, kind)
+            self.kinds[kind] += 1
+            return record
+
+        s['since_full'] += 1
+        if not self.emit_unchanged:
+            self.kinds['suppressed'] += 1
+            return b''
+        self.kinds['unchanged'] += 1
+        return encode_ref_record(1, frame, s['ref_cycle'])
+
+    def _commit(self, key, s, frame, content, kind):
+        if s is None:
+            s = {'since_full': 0, 'has_ref': False, 'ref_alloc': False}
+            self.slots[key] = s
+        s['content'] = content
+        s['ref_cycle'] = frame['cycle_count'] & 0x3F
+        s['since_full'] = s['since_full'] + 1 if kind == 'delta' else 0
+        s['has_ref'] = False
+        if self.mode == MODE_DELTA and len(frame['payload']) <= DELTA_MAX_PAYLOAD:
+            if not s['ref_alloc'] and self.refs_used < DELTA_REF_COUNT:
+                s['ref_alloc'] = True
+                self.refs_used += 1
+            s['has_ref'] = s['ref_alloc']
+
+
+def run_mode(frames, mode, keyframe_interval, mux_mask):
+    enc = ReferenceEncoder(mode, keyframe_interval, mux_mask)
+    t0 = time.perf_counter()
+    stream = b''.join(enc.encode(f) for f in frames)
+    elapsed = time.perf_counter() - t0
+
+    decoded = []
+    consumed = parse_varlen_records(stream, decoded, {})
+    ok = consumed == len(stream) and len(decoded) == len(frames)
+    if ok:
+        for a, b in zip(frames, decoded):
+            if (a['frame_id'], a['cycle_count'], a['payload'], a['frame_crc']) != \
+               (b['frame_id'], b['cycle_count'], b['payload'], b['frame_crc']):
+                ok = False
+                break
+    return len(stream), enc.kinds, ok, elapsed
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Stream codec compression benchmark")
+    parser.add_argument("csv", nargs="+", help="logs recorded with flexray_stream_recorder.py")
+    parser.add_argument("--keyframe", type=lambda x: int(x, 0), default=64, help="keyframe interval (default 64)")
+    parser.add_argument("--mux", type=lambda x: int(x, 0), default=0x03, help="cycle mux mask (default 0x03)")
+    args = parser.parse_args()
+
+    for path in args.csv:
+        frames = load_csv(path)
+        if not frames:
+            print(f"{path}: no frames")
+            continue
+        print(f"{path}: {len(frames)} frames, keyframe={args.keyframe}, mux=0x{args.mux:02x}")
+        baseline = None
+        for mode in (MODE_FULL, MODE_CHANGES_ONLY, MODE_DELTA):
+            nbytes, kinds, ok, elapsed = run_mode(frames, mode, args.keyframe, args.mux)
+            if baseline is None:
+                baseline = nbytes
+            ratio = baseline / nbytes if nbytes else float('inf')
+            kind_str = " ".join(f"{k}={v}" for k, v in kinds.items() if v)
+            print(f"  {MODE_NAMES[mode]:<13} {nbytes:>12} B  {nbytes / len(frames):7.2f} B/frame  "
+                  f"x{ratio:5.2f}  roundtrip={'ok' if ok else 'FAIL'}  host={elapsed * 1e6 / len(frames):.2f} us/frame")
+            print(f"  {'':<13} {kind_str}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())